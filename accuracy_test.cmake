@@ -0,0 +1,71 @@
+# Teste de precisão da versão em float (PROJETO_AUDIO_SINGLE_PRECISION), rodado
+# pelo ctest: as mesmas operações nos dois executáveis, saídas gravadas em
+# float de 32 bits (sem a quantização de 16 bits esconder o erro) e comparadas
+# com o comando compare. Falha se alguma SNR ficar abaixo de MIN_SNR dB.
+#
+# cmake -DDOUBLE_BIN=... -DSINGLE_BIN=... -DWORK_DIR=... -DMIN_SNR=... -P accuracy_test.cmake
+
+foreach(var DOUBLE_BIN SINGLE_BIN WORK_DIR MIN_SNR)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "Defina ${var} (-D${var}=...).")
+    endif()
+endforeach()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+# Roda um comando em WORK_DIR (onde os comandos também gravam os dados dos
+# gráficos) e aborta o teste se ele falhar.
+function(run_checked)
+    execute_process(COMMAND ${ARGN}
+            WORKING_DIRECTORY "${WORK_DIR}"
+            RESULT_VARIABLE result
+            OUTPUT_VARIABLE output
+            ERROR_VARIABLE output)
+    if(NOT result EQUAL 0)
+        string(REPLACE ";" " " command "${ARGN}")
+        message(FATAL_ERROR "Falhou (${result}): ${command}\n${output}")
+    endif()
+    set(last_output "${output}" PARENT_SCOPE)
+endfunction()
+
+# Entradas geradas pela versão em double; em float de 32 bits, são lidas
+# exatamente iguais pelas duas versões.
+run_checked("${DOUBLE_BIN}" generate pink 3 pink.wav --bits float)
+run_checked("${DOUBLE_BIN}" generate chirp 3 chirp.wav --rate 44100 --bits float)
+run_checked("${DOUBLE_BIN}" generate white 0.05 ir.wav --bits float)
+
+set(failures 0)
+
+# check_accuracy(<nome> <argumentos...>): roda '<bin> <argumentos> <saída>' com
+# os dois executáveis e compara a saída da versão em float com a em double.
+function(check_accuracy name)
+    run_checked("${DOUBLE_BIN}" ${ARGN} ${name}_double.wav --bits float)
+    run_checked("${SINGLE_BIN}" ${ARGN} ${name}_float.wav --bits float)
+    run_checked("${DOUBLE_BIN}" compare ${name}_double.wav ${name}_float.wav)
+    if(NOT last_output MATCHES "SNR: +([-0-9.]+|inf) dB")
+        message(FATAL_ERROR "${name}: SNR não encontrada na saída do compare:\n${last_output}")
+    endif()
+    set(snr "${CMAKE_MATCH_1}")
+    if(snr STREQUAL "inf" OR NOT snr LESS MIN_SNR)
+        message(STATUS "${name}: SNR ${snr} dB")
+    else()
+        message(STATUS "${name}: SNR ${snr} dB, abaixo do mínimo de ${MIN_SNR} dB")
+        math(EXPR count "${failures} + 1")
+        set(failures ${count} PARENT_SCOPE)
+    endif()
+endfunction()
+
+check_accuracy(fft filter-fft low 2000 pink.wav)
+check_accuracy(fft_stream --stream filter-fft high 500 pink.wav)
+check_accuracy(sma filter-sma 16 pink.wav)
+check_accuracy(fir filter-fir band 300:3000 255 pink.wav)
+check_accuracy(iir filter-iir low 1000 4 pink.wav)
+check_accuracy(resample resample 44100 pink.wav)
+check_accuracy(convolve convolve pink.wav ir.wav)
+# A segunda entrada, a 44.1 kHz, passa pela conversão de taxa do mixer.
+check_accuracy(mix mix pink.wav:-3 chirp.wav:-6:0.5 -o)
+
+if(failures GREATER 0)
+    message(FATAL_ERROR "${failures} operação(ões) abaixo de ${MIN_SNR} dB de SNR.")
+endif()
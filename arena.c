@@ -0,0 +1,134 @@
+#include "arena.h"
+#include "trace.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Alinhamento de cada alocação: uma linha de cache, suficiente para AVX-512.
+#define ARENA_ALIGNMENT 64
+// Tamanho mínimo de um bloco novo.
+#define ARENA_MIN_BLOCK ((size_t)1 << 20)
+
+// Os blocos formam uma lista; 'current' é o último em uso. Blocos depois dele
+// ficam guardados para as próximas alocações.
+typedef struct ArenaBlock {
+    struct ArenaBlock* prev;
+    struct ArenaBlock* next;
+    size_t capacity;
+    size_t used;
+    unsigned char* data;
+} ArenaBlock;
+
+static __thread ArenaBlock* arena_first = NULL;
+static __thread ArenaBlock* arena_current = NULL;
+
+// Libera a arena de cada thread quando ela termina.
+static pthread_key_t arena_key;
+static pthread_once_t arena_key_once = PTHREAD_ONCE_INIT;
+
+static void free_blocks(ArenaBlock* block) {
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block->data);
+        free(block);
+        block = next;
+    }
+}
+
+static void arena_thread_exit(void* value) {
+    (void)value;
+    free_blocks(arena_first);
+    arena_first = NULL;
+    arena_current = NULL;
+}
+
+static void create_arena_key(void) {
+    pthread_key_create(&arena_key, arena_thread_exit);
+}
+
+static ArenaBlock* new_block(size_t capacity, ArenaBlock* prev) {
+    ArenaBlock* block = (ArenaBlock*)calloc(1, sizeof(ArenaBlock));
+    if (!block) return NULL;
+    if (posix_memalign((void**)&block->data, ARENA_ALIGNMENT, capacity) != 0) {
+        free(block);
+        return NULL;
+    }
+    TRACE_ALLOC(capacity);
+    block->capacity = capacity;
+    block->prev = prev;
+    if (prev) {
+        prev->next = block;
+    } else {
+        arena_first = block;
+        pthread_once(&arena_key_once, create_arena_key);
+        pthread_setspecific(arena_key, block);
+    }
+    return block;
+}
+
+static size_t align_up(size_t value) {
+    return (value + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+ArenaMark arena_mark(void) {
+    ArenaMark mark = { arena_current, arena_current ? arena_current->used : 0 };
+    return mark;
+}
+
+void* arena_alloc(size_t bytes) {
+    bytes = align_up(bytes);
+
+    ArenaBlock* block = arena_current;
+    if (block && block->capacity - block->used >= bytes) {
+        void* ptr = block->data + block->used;
+        block->used += bytes;
+        return ptr;
+    }
+
+    // Tenta o próximo bloco guardado; se não couber, descarta os guardados e
+    // cria um maior, que tende a absorver sozinho o pico de uso da thread.
+    ArenaBlock* next = block ? block->next : arena_first;
+    if (!next || next->capacity < bytes) {
+        size_t total = 0;
+        for (ArenaBlock* b = arena_first; b; b = b->next) {
+            total += b->capacity;
+        }
+        size_t capacity = (bytes > total) ? bytes : total;
+        if (capacity < ARENA_MIN_BLOCK) capacity = ARENA_MIN_BLOCK;
+
+        free_blocks(next);
+        if (block) {
+            block->next = NULL;
+        } else {
+            arena_first = NULL;
+        }
+        next = new_block(capacity, block);
+        if (!next) return NULL;
+    }
+
+    next->used = bytes;
+    arena_current = next;
+    return next->data;
+}
+
+void arena_release(ArenaMark mark) {
+    ArenaBlock* block = (ArenaBlock*)mark.block;
+    if (block) {
+        block->used = mark.used;
+        arena_current = block;
+        return;
+    }
+
+    // Arena vazia de novo: se o pico usou vários blocos, troca-os por um só
+    // do tamanho total, para que o mesmo padrão de uso caiba em um bloco.
+    arena_current = NULL;
+    if (arena_first && arena_first->next) {
+        size_t total = 0;
+        for (ArenaBlock* b = arena_first; b; b = b->next) {
+            total += b->capacity;
+        }
+        free_blocks(arena_first);
+        arena_first = NULL;
+        new_block(total, NULL);
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef PROJETO_AUDIO_ARENA_H
+#define PROJETO_AUDIO_ARENA_H
+
+#include <stddef.h>
+
+// Arena de memória temporária, uma por thread. A FFT e as operações de DSP
+// tiram dela seus buffers de trabalho em vez de chamar malloc/free a cada uso:
+// a memória continua com a thread e é reaproveitada pelas chamadas seguintes,
+// sem custo de alocação nem page faults para buffers de tamanhos já vistos.
+//
+// As alocações seguem uma disciplina de pilha:
+//     ArenaMark mark = arena_mark();
+//     double* tmp = (double*)arena_alloc(n * sizeof(double));
+//     ...
+//     arena_release(mark);   // libera tudo o que foi alocado depois da marca
+
+typedef struct {
+    void* block;
+    size_t used;
+} ArenaMark;
+
+// Posição atual da arena da thread que chama.
+ArenaMark arena_mark(void);
+// Bloco de 'bytes' alinhado em 64 bytes, válido até arena_release de uma marca
+// anterior. O conteúdo não é inicializado. Retorna NULL se faltar memória.
+void* arena_alloc(size_t bytes);
+// Devolve à arena tudo o que foi alocado depois de 'mark'.
+void arena_release(ArenaMark mark);
+
+#endif //PROJETO_AUDIO_ARENA_H
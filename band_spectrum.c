@@ -0,0 +1,363 @@
+#include "band_spectrum.h"
+#include "thread_pool.h"
+#include "arena.h"
+#include "trace.h"
+#include <pthread.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Amostras por bloco no Goertzel: longo o bastante para diluir a rotação de
+// fase de cada bloco, curto o bastante para o erro da recorrência não crescer.
+#define GOERTZEL_BLOCK 65536
+// Menor bloco na chirp-z: com poucos bins, as FFTs continuam rendendo bastante
+// amostras novas cada uma.
+#define CZT_MIN_BLOCK 8192
+// Frequências que avançam juntas no Goertzel (estados em registradores/cache L1).
+#define GOERTZEL_GROUP 32
+
+typedef struct {
+    const WavMap* map;
+    uint16_t num_channels;
+    size_t num_samples;
+    size_t num_bins;
+    size_t block;             // Amostras por bloco
+
+    // Goertzel: frequências em ciclos por amostra (f / fs)
+    const double* cycles;
+
+    // Chirp-z: f_k / fs = start_cycles + k * step_cycles
+    double start_cycles;
+    double step_cycles;
+    size_t fft_size;          // >= block + num_bins - 1
+    Complex* chirp_in;        // 'block' valores: e^(-j 2 pi (f0 n + d n^2 / 2))
+    Complex* kernel;          // FFT da chirp e^(+j pi d m^2), m em [-(block - 1), num_bins - 1]
+    Complex* chirp_out;       // 'num_bins' valores: e^(-j pi d k^2)
+
+    double* acc;              // Soma de todos os blocos: real e imag por bin, canal c em + 2 * c * num_bins
+    pthread_mutex_t lock;
+    int failed;
+} BandPass;
+
+// e^(-j 2 pi cycles). A parte inteira é descartada antes do seno e do cosseno:
+// as fases dos últimos blocos de um arquivo longo passam de 10^8 ciclos.
+static void unit_phasor(double cycles, double* re, double* im) {
+    double angle = 2.0 * M_PI * (cycles - floor(cycles));
+    *re = cos(angle);
+    *im = -sin(angle);
+}
+
+// Soma as contribuições locais de uma thread ao total.
+static void merge_acc(BandPass* pass, const double* acc) {
+    size_t count = 2 * pass->num_bins * pass->num_channels;
+    pthread_mutex_lock(&pass->lock);
+    for (size_t i = 0; i < count; i++) {
+        pass->acc[i] += acc[i];
+    }
+    pthread_mutex_unlock(&pass->lock);
+}
+
+// Goertzel em lote: cada frequência tem sua recorrência s[n] = x[n] + 2 cos(w) s[n-1] - s[n-2],
+// e as de um grupo avançam juntas, amostra a amostra (o laço interno, sobre as
+// frequências, vetoriza). No fim do bloco, X_bloco(w) = e^(-jw(n-1)) (s[n-1] - e^(-jw) s[n-2]).
+static void goertzel_group(const real_t* x, size_t n, const double* cycles, size_t count,
+                           size_t start, double* out) {
+    double coef[GOERTZEL_GROUP], cos_w[GOERTZEL_GROUP], sin_w[GOERTZEL_GROUP];
+    double s1[GOERTZEL_GROUP] = { 0.0 }, s2[GOERTZEL_GROUP] = { 0.0 };
+    for (size_t k = 0; k < count; k++) {
+        double w = 2.0 * M_PI * cycles[k];
+        cos_w[k] = cos(w);
+        sin_w[k] = sin(w);
+        coef[k] = 2.0 * cos_w[k];
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        double v = x[i];
+        for (size_t k = 0; k < count; k++) {
+            double s0 = v + coef[k] * s1[k] - s2[k];
+            s2[k] = s1[k];
+            s1[k] = s0;
+        }
+    }
+
+    for (size_t k = 0; k < count; k++) {
+        double y_re = s1[k] - cos_w[k] * s2[k];
+        double y_im = sin_w[k] * s2[k];
+        // A amostra n - 1 do bloco é a start + n - 1 do arquivo.
+        double rot_re, rot_im;
+        unit_phasor(cycles[k] * (double)(start + n - 1), &rot_re, &rot_im);
+        out[2 * k] += y_re * rot_re - y_im * rot_im;
+        out[2 * k + 1] += y_re * rot_im + y_im * rot_re;
+    }
+}
+
+static void goertzel_blocks(size_t begin, size_t end, void* ctx) {
+    BandPass* pass = (BandPass*)ctx;
+    const size_t num_bins = pass->num_bins;
+    ArenaMark mark = arena_mark();
+    double* acc = (double*)arena_alloc(2 * num_bins * pass->num_channels * sizeof(double));
+    if (!acc) {
+        pass->failed = 1;
+        arena_release(mark);
+        return;
+    }
+    memset(acc, 0, 2 * num_bins * pass->num_channels * sizeof(double));
+
+    for (size_t blk = begin; blk < end; blk++) {
+        size_t start = blk * pass->block;
+        WavData* block = wav_map_load(pass->map, start, pass->block);
+        if (!block) {
+            pass->failed = 1;
+            continue;
+        }
+        for (uint16_t c = 0; c < pass->num_channels; c++) {
+            double* out = acc + 2 * (size_t)c * num_bins;
+            // O bloco fica no cache enquanto passa por todos os grupos.
+            for (size_t first = 0; first < num_bins; first += GOERTZEL_GROUP) {
+                size_t count = (num_bins - first < GOERTZEL_GROUP) ? num_bins - first : GOERTZEL_GROUP;
+                goertzel_group(wav_channel(block, c), block->num_samples, pass->cycles + first, count,
+                               start, out + 2 * first);
+            }
+        }
+        free_wav_data(block);
+    }
+
+    merge_acc(pass, acc);
+    arena_release(mark);
+}
+
+// Chirp-z de um bloco: com kn = (k^2 + n^2 - (k - n)^2) / 2, a soma
+// X_k = sum_n x[n] e^(-j 2 pi (f0 + k d) n) vira a convolução de
+// x[n] e^(-j 2 pi (f0 n + d n^2 / 2)) com a chirp e^(+j pi d m^2), multiplicada
+// por e^(-j pi d k^2). A convolução circular de fft_size pontos basta, pois
+// fft_size >= block + num_bins - 1.
+static void chirp_z_blocks(size_t begin, size_t end, void* ctx) {
+    BandPass* pass = (BandPass*)ctx;
+    const size_t num_bins = pass->num_bins;
+    const size_t fft_size = pass->fft_size;
+
+    ArenaMark mark = arena_mark();
+    Complex* buffer = (Complex*)arena_alloc(fft_size * sizeof(Complex));
+    double* acc = (double*)arena_alloc(2 * num_bins * pass->num_channels * sizeof(double));
+    if (!buffer || !acc) {
+        pass->failed = 1;
+        arena_release(mark);
+        return;
+    }
+    memset(acc, 0, 2 * num_bins * pass->num_channels * sizeof(double));
+
+    for (size_t blk = begin; blk < end; blk++) {
+        size_t start = blk * pass->block;
+        WavData* block = wav_map_load(pass->map, start, pass->block);
+        if (!block) {
+            pass->failed = 1;
+            continue;
+        }
+        size_t n = block->num_samples;
+        // Deslocamento do bloco: e^(-j 2 pi f_k start), de bin em bin por uma recorrência.
+        double first_re, first_im, step_re, step_im;
+        unit_phasor(pass->start_cycles * (double)start, &first_re, &first_im);
+        unit_phasor(pass->step_cycles * (double)start, &step_re, &step_im);
+
+        for (uint16_t c = 0; c < pass->num_channels; c++) {
+            const real_t* x = wav_channel(block, c);
+            for (size_t i = 0; i < n; i++) {
+                buffer[i].real = x[i] * pass->chirp_in[i].real;
+                buffer[i].imag = x[i] * pass->chirp_in[i].imag;
+            }
+            memset(buffer + n, 0, (fft_size - n) * sizeof(Complex));
+
+            if (fft(buffer, fft_size) != 0) {
+                pass->failed = 1;
+                break;
+            }
+            for (size_t m = 0; m < fft_size; m++) {
+                real_t re = buffer[m].real * pass->kernel[m].real - buffer[m].imag * pass->kernel[m].imag;
+                real_t im = buffer[m].real * pass->kernel[m].imag + buffer[m].imag * pass->kernel[m].real;
+                buffer[m].real = re;
+                buffer[m].imag = im;
+            }
+            if (ifft(buffer, fft_size) != 0) {
+                pass->failed = 1;
+                break;
+            }
+
+            double* out = acc + 2 * (size_t)c * num_bins;
+            double rot_re = first_re, rot_im = first_im;
+            for (size_t k = 0; k < num_bins; k++) {
+                const Complex* w = &pass->chirp_out[k];
+                double x_re = (double)buffer[k].real * w->real - (double)buffer[k].imag * w->imag;
+                double x_im = (double)buffer[k].real * w->imag + (double)buffer[k].imag * w->real;
+                out[2 * k] += x_re * rot_re - x_im * rot_im;
+                out[2 * k + 1] += x_re * rot_im + x_im * rot_re;
+                double next_re = rot_re * step_re - rot_im * step_im;
+                rot_im = rot_re * step_im + rot_im * step_re;
+                rot_re = next_re;
+            }
+        }
+        free_wav_data(block);
+    }
+
+    merge_acc(pass, acc);
+    arena_release(mark);
+}
+
+// Tabelas da chirp-z para blocos de pass->block amostras.
+static int prepare_chirp_z(BandPass* pass) {
+    const size_t block = pass->block;
+    const size_t num_bins = pass->num_bins;
+    const size_t fft_size = pass->fft_size;
+    pass->chirp_in = (Complex*)malloc(block * sizeof(Complex));
+    pass->kernel = (Complex*)calloc(fft_size, sizeof(Complex));
+    pass->chirp_out = (Complex*)malloc(num_bins * sizeof(Complex));
+    if (!pass->chirp_in || !pass->kernel || !pass->chirp_out) return -1;
+    TRACE_ALLOC((block + fft_size + num_bins) * sizeof(Complex));
+
+    double re, im;
+    for (size_t n = 0; n < block; n++) {
+        double nd = (double)n;
+        unit_phasor(pass->start_cycles * nd + 0.5 * pass->step_cycles * nd * nd, &re, &im);
+        pass->chirp_in[n].real = (real_t)re;
+        pass->chirp_in[n].imag = (real_t)im;
+    }
+    for (size_t k = 0; k < num_bins; k++) {
+        double kd = (double)k;
+        unit_phasor(0.5 * pass->step_cycles * kd * kd, &re, &im);
+        pass->chirp_out[k].real = (real_t)re;
+        pass->chirp_out[k].imag = (real_t)im;
+        // Atrasos m >= 0 no começo do buffer; os negativos, no fim (circular).
+        pass->kernel[k].real = (real_t)re;
+        pass->kernel[k].imag = (real_t)-im;
+    }
+    for (size_t m = 1; m < block; m++) {
+        double md = (double)m;
+        unit_phasor(0.5 * pass->step_cycles * md * md, &re, &im);
+        pass->kernel[fft_size - m].real = (real_t)re;
+        pass->kernel[fft_size - m].imag = (real_t)-im;
+    }
+    return fft(pass->kernel, fft_size);
+}
+
+// Cria o passe comum aos dois métodos: valida o arquivo e aloca a soma.
+static int init_pass(BandPass* pass, const WavMap* map, size_t num_bins) {
+    const WavData* info = wav_map_info(map);
+    memset(pass, 0, sizeof(BandPass));
+    pass->map = map;
+    pass->num_channels = info->num_channels;
+    pass->num_samples = info->num_samples;
+    pass->num_bins = num_bins;
+    pthread_mutex_init(&pass->lock, NULL);
+    if (pass->num_samples == 0 || num_bins == 0) {
+        fprintf(stderr, "Espectro de faixa: sinal vazio ou nenhuma frequência pedida.\n");
+        return -1;
+    }
+    pass->acc = (double*)calloc(2 * num_bins * pass->num_channels, sizeof(double));
+    if (!pass->acc) return -1;
+    TRACE_ALLOC(2 * num_bins * pass->num_channels * sizeof(double));
+    return 0;
+}
+
+// Converte a soma para o resultado e libera o passe. NULL se algo falhou.
+static Complex* finish_pass(BandPass* pass) {
+    Complex* result = NULL;
+    size_t count = pass->num_bins * pass->num_channels;
+    if (pass->acc && !pass->failed) {
+        result = (Complex*)malloc(count * sizeof(Complex));
+    }
+    if (result) {
+        for (size_t i = 0; i < count; i++) {
+            result[i].real = (real_t)pass->acc[2 * i];
+            result[i].imag = (real_t)pass->acc[2 * i + 1];
+        }
+    } else if (pass->num_samples > 0 && pass->num_bins > 0) {
+        fprintf(stderr, "Memória insuficiente para o espectro da faixa.\n");
+    }
+    free(pass->acc);
+    free(pass->chirp_in);
+    free(pass->kernel);
+    free(pass->chirp_out);
+    pthread_mutex_destroy(&pass->lock);
+    return result;
+}
+
+static int valid_frequency(double freq, uint32_t sample_rate) {
+    return isfinite(freq) && freq >= 0.0 && freq <= sample_rate / 2.0;
+}
+
+Complex* tone_spectrum(const WavMap* map, const double* freqs, size_t num_freqs) {
+    uint32_t sample_rate = wav_map_info(map)->sample_rate;
+    for (size_t k = 0; k < num_freqs; k++) {
+        if (!valid_frequency(freqs[k], sample_rate)) {
+            fprintf(stderr, "Frequência fora de [0, %.1f] Hz: %g.\n", sample_rate / 2.0, freqs[k]);
+            return NULL;
+        }
+    }
+
+    TRACE_BEGIN(span, "tone_spectrum");
+    BandPass pass;
+    double* cycles = (double*)malloc((num_freqs ? num_freqs : 1) * sizeof(double));
+    if (init_pass(&pass, map, num_freqs) == 0 && cycles) {
+        for (size_t k = 0; k < num_freqs; k++) {
+            cycles[k] = freqs[k] / sample_rate;
+        }
+        pass.cycles = cycles;
+        pass.block = GOERTZEL_BLOCK;
+        parallel_for((pass.num_samples + pass.block - 1) / pass.block, 1, goertzel_blocks, &pass);
+    } else {
+        pass.failed = 1;
+    }
+    Complex* result = finish_pass(&pass);
+    free(cycles);
+    TRACE_END(span, (uint64_t)pass.num_samples * pass.num_channels * sizeof(real_t));
+    return result;
+}
+
+Complex* band_spectrum(const WavMap* map, double f_start, double f_end, size_t num_bins) {
+    uint32_t sample_rate = wav_map_info(map)->sample_rate;
+    if (num_bins == 0 || !valid_frequency(f_start, sample_rate) || !valid_frequency(f_end, sample_rate) ||
+        (num_bins > 1 && f_end <= f_start)) {
+        fprintf(stderr, "Faixa inválida: %g a %g Hz em %zu bins (limite: %.1f Hz).\n",
+                f_start, f_end, num_bins, sample_rate / 2.0);
+        return NULL;
+    }
+    double step = (num_bins > 1) ? (f_end - f_start) / (double)(num_bins - 1) : 0.0;
+
+    if (num_bins <= BAND_GOERTZEL_MAX_BINS) {
+        double freqs[BAND_GOERTZEL_MAX_BINS];
+        for (size_t k = 0; k < num_bins; k++) {
+            freqs[k] = f_start + (double)k * step;
+        }
+        return tone_spectrum(map, freqs, num_bins);
+    }
+
+    TRACE_BEGIN(span, "band_spectrum");
+    BandPass pass;
+    if (init_pass(&pass, map, num_bins) == 0) {
+        pass.start_cycles = f_start / sample_rate;
+        pass.step_cycles = step / sample_rate;
+        // O bloco acompanha o número de bins, para que cada par de FFTs renda ao
+        // menos metade de amostras novas; a sobra do tamanho rápido vai para o bloco.
+        size_t block = (num_bins > CZT_MIN_BLOCK) ? num_bins : CZT_MIN_BLOCK;
+        if (block > pass.num_samples) block = pass.num_samples;
+        pass.fft_size = fft_next_fast_size(block + num_bins - 1);
+        pass.block = pass.fft_size - num_bins + 1;
+        if (prepare_chirp_z(&pass) == 0) {
+            parallel_for((pass.num_samples + pass.block - 1) / pass.block, 1, chirp_z_blocks, &pass);
+        } else {
+            pass.failed = 1;
+        }
+    } else {
+        pass.failed = 1;
+    }
+    Complex* result = finish_pass(&pass);
+    TRACE_END(span, (uint64_t)pass.num_samples * pass.num_channels * sizeof(real_t));
+    return result;
+}
+
+double band_tone_amplitude(Complex value, double freq, uint32_t sample_rate, size_t num_samples) {
+    if (num_samples == 0) return 0.0;
+    double magnitude = sqrt((double)value.real * value.real + (double)value.imag * value.imag);
+    double scale = (freq <= 0.0 || freq >= sample_rate / 2.0) ? 1.0 : 2.0;
+    return scale * magnitude / (double)num_samples;
+}
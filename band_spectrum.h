@@ -0,0 +1,38 @@
+#ifndef PROJETO_AUDIO_BAND_SPECTRUM_H
+#define PROJETO_AUDIO_BAND_SPECTRUM_H
+
+#include <stddef.h>
+#include "fft.h"
+#include "wav_handler.h"
+
+// Espectro de uma faixa estreita (ex.: 50–70 Hz) ou de poucas frequências,
+// sem a FFT do arquivo inteiro. Os valores são os mesmos da transformada do
+// sinal todo, X(f) = soma_n x[n] e^(-j 2 pi f n / fs), só que avaliados apenas
+// nas frequências pedidas:
+// - poucas frequências (até BAND_GOERTZEL_MAX_BINS): Goertzel em lote, uma
+//   recorrência de 2ª ordem por frequência, todas na mesma passada: O(K) por amostra;
+// - muitas: transformada chirp-z (Bluestein sobre fft.h), que leva K bins
+//   igualmente espaçados de uma faixa qualquer a uma convolução de ~2K pontos:
+//   O(log K) por amostra.
+// O arquivo é lido pelo mapeamento (wav_map_open), em blocos processados em
+// paralelo, e as contribuições dos blocos são somadas com a rotação de fase de
+// cada um. Memória e tamanho das FFTs dependem de K, não da duração do arquivo.
+
+#define BAND_GOERTZEL_MAX_BINS 64
+// Bins da faixa quando o chamador não escolhe (plot-spectrum --band).
+#define BAND_DEFAULT_BINS 1024
+
+// Os K = 'num_bins' valores de X em f_k = f_start + k * (f_end - f_start) / (K - 1)
+// (com K = 1, só f_start). Frequências em Hz, em [0, fs/2]. Retorna K valores
+// por canal (canal c em + c * K), liberados com free; NULL em erro.
+Complex* band_spectrum(const WavMap* map, double f_start, double f_end, size_t num_bins);
+
+// X nas 'num_freqs' frequências dadas, em qualquer ordem, por Goertzel em lote:
+// custo proporcional a amostras x frequências. Mesmo layout de band_spectrum.
+Complex* tone_spectrum(const WavMap* map, const double* freqs, size_t num_freqs);
+
+// Amplitude de pico de uma senoide de frequência 'freq' a partir de X(freq),
+// num sinal de 'num_samples' amostras: 2 |X| / N (|X| / N em 0 Hz e em fs/2).
+double band_tone_amplitude(Complex value, double freq, uint32_t sample_rate, size_t num_samples);
+
+#endif //PROJETO_AUDIO_BAND_SPECTRUM_H
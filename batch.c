@@ -0,0 +1,411 @@
+#include "batch.h"
+#include "wav_handler.h"
+#include "dsp_operations.h"
+#include "gnuplot_plotter.h"
+#include "stream_processing.h"
+#include "thread_pool.h"
+#include "stft.h"
+#include "filters.h"
+#include "mixer.h"
+#include "convolution.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BATCH_MAX_ARGS 8
+#define PLOT_ZOOM_MS 20.0
+
+typedef struct {
+    int line;                       // Linha no manifesto (para mensagens)
+    int argc;
+    char* argv[BATCH_MAX_ARGS];     // Apontam para dentro de 'tokens'
+    char* tokens;
+    int status;                     // 0 = sucesso, -1 = falha
+    double elapsed_ms;
+
+    // Gráfico pendente, renderizado só no final (com --plot)
+    char* plot_file;
+    const char* plot_title;
+    int plot_log_scale;
+    int plot_heatmap;
+    double plot_zoom_ms;
+    int plot_series;
+} BatchJob;
+
+typedef struct {
+    BatchJob* jobs;
+    size_t num_jobs;
+    size_t next_job;                // Próximo trabalho livre (atômico)
+    const BatchOptions* options;
+} BatchRun;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Número de argumentos (incluindo o comando) de cada trabalho válido.
+static int expected_args(const char* command) {
+    if (strcmp(command, "mix") == 0) return 4;
+    if (strcmp(command, "filter-fft") == 0) return 5;
+    if (strcmp(command, "filter-sma") == 0) return 4;
+    if (strcmp(command, "filter-fir") == 0) return 6;
+    if (strcmp(command, "filter-iir") == 0) return 6;
+    if (strcmp(command, "resample") == 0) return 4;
+    if (strcmp(command, "convolve") == 0) return 4;
+    if (strcmp(command, "plot-spectrum") == 0) return 3;
+    if (strcmp(command, "plot-signal") == 0) return 3;
+    if (strcmp(command, "spectrogram") == 0) return 3;
+    return -1;
+}
+
+// Separa uma linha do manifesto em argumentos. Retorna 1 se a linha contém um
+// trabalho, 0 se deve ser ignorada e -1 se é inválida.
+static int parse_job(const char* line, int line_number, BatchJob* job) {
+    memset(job, 0, sizeof(BatchJob));
+    job->line = line_number;
+    job->tokens = strdup(line);
+
+    char* save = NULL;
+    for (char* tok = strtok_r(job->tokens, " \t\r\n", &save); tok; tok = strtok_r(NULL, " \t\r\n", &save)) {
+        if (job->argc == 0 && tok[0] == '#') break;
+        if (job->argc == BATCH_MAX_ARGS) {
+            fprintf(stderr, "Manifesto, linha %d: argumentos demais.\n", line_number);
+            return -1;
+        }
+        job->argv[job->argc++] = tok;
+    }
+    if (job->argc == 0) return 0;
+
+    int expected = expected_args(job->argv[0]);
+    if (expected < 0) {
+        fprintf(stderr, "Manifesto, linha %d: comando desconhecido '%s'.\n", line_number, job->argv[0]);
+        return -1;
+    }
+    if (job->argc != expected) {
+        fprintf(stderr, "Manifesto, linha %d: '%s' espera %d argumentos.\n", line_number, job->argv[0], expected - 1);
+        return -1;
+    }
+    return 1;
+}
+
+static void free_jobs(BatchJob* jobs, size_t num_jobs) {
+    for (size_t i = 0; i < num_jobs; i++) {
+        free(jobs[i].tokens);
+        free(jobs[i].plot_file);
+    }
+    free(jobs);
+}
+
+// Lê o manifesto inteiro. Retorna NULL (e não executa nada) se alguma linha for inválida.
+static BatchJob* read_manifest(const char* manifest_path, size_t* num_jobs_out) {
+    FILE* fp = fopen(manifest_path, "r");
+    if (!fp) {
+        perror("Erro ao abrir o manifesto");
+        return NULL;
+    }
+
+    BatchJob* jobs = NULL;
+    size_t num_jobs = 0, capacity = 0;
+    char* line = NULL;
+    size_t line_size = 0;
+    int line_number = 0;
+    int failed = 0;
+
+    while (getline(&line, &line_size, fp) != -1) {
+        line_number++;
+        if (num_jobs == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            BatchJob* grown = (BatchJob*)realloc(jobs, capacity * sizeof(BatchJob));
+            if (!grown) {
+                fprintf(stderr, "Memória insuficiente para o manifesto.\n");
+                failed = 1;
+                break;
+            }
+            jobs = grown;
+        }
+        int parsed = parse_job(line, line_number, &jobs[num_jobs]);
+        if (parsed == 1) {
+            num_jobs++;
+        } else {
+            free(jobs[num_jobs].tokens);
+            if (parsed < 0) failed = 1;
+        }
+    }
+    free(line);
+    fclose(fp);
+
+    if (failed) {
+        free_jobs(jobs, num_jobs);
+        return NULL;
+    }
+    *num_jobs_out = num_jobs;
+    return jobs;
+}
+
+// Grava os dados do gráfico de um sinal de saída ao lado dele ("<out.wav>.dat").
+static void queue_signal_plot(BatchJob* job, const WavData* wav, const char* out_path, const char* title) {
+    size_t len = strlen(out_path) + sizeof(".dat");
+    job->plot_file = (char*)malloc(len);
+    snprintf(job->plot_file, len, "%s.dat", out_path);
+    plot_signal_to_file(job->plot_file, wav, PLOT_ZOOM_MS);
+    job->plot_title = title;
+    job->plot_zoom_ms = PLOT_ZOOM_MS;
+    job->plot_series = wav->num_channels;
+}
+
+// Salva o resultado de um trabalho em memória e, com --plot, os dados do gráfico.
+static int finish_wav_job(BatchJob* job, WavData* wav, const char* out_path, const char* title,
+                          const BatchOptions* options) {
+    int status = write_wav_file(out_path, wav);
+    if (status == 0 && options->enable_plots) {
+        queue_signal_plot(job, wav, out_path, title);
+    }
+    free_wav_data(wav);
+    return status;
+}
+
+static int run_job(BatchJob* job, const BatchOptions* options) {
+    char** argv = job->argv;
+    const char* command = argv[0];
+
+    if (strcmp(command, "mix") == 0) {
+        if (options->stream_mode) {
+            MixInput inputs[2] = { { argv[1], 1.0, 0.0 }, { argv[2], 1.0, 0.0 } };
+            MixOptions mix_options = { 0, 1 };
+            return mix_files(inputs, 2, argv[3], &mix_options);
+        }
+        WavData* wav1 = read_wav_file(argv[1]);
+        WavData* wav2 = wav1 ? read_wav_file(argv[2]) : NULL;
+        if (!wav1 || !wav2) {
+            free_wav_data(wav1);
+            return -1;
+        }
+        WavData* mixed_wav = mix_audio(wav1, wav2);
+        free_wav_data(wav1);
+        free_wav_data(wav2);
+        if (!mixed_wav) return -1;
+        return finish_wav_job(job, mixed_wav, argv[3], "Sinal Mixado", options);
+
+    } else if (strcmp(command, "filter-fft") == 0) {
+        int is_high_pass = (strcmp(argv[1], "high") == 0);
+        double cutoff = atof(argv[2]);
+        if (options->stream_mode) {
+            return stream_fft_filter_file(argv[3], argv[4], cutoff, is_high_pass);
+        }
+        WavData* wav = read_wav_file(argv[3]);
+        if (!wav) return -1;
+        if (apply_fft_filter(wav, cutoff, is_high_pass) != 0) {
+            free_wav_data(wav);
+            return -1;
+        }
+        return finish_wav_job(job, wav, argv[4], "Sinal Filtrado (FFT)", options);
+
+    } else if (strcmp(command, "filter-sma") == 0) {
+        int window_size = atoi(argv[1]);
+        if (options->stream_mode) {
+            return stream_sma_filter_file(argv[2], argv[3], window_size);
+        }
+        WavData* wav = read_wav_file(argv[2]);
+        if (!wav) return -1;
+        apply_sma_filter(wav, window_size);
+        return finish_wav_job(job, wav, argv[3], "Sinal Filtrado (Média Móvel)", options);
+
+    } else if (strcmp(command, "filter-fir") == 0 || strcmp(command, "filter-iir") == 0) {
+        // filter-fir usa sempre a janela de Blackman, o padrão da linha de comando.
+        int is_fir = (strcmp(command, "filter-fir") == 0);
+        FilterSpec spec;
+        int size = atoi(argv[3]);
+        if (filter_parse_spec(argv[1], argv[2], &spec) != 0 || size <= 0) {
+            fprintf(stderr, "Manifesto, linha %d: filtro inválido.\n", job->line);
+            return -1;
+        }
+        if (options->stream_mode) {
+            return is_fir ? stream_fir_filter_file(argv[4], argv[5], &spec, (size_t)size, WINDOW_BLACKMAN)
+                          : stream_iir_filter_file(argv[4], argv[5], &spec, size);
+        }
+        WavData* wav = read_wav_file(argv[4]);
+        if (!wav) return -1;
+        int status;
+        if (is_fir) {
+            double* taps = fir_design(&spec, wav->sample_rate, (size_t)size, WINDOW_BLACKMAN);
+            status = taps ? apply_fir_filter(wav, taps, (size_t)size) : -1;
+            free(taps);
+        } else {
+            status = apply_iir_filter(wav, &spec, size);
+        }
+        if (status != 0) {
+            free_wav_data(wav);
+            return -1;
+        }
+        return finish_wav_job(job, wav, argv[5], is_fir ? "Sinal Filtrado (FIR)" : "Sinal Filtrado (IIR)", options);
+
+    } else if (strcmp(command, "resample") == 0) {
+        int sample_rate = atoi(argv[1]);
+        if (sample_rate <= 0) {
+            fprintf(stderr, "Manifesto, linha %d: taxa de amostragem inválida.\n", job->line);
+            return -1;
+        }
+        if (options->stream_mode) {
+            return stream_resample_file(argv[2], argv[3], (uint32_t)sample_rate);
+        }
+        WavData* wav = read_wav_file(argv[2]);
+        if (!wav) return -1;
+        WavData* resampled = resample_audio(wav, (uint32_t)sample_rate);
+        free_wav_data(wav);
+        if (!resampled) return -1;
+        return finish_wav_job(job, resampled, argv[3], "Sinal Convertido", options);
+
+    } else if (strcmp(command, "convolve") == 0) {
+        if (options->stream_mode) {
+            return stream_convolve_file(argv[1], argv[2], argv[3]);
+        }
+        WavData* wav = read_wav_file(argv[1]);
+        WavData* impulse = wav ? read_wav_file(argv[2]) : NULL;
+        if (!wav || !impulse) {
+            free_wav_data(wav);
+            return -1;
+        }
+        WavData* convolved = convolve_audio(wav, impulse);
+        free_wav_data(wav);
+        free_wav_data(impulse);
+        if (!convolved) return -1;
+        return finish_wav_job(job, convolved, argv[3], "Sinal Convoluído", options);
+
+    } else if (strcmp(command, "plot-spectrum") == 0) {
+        WavData* wav = read_wav_file(argv[1]);
+        if (!wav) return -1;
+        size_t fft_size;
+        Complex* spectrum = get_spectrum(wav, &fft_size);
+        if (!spectrum) {
+            free_wav_data(wav);
+            return -1;
+        }
+        plot_spectrum_to_file(argv[2], spectrum, fft_size, wav->sample_rate, wav->num_channels);
+        if (options->enable_plots) {
+            job->plot_file = strdup(argv[2]);
+            job->plot_title = "Espectro de Frequência";
+            job->plot_log_scale = 1;
+            job->plot_series = wav->num_channels;
+        }
+        free(spectrum);
+        free_wav_data(wav);
+        return 0;
+
+    } else if (strcmp(command, "spectrogram") == 0) {
+        WavData* wav = read_wav_file(argv[1]);
+        if (!wav) return -1;
+        StftConfig config;
+        stft_default_config(&config);
+        Spectrogram* spectrogram = stft_spectrogram(wav, &config);
+        free_wav_data(wav);
+        if (!spectrogram) return -1;
+        plot_spectrogram_to_file(argv[2], spectrogram);
+        free_spectrogram(spectrogram);
+        if (options->enable_plots) {
+            job->plot_file = strdup(argv[2]);
+            job->plot_title = "Espectrograma";
+            job->plot_heatmap = 1;
+        }
+        return 0;
+
+    } else {
+        // plot-signal: como na linha de comando, só o trecho exibido é convertido.
+        WavMap* map = wav_map_open(argv[1]);
+        if (!map) return -1;
+        size_t zoom_samples = (size_t)(PLOT_ZOOM_MS / 1000.0 * wav_map_info(map)->sample_rate) + 1;
+        WavData* wav = wav_map_load(map, 0, zoom_samples);
+        wav_map_close(map);
+        if (!wav) return -1;
+        plot_signal_to_file(argv[2], wav, PLOT_ZOOM_MS);
+        if (options->enable_plots) {
+            job->plot_file = strdup(argv[2]);
+            job->plot_title = "Sinal";
+            job->plot_zoom_ms = PLOT_ZOOM_MS;
+            job->plot_series = wav->num_channels;
+        }
+        free_wav_data(wav);
+        return 0;
+    }
+}
+
+static void run_timed_job(BatchJob* job, const BatchOptions* options) {
+    double start = now_ms();
+    job->status = run_job(job, options);
+    job->elapsed_ms = now_ms() - start;
+}
+
+// Cada thread pega o próximo trabalho livre até acabarem: trabalhos de
+// durações diferentes ficam equilibrados entre as threads.
+static void batch_worker(size_t begin, size_t end, void* ctx) {
+    (void)begin;
+    (void)end;
+    BatchRun* run = (BatchRun*)ctx;
+    for (;;) {
+        size_t i = __atomic_fetch_add(&run->next_job, 1, __ATOMIC_RELAXED);
+        if (i >= run->num_jobs) break;
+        run_timed_job(&run->jobs[i], run->options);
+    }
+}
+
+int run_batch(const char* manifest_path, const BatchOptions* options) {
+    size_t num_jobs = 0;
+    BatchJob* jobs = read_manifest(manifest_path, &num_jobs);
+    if (!jobs) return -1;
+
+    int threads = thread_pool_size();
+    printf("Executando %zu trabalhos de '%s' com %d thread(s)...\n", num_jobs, manifest_path, threads);
+
+    double start = now_ms();
+    if (num_jobs >= (size_t)threads) {
+        // Um trabalho por thread; dentro de cada um, tudo roda em série.
+        BatchRun run = { jobs, num_jobs, 0, options };
+        parallel_for((size_t)threads, 1, batch_worker, &run);
+    } else {
+        // Poucos trabalhos: um de cada vez, cada um usando o pool inteiro.
+        for (size_t i = 0; i < num_jobs; i++) {
+            run_timed_job(&jobs[i], options);
+        }
+    }
+    double total_ms = now_ms() - start;
+
+    int failures = 0;
+    double busy_ms = 0.0;
+    for (size_t i = 0; i < num_jobs; i++) {
+        BatchJob* job = &jobs[i];
+        printf("  linha %4d  %10.2f ms  %-6s", job->line, job->elapsed_ms, job->status == 0 ? "ok" : "FALHOU");
+        for (int a = 0; a < job->argc; a++) {
+            printf(" %s", job->argv[a]);
+        }
+        printf("\n");
+        busy_ms += job->elapsed_ms;
+        if (job->status != 0) failures++;
+    }
+    printf("%zu trabalhos, %d falha(s): %.2f ms no total (soma dos trabalhos: %.2f ms).\n",
+           num_jobs, failures, total_ms, busy_ms);
+
+    // Os gráficos pedidos são renderizados só depois, fora da medição, em
+    // PNG ao lado dos dados ("<dados>.png"), sem abrir janelas.
+    for (size_t i = 0; i < num_jobs; i++) {
+        BatchJob* job = &jobs[i];
+        if (job->status == 0 && job->plot_file) {
+            const char* xlabel = job->plot_log_scale ? "Frequência (Hz)" : "Tempo (s)";
+            const char* ylabel = job->plot_log_scale ? "Magnitude" : "Amplitude";
+            size_t len = strlen(job->plot_file) + sizeof(".png");
+            char* image = (char*)malloc(len);
+            snprintf(image, len, "%s.png", job->plot_file);
+            if (job->plot_heatmap) {
+                invoke_gnuplot_heatmap(job->plot_file, job->plot_title, image);
+            } else {
+                invoke_gnuplot(job->plot_file, job->plot_title, xlabel, ylabel,
+                               job->plot_log_scale, job->plot_zoom_ms, job->plot_series, image);
+            }
+            free(image);
+        }
+    }
+
+    free_jobs(jobs, num_jobs);
+    return failures ? -1 : 0;
+}
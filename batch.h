@@ -0,0 +1,35 @@
+#ifndef PROJETO_AUDIO_BATCH_H
+#define PROJETO_AUDIO_BATCH_H
+
+// Modo em lote: executa muitos trabalhos em um único processo, distribuídos
+// entre as threads do pool. As tabelas de FFT (em cache por tamanho) e os
+// buffers de trabalho de cada thread são reaproveitados entre trabalhos.
+//
+// O manifesto tem um trabalho por linha, com a mesma sintaxe da linha de
+// comando (linhas vazias e começando com '#' são ignoradas):
+//
+//   mix <in1.wav> <in2.wav> <out.wav>
+//   filter-fft <low|high> <freq_corte_hz> <in.wav> <out.wav>
+//   filter-sma <tamanho_janela> <in.wav> <out.wav>
+//   filter-fir <low|high|band> <freq_hz|f1:f2> <coeficientes> <in.wav> <out.wav>   (janela de Blackman)
+//   filter-iir <low|high|band> <freq_hz|f1:f2> <ordem> <in.wav> <out.wav>
+//   resample <taxa_hz> <in.wav> <out.wav>
+//   convolve <in.wav> <resposta_impulso.wav> <out.wav>
+//   plot-spectrum <in.wav> <dados.dat>
+//   plot-signal <in.wav> <dados.dat>
+//   spectrogram <in.wav> <dados.bin>      (quadro, avanço e janela padrão)
+//
+// Nos comandos plot-* e spectrogram, o arquivo de dados é a saída do trabalho. Com gráficos
+// ligados, os trabalhos que gravam WAV também gravam "<out.wav>.dat", e cada gráfico é
+// renderizado em "<dados>.png" depois que o lote inteiro termina.
+typedef struct {
+    int stream_mode;    // filter-*, resample e convolve em blocos, como em --stream; mix pelo
+                        // mixer em blocos (mix_files)
+    int enable_plots;   // Gera os gráficos em PNG ao final (desligado por padrão)
+} BatchOptions;
+
+// Lê o manifesto, executa os trabalhos e imprime o tempo de cada um, na ordem
+// do manifesto. Retorna 0 se todos tiveram sucesso e -1 caso contrário.
+int run_batch(const char* manifest_path, const BatchOptions* options);
+
+#endif //PROJETO_AUDIO_BATCH_H
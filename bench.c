@@ -0,0 +1,550 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "wav_handler.h"
+#include "fft.h"
+#include "fft_simd.h"
+#include "dsp_operations.h"
+#include "filters.h"
+#include "stft.h"
+#include "thread_pool.h"
+#include "signal_gen.h"
+#include "convolution.h"
+
+// Benchmark das operações principais sobre sinais sintéticos determinísticos.
+// Para cada operação e tamanho (2^min .. 2^max amostras por canal) mede o
+// melhor tempo entre várias repetições e reporta ns/amostra, GFLOPS (pelo
+// modelo de operações de cada uma) e o pico de memória residente.
+
+#define BENCH_MIN_LOG2 10
+#define BENCH_MAX_LOG2 26
+#define BENCH_MAX_REPS 1000
+
+// Parâmetros fixos das operações medidas.
+#define BENCH_CUTOFF_HZ 1000.0
+#define BENCH_SMA_WINDOW 32
+#define BENCH_FIR_TAPS 255
+#define BENCH_IIR_ORDER 8
+#define BENCH_IMPULSE_SAMPLES 48000     // Resposta ao impulso de 1 s a 48 kHz
+#define BENCH_XCORR_MAX_LAG 4800        // 100 ms a 48 kHz
+
+typedef struct {
+    WavData* input;           // Sinal gerado, nunca alterado
+    WavData* work;            // Cópia de 'input', restaurada antes de cada repetição
+    WavData* other;           // Segunda entrada da mixagem, resposta ao impulso ou sinal correlacionado
+    size_t n;                 // Amostras por canal
+    FftPlan* plan;
+    Complex* spectrum;
+    real_t* real_buffer;
+    double* taps;
+    FilterSpec spec;
+    const char* tmp_path;
+} BenchContext;
+
+typedef struct {
+    const char* name;
+    int single_channel;                            // Mede só o canal 0
+    int in_place;                                  // A operação altera 'work'
+    int (*setup)(BenchContext* ctx);               // Fora da medição; NULL se não houver
+    void (*run)(BenchContext* ctx);
+    void (*teardown)(BenchContext* ctx);
+    double (*flops)(const BenchContext* ctx);      // Operações de ponto flutuante por execução; NULL sem modelo
+} BenchOp;
+
+static double log2_size(size_t n) {
+    return log((double)n) / log(2.0);
+}
+
+// --- FFT complexa: ida e volta sobre o canal 0 ---
+
+static int fft_setup(BenchContext* ctx) {
+    ctx->plan = fft_plan_create(ctx->n);
+    ctx->spectrum = (Complex*)malloc(ctx->n * sizeof(Complex));
+    if (!ctx->plan || !ctx->spectrum) return -1;
+    const real_t* samples = wav_channel(ctx->input, 0);
+    for (size_t i = 0; i < ctx->n; i++) {
+        ctx->spectrum[i].real = samples[i];
+        ctx->spectrum[i].imag = 0.0;
+    }
+    return 0;
+}
+
+static void fft_run(BenchContext* ctx) {
+    fft_execute(ctx->plan, ctx->spectrum, FFT_FORWARD);
+    fft_execute(ctx->plan, ctx->spectrum, FFT_INVERSE);
+}
+
+// 5 n log2 n por transformada (contagem usual do radix-2).
+static double fft_flops(const BenchContext* ctx) {
+    return 2.0 * 5.0 * ctx->n * log2_size(ctx->n);
+}
+
+// --- FFT real: ida e volta sobre o canal 0 ---
+
+static int rfft_setup(BenchContext* ctx) {
+    ctx->plan = fft_plan_create_real(ctx->n);
+    ctx->spectrum = (Complex*)malloc((ctx->n / 2 + 1) * sizeof(Complex));
+    ctx->real_buffer = (real_t*)malloc(ctx->n * sizeof(real_t));
+    if (!ctx->plan || !ctx->spectrum || !ctx->real_buffer) return -1;
+    memcpy(ctx->real_buffer, wav_channel(ctx->input, 0), ctx->n * sizeof(real_t));
+    return 0;
+}
+
+static void rfft_run(BenchContext* ctx) {
+    rfft_execute(ctx->plan, ctx->real_buffer, ctx->spectrum);
+    irfft_execute(ctx->plan, ctx->spectrum, ctx->real_buffer);
+}
+
+static double rfft_flops(const BenchContext* ctx) {
+    return 2.0 * 2.5 * ctx->n * log2_size(ctx->n);
+}
+
+static void fft_teardown(BenchContext* ctx) {
+    fft_plan_destroy(ctx->plan);
+    free(ctx->spectrum);
+    free(ctx->real_buffer);
+    ctx->plan = NULL;
+    ctx->spectrum = NULL;
+    ctx->real_buffer = NULL;
+}
+
+// --- Operações sobre o sinal inteiro (todos os canais) ---
+
+static void fft_filter_run(BenchContext* ctx) {
+    apply_fft_filter(ctx->work, BENCH_CUTOFF_HZ, 0);
+}
+
+// Uma FFT real e uma inversa do tamanho escolhido por apply_fft_filter, por canal.
+static double fft_filter_flops(const BenchContext* ctx) {
+    size_t size = fft_next_fast_size(ctx->n);
+    return ctx->input->num_channels * 2.0 * 2.5 * size * log2_size(size);
+}
+
+static void sma_run(BenchContext* ctx) {
+    apply_sma_filter(ctx->work, BENCH_SMA_WINDOW);
+}
+
+// Soma, subtração e divisão por amostra.
+static double sma_flops(const BenchContext* ctx) {
+    return 3.0 * ctx->n * ctx->input->num_channels;
+}
+
+static int fir_setup(BenchContext* ctx) {
+    ctx->spec.response = FILTER_LOW_PASS;
+    ctx->spec.low_hz = BENCH_CUTOFF_HZ;
+    ctx->spec.high_hz = 0.0;
+    ctx->taps = fir_design(&ctx->spec, ctx->input->sample_rate, BENCH_FIR_TAPS, WINDOW_BLACKMAN);
+    return ctx->taps ? 0 : -1;
+}
+
+static void fir_run(BenchContext* ctx) {
+    apply_fir_filter(ctx->work, ctx->taps, BENCH_FIR_TAPS);
+}
+
+static void fir_teardown(BenchContext* ctx) {
+    free(ctx->taps);
+    ctx->taps = NULL;
+}
+
+// Equivalente à forma direta (uma multiplicação e uma soma por coeficiente),
+// para que o número seja comparável qualquer que seja o algoritmo usado.
+static double fir_flops(const BenchContext* ctx) {
+    return 2.0 * BENCH_FIR_TAPS * ctx->n * ctx->input->num_channels;
+}
+
+static int iir_setup(BenchContext* ctx) {
+    ctx->spec.response = FILTER_LOW_PASS;
+    ctx->spec.low_hz = BENCH_CUTOFF_HZ;
+    ctx->spec.high_hz = 0.0;
+    return 0;
+}
+
+static void iir_run(BenchContext* ctx) {
+    apply_iir_filter(ctx->work, &ctx->spec, BENCH_IIR_ORDER);
+}
+
+// 5 multiplicações e 4 somas por biquad e amostra.
+static double iir_flops(const BenchContext* ctx) {
+    double sections = (BENCH_IIR_ORDER + 1) / 2;
+    return 9.0 * sections * ctx->n * ctx->input->num_channels;
+}
+
+static int mix_setup(BenchContext* ctx) {
+    ctx->other = signal_generate(SIGNAL_WHITE_NOISE, ctx->input->sample_rate, ctx->input->num_channels,
+                                 ctx->n, 0x5EEDULL);
+    return ctx->other ? 0 : -1;
+}
+
+static void mix_run(BenchContext* ctx) {
+    free_wav_data(mix_audio(ctx->input, ctx->other));
+}
+
+static void mix_teardown(BenchContext* ctx) {
+    free_wav_data(ctx->other);
+    ctx->other = NULL;
+}
+
+// Soma e comparação do pico por amostra.
+static double mix_flops(const BenchContext* ctx) {
+    return 2.0 * ctx->n * ctx->input->num_channels;
+}
+
+// 44.1 kHz <-> 48 kHz, a conversão mais comum na prática.
+static void resample_run(BenchContext* ctx) {
+    uint32_t rate = (ctx->input->sample_rate == 44100) ? 48000 : 44100;
+    free_wav_data(resample_audio(ctx->input, rate));
+}
+
+static int convolve_setup(BenchContext* ctx) {
+    ctx->other = signal_generate(SIGNAL_WHITE_NOISE, ctx->input->sample_rate, 1, BENCH_IMPULSE_SAMPLES, 0x5EEDULL);
+    return ctx->other ? 0 : -1;
+}
+
+static void convolve_run(BenchContext* ctx) {
+    free_wav_data(convolve_audio(ctx->input, ctx->other));
+}
+
+static void xcorr_run(BenchContext* ctx) {
+    CorrelationPeak peak;
+    find_correlation_peak(wav_channel(ctx->input, 0), ctx->n, wav_channel(ctx->other, 0), ctx->n,
+                          BENCH_XCORR_MAX_LAG, &peak);
+}
+
+// Equivalente à forma direta (uma multiplicação e uma soma por atraso).
+static double xcorr_flops(const BenchContext* ctx) {
+    return 2.0 * (2 * BENCH_XCORR_MAX_LAG + 1) * ctx->n;
+}
+
+static void stft_run(BenchContext* ctx) {
+    StftConfig config;
+    stft_default_config(&config);
+    free_spectrogram(stft_spectrogram(ctx->input, &config));
+}
+
+// Por quadro e canal: janela, FFT real e potência (4 operações por bin).
+static double stft_flops(const BenchContext* ctx) {
+    StftConfig config;
+    stft_default_config(&config);
+    size_t frames = 1;
+    if (ctx->n > config.frame_size) {
+        frames += (ctx->n - config.frame_size + config.hop_size - 1) / config.hop_size;
+    }
+    double per_frame = config.frame_size + 2.5 * config.frame_size * log2_size(config.frame_size) +
+                       4.0 * (config.frame_size / 2 + 1);
+    return frames * per_frame * ctx->input->num_channels;
+}
+
+static void wav_write_run(BenchContext* ctx) {
+    write_wav_file(ctx->tmp_path, ctx->input);
+}
+
+static int wav_read_setup(BenchContext* ctx) {
+    write_wav_file(ctx->tmp_path, ctx->input);
+    return 0;
+}
+
+static void wav_read_run(BenchContext* ctx) {
+    free_wav_data(read_wav_file(ctx->tmp_path));
+}
+
+static const BenchOp bench_ops[] = {
+    { "fft",        1, 0, fft_setup,      fft_run,        fft_teardown, fft_flops },
+    { "rfft",       1, 0, rfft_setup,     rfft_run,       fft_teardown, rfft_flops },
+    { "fft_filter", 0, 1, NULL,           fft_filter_run, NULL,         fft_filter_flops },
+    { "sma",        0, 1, NULL,           sma_run,        NULL,         sma_flops },
+    { "fir",        0, 1, fir_setup,      fir_run,        fir_teardown, fir_flops },
+    { "iir",        0, 1, iir_setup,      iir_run,        NULL,         iir_flops },
+    { "mix",        0, 0, mix_setup,      mix_run,        mix_teardown, mix_flops },
+    { "resample",   0, 0, NULL,           resample_run,   NULL,         NULL },
+    { "convolve",   0, 0, convolve_setup, convolve_run,   mix_teardown, NULL },
+    { "xcorr",      1, 0, mix_setup,      xcorr_run,      mix_teardown, xcorr_flops },
+    { "stft",       0, 0, NULL,           stft_run,       NULL,         stft_flops },
+    { "wav_write",  0, 0, NULL,           wav_write_run,  NULL,         NULL },
+    { "wav_read",   0, 0, wav_read_setup, wav_read_run,   NULL,         NULL },
+};
+#define NUM_BENCH_OPS (sizeof(bench_ops) / sizeof(bench_ops[0]))
+
+// --- Medição ---
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Zera o pico de memória residente (VmHWM) do processo; no Linux >= 4.0.
+static void reset_peak_rss(void) {
+    FILE* fp = fopen("/proc/self/clear_refs", "w");
+    if (fp) {
+        fputs("5", fp);
+        fclose(fp);
+    }
+}
+
+// Pico de memória residente em KB: VmHWM, ou o máximo do processo (getrusage).
+static long peak_rss_kb(void) {
+    FILE* fp = fopen("/proc/self/status", "r");
+    if (fp) {
+        char line[256];
+        long value = -1;
+        while (fgets(line, sizeof(line), fp)) {
+            if (sscanf(line, "VmHWM: %ld", &value) == 1) break;
+        }
+        fclose(fp);
+        if (value >= 0) return value;
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+typedef struct {
+    const char* op;
+    size_t n;
+    uint16_t channels;        // Canais processados
+    int reps;
+    double best_s;
+    double mean_s;
+    double flops;             // 0 = sem modelo
+    long peak_rss_kb;
+} BenchResult;
+
+// Executa 'op' até somar 'min_time' segundos (ao menos 3 vezes, após um
+// aquecimento), restaurando a entrada antes de cada repetição.
+static int run_op(const BenchOp* op, BenchContext* ctx, double min_time, BenchResult* result) {
+    reset_peak_rss();
+    if (op->setup && op->setup(ctx) != 0) {
+        fprintf(stderr, "Falha ao preparar '%s' com %zu amostras.\n", op->name, ctx->n);
+        if (op->teardown) op->teardown(ctx);
+        return -1;
+    }
+
+    size_t bytes = (size_t)ctx->input->num_samples * ctx->input->num_channels * sizeof(real_t);
+    double best = INFINITY;
+    double total = 0.0;
+    int reps = 0;
+    for (int i = -1; i < BENCH_MAX_REPS; i++) {
+        if (op->in_place) memcpy(ctx->work->samples, ctx->input->samples, bytes);
+        double start = now_seconds();
+        op->run(ctx);
+        double elapsed = now_seconds() - start;
+        if (i < 0) continue;  // Aquecimento: tabelas, arena e páginas já alocadas
+        reps++;
+        total += elapsed;
+        if (elapsed < best) best = elapsed;
+        if (reps >= 3 && total >= min_time) break;
+    }
+
+    result->op = op->name;
+    result->n = ctx->n;
+    result->channels = op->single_channel ? 1 : ctx->input->num_channels;
+    result->reps = reps;
+    result->best_s = best;
+    result->mean_s = total / reps;
+    result->flops = op->flops ? op->flops(ctx) : 0.0;
+    result->peak_rss_kb = peak_rss_kb();
+    if (op->teardown) op->teardown(ctx);
+    return 0;
+}
+
+// --- Saída ---
+
+static double ns_per_sample(const BenchResult* r) {
+    return r->best_s * 1e9 / ((double)r->n * r->channels);
+}
+
+static void print_result(FILE* fp, const BenchResult* r) {
+    fprintf(fp, "%-10s %10zu %6d %12.3f %10.3f ", r->op, r->n, r->reps, r->best_s * 1e3, ns_per_sample(r));
+    if (r->flops > 0.0) {
+        fprintf(fp, "%8.3f", r->flops / r->best_s * 1e-9);
+    } else {
+        fprintf(fp, "%8s", "-");
+    }
+    fprintf(fp, " %10ld\n", r->peak_rss_kb);
+}
+
+static void write_json(FILE* fp, const BenchResult* results, size_t count, const char* signal,
+                       uint32_t sample_rate, uint16_t num_channels) {
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"precision\": \"%s\",\n", REAL_T_NAME);
+    fprintf(fp, "  \"simd\": \"%s\",\n", fft_simd_kernels()->name);
+    fprintf(fp, "  \"threads\": %d,\n", thread_pool_size());
+    fprintf(fp, "  \"signal\": \"%s\",\n", signal);
+    fprintf(fp, "  \"sample_rate\": %u,\n", sample_rate);
+    fprintf(fp, "  \"channels\": %u,\n", num_channels);
+    fprintf(fp, "  \"results\": [\n");
+    for (size_t i = 0; i < count; i++) {
+        const BenchResult* r = &results[i];
+        fprintf(fp, "    {\"op\": \"%s\", \"samples_per_channel\": %zu, \"channels\": %u, \"reps\": %d, "
+                    "\"best_s\": %.9g, \"mean_s\": %.9g, \"ns_per_sample\": %.6g, ",
+                r->op, r->n, (unsigned)r->channels, r->reps, r->best_s, r->mean_s, ns_per_sample(r));
+        if (r->flops > 0.0) {
+            fprintf(fp, "\"gflops\": %.6g, ", r->flops / r->best_s * 1e-9);
+        } else {
+            fprintf(fp, "\"gflops\": null, ");
+        }
+        fprintf(fp, "\"peak_rss_kb\": %ld}%s\n", r->peak_rss_kb, i + 1 < count ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+}
+
+static void print_usage(const char* prog_name) {
+    fprintf(stderr, "Uso: %s [opções]\n", prog_name);
+    fprintf(stderr, "\nOpções:\n");
+    fprintf(stderr, "  --ops A,B,...  Operações a medir (padrão: todas):\n                ");
+    for (size_t i = 0; i < NUM_BENCH_OPS; i++) {
+        fprintf(stderr, " %s", bench_ops[i].name);
+    }
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --signal S     sine, chirp, white ou pink (padrão pink)\n");
+    fprintf(stderr, "  --min-log2 K   Menor tamanho: 2^K amostras por canal (padrão 10)\n");
+    fprintf(stderr, "  --max-log2 K   Maior tamanho: 2^K amostras por canal (padrão 20, máximo %d)\n", BENCH_MAX_LOG2);
+    fprintf(stderr, "  --channels C   Canais do sinal (padrão 1)\n");
+    fprintf(stderr, "  --rate R       Taxa de amostragem em Hz (padrão 48000)\n");
+    fprintf(stderr, "  --seed N       Semente dos ruídos (padrão 1)\n");
+    fprintf(stderr, "  --threads N    Threads do pool (0 = todos os núcleos; padrão 1)\n");
+    fprintf(stderr, "  --min-time S   Tempo mínimo medido por operação e tamanho, em segundos (padrão 0.25)\n");
+    fprintf(stderr, "  --json F       Grava os resultados em JSON em F ('-' = saída padrão)\n");
+    fprintf(stderr, "  --tmp F        Arquivo temporário de wav_write/wav_read (padrão $TMPDIR/projeto_audio_bench.wav)\n");
+}
+
+// 1 se 'name' está na lista separada por vírgulas (NULL = todas).
+static int op_selected(const char* list, const char* name) {
+    if (!list) return 1;
+    size_t len = strlen(name);
+    for (const char* p = list; *p;) {
+        const char* end = strchr(p, ',');
+        size_t item = end ? (size_t)(end - p) : strlen(p);
+        if (item == len && strncmp(p, name, len) == 0) return 1;
+        if (!end) break;
+        p = end + 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    const char* ops_option = NULL;
+    const char* json_path = NULL;
+    const char* tmp_option = NULL;
+    SignalType signal = SIGNAL_PINK_NOISE;
+    int min_log2 = BENCH_MIN_LOG2;
+    int max_log2 = 20;
+    int num_channels = 1;
+    long sample_rate = 48000;
+    uint64_t seed = 1;
+    int threads = 1;
+    double min_time = 0.25;
+
+    for (int i = 1; i < argc; i++) {
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!value) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(argv[i], "--ops") == 0) ops_option = value;
+        else if (strcmp(argv[i], "--json") == 0) json_path = value;
+        else if (strcmp(argv[i], "--tmp") == 0) tmp_option = value;
+        else if (strcmp(argv[i], "--min-log2") == 0) min_log2 = atoi(value);
+        else if (strcmp(argv[i], "--max-log2") == 0) max_log2 = atoi(value);
+        else if (strcmp(argv[i], "--channels") == 0) num_channels = atoi(value);
+        else if (strcmp(argv[i], "--rate") == 0) sample_rate = atol(value);
+        else if (strcmp(argv[i], "--seed") == 0) seed = strtoull(value, NULL, 10);
+        else if (strcmp(argv[i], "--threads") == 0) threads = atoi(value);
+        else if (strcmp(argv[i], "--min-time") == 0) min_time = atof(value);
+        else if (strcmp(argv[i], "--signal") == 0) {
+            if (signal_parse_type(value, &signal) != 0) {
+                fprintf(stderr, "Sinal desconhecido: %s\n", value);
+                return 1;
+            }
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+
+    if (min_log2 < BENCH_MIN_LOG2 || max_log2 > BENCH_MAX_LOG2 || min_log2 > max_log2) {
+        fprintf(stderr, "Tamanhos inválidos: use %d <= min-log2 <= max-log2 <= %d.\n", BENCH_MIN_LOG2, BENCH_MAX_LOG2);
+        return 1;
+    }
+    if (num_channels < 1 || num_channels > 64 || sample_rate < 1000 || sample_rate > 768000) {
+        fprintf(stderr, "Canais (1 a 64) ou taxa de amostragem (1000 a 768000 Hz) inválidos.\n");
+        return 1;
+    }
+    for (size_t i = 0; ops_option && i < NUM_BENCH_OPS; i++) {
+        if (op_selected(ops_option, bench_ops[i].name)) break;
+        if (i + 1 == NUM_BENCH_OPS) {
+            fprintf(stderr, "Nenhuma operação conhecida em --ops: %s\n", ops_option);
+            return 1;
+        }
+    }
+
+    char tmp_path[1024];
+    if (tmp_option) {
+        snprintf(tmp_path, sizeof(tmp_path), "%s", tmp_option);
+    } else {
+        const char* tmp_dir = getenv("TMPDIR");
+        snprintf(tmp_path, sizeof(tmp_path), "%s/projeto_audio_bench_%ld.wav",
+                 tmp_dir ? tmp_dir : "/tmp", (long)getpid());
+    }
+
+    thread_pool_init(threads);
+
+    // A tabela vai para stderr quando o JSON ocupa a saída padrão.
+    FILE* table = (json_path && strcmp(json_path, "-") == 0) ? stderr : stdout;
+    fprintf(table, "Precisão %s, SIMD %s, %d thread(s), sinal %s, %ld Hz, %d canal(is)\n",
+            REAL_T_NAME, fft_simd_kernels()->name, thread_pool_size(), signal_type_name(signal),
+            sample_rate, num_channels);
+    fprintf(table, "%-10s %10s %6s %12s %10s %8s %10s\n",
+            "operação", "amostras", "reps", "melhor (ms)", "ns/amostra", "GFLOPS", "pico (KB)");
+
+    size_t max_results = NUM_BENCH_OPS * (size_t)(max_log2 - min_log2 + 1);
+    BenchResult* results = (BenchResult*)calloc(max_results, sizeof(BenchResult));
+    size_t count = 0;
+    int status = 0;
+
+    for (int k = min_log2; k <= max_log2 && status == 0; k++) {
+        BenchContext ctx = { 0 };
+        ctx.n = (size_t)1 << k;
+        ctx.tmp_path = tmp_path;
+        ctx.input = signal_generate(signal, (uint32_t)sample_rate, (uint16_t)num_channels, ctx.n, seed);
+        ctx.work = signal_generate(signal, (uint32_t)sample_rate, (uint16_t)num_channels, ctx.n, seed);
+        if (!ctx.input || !ctx.work) {
+            status = -1;
+        }
+
+        for (size_t i = 0; i < NUM_BENCH_OPS && status == 0; i++) {
+            if (!op_selected(ops_option, bench_ops[i].name)) continue;
+            if (run_op(&bench_ops[i], &ctx, min_time, &results[count]) != 0) {
+                status = -1;
+                break;
+            }
+            print_result(table, &results[count]);
+            fflush(table);
+            count++;
+        }
+        free_wav_data(ctx.input);
+        free_wav_data(ctx.work);
+    }
+    remove(tmp_path);
+
+    if (json_path && count > 0) {
+        FILE* fp = strcmp(json_path, "-") == 0 ? stdout : fopen(json_path, "w");
+        if (!fp) {
+            perror("Erro ao criar o arquivo JSON");
+            status = -1;
+        } else {
+            write_json(fp, results, count, signal_type_name(signal), (uint32_t)sample_rate, (uint16_t)num_channels);
+            if (fp != stdout) fclose(fp);
+        }
+    }
+
+    free(results);
+    thread_pool_shutdown();
+    return status == 0 ? 0 : 1;
+}
@@ -0,0 +1,589 @@
+#include "convolution.h"
+#include "fft.h"
+#include "dsp_operations.h"
+#include "thread_pool.h"
+#include "arena.h"
+#include "trace.h"
+#include <pthread.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Núcleos até este tamanho são aplicados por convolução direta; acima, por FFT.
+#define CONV_DIRECT_MAX_TAPS 64
+// Amostras por bloco na convolução direta.
+#define CONV_DIRECT_BLOCK 256
+// Maior partição quando o chamador não limita a latência: com FFTs de 2^17
+// pontos, um núcleo de 10 s a 48 kHz tem só 8 partições.
+#define CONV_MAX_PARTITION 65536
+// Menor trecho de sinal por thread em convolve. Cada trecho recalcula a cauda
+// de m - 1 amostras, então também precisa ser bem maior que o núcleo.
+#define CONV_MIN_SEGMENT 65536
+#define CONV_SEGMENT_PER_TAP 4
+
+// Faixas de até tantos atrasos são correlacionadas diretamente; acima, por FFT.
+#define XCORR_DIRECT_MAX_LAGS 64
+// Menor bloco de 'b' por FFT na correlação (o bloco cresce com a faixa de atrasos).
+#define XCORR_MIN_BLOCK 4096
+
+// --- Convolução em blocos ---
+
+struct Convolver {
+    size_t kernel_len;
+    size_t block;          // Amostras novas por bloco (B)
+    size_t filled;         // Amostras novas já acumuladas no bloco atual
+    uint64_t consumed;     // Entradas recebidas
+    uint64_t emitted;      // Saídas já entregues
+    real_t* history;       // Direta: kernel_len - 1 antigas + B novas. FFT: bloco anterior + atual (2B)
+
+    // Forma direta
+    real_t* kernel;
+    real_t* output;        // As B saídas do bloco
+
+    // Convolução particionada: P partições de B coeficientes, FFTs reais de 2B pontos
+    FftPlan* plan;
+    size_t num_partitions;
+    Complex* partitions;   // P espectros de B + 1 bins (FFT de cada partição)
+    Complex* spectra;      // Linha de atraso: espectros dos P últimos blocos de entrada
+    size_t head;           // Posição do espectro mais recente em 'spectra'
+    Complex* acc;          // Soma dos produtos; recebe também a saída da IFFT
+};
+
+Convolver* convolver_create(const real_t* kernel, size_t kernel_len, size_t max_partition) {
+    if (kernel_len == 0) return NULL;
+    Convolver* convolver = (Convolver*)calloc(1, sizeof(Convolver));
+    if (!convolver) return NULL;
+    convolver->kernel_len = kernel_len;
+
+    if (kernel_len <= CONV_DIRECT_MAX_TAPS) {
+        convolver->block = CONV_DIRECT_BLOCK;
+        convolver->kernel = (real_t*)malloc(kernel_len * sizeof(real_t));
+        convolver->output = (real_t*)malloc(convolver->block * sizeof(real_t));
+        convolver->history = (real_t*)calloc(kernel_len - 1 + convolver->block, sizeof(real_t));
+        if (!convolver->kernel || !convolver->output || !convolver->history) {
+            convolver_destroy(convolver);
+            return NULL;
+        }
+        memcpy(convolver->kernel, kernel, kernel_len * sizeof(real_t));
+        return convolver;
+    }
+
+    size_t limit = max_partition ? max_partition : CONV_MAX_PARTITION;
+    size_t block = find_next_power_of_2(kernel_len);
+    if (block > limit) block = limit;
+    size_t bins = block + 1;
+    convolver->block = block;
+    convolver->num_partitions = (kernel_len + block - 1) / block;
+    convolver->plan = fft_plan_create_real(2 * block);
+    convolver->history = (real_t*)calloc(2 * block, sizeof(real_t));
+    convolver->partitions = (Complex*)malloc(convolver->num_partitions * bins * sizeof(Complex));
+    convolver->spectra = (Complex*)calloc(convolver->num_partitions * bins, sizeof(Complex));
+    convolver->acc = (Complex*)malloc(bins * sizeof(Complex));
+    if (!convolver->plan || !convolver->history || !convolver->partitions || !convolver->spectra || !convolver->acc) {
+        fprintf(stderr, "Memória insuficiente para um núcleo de %zu amostras.\n", kernel_len);
+        convolver_destroy(convolver);
+        return NULL;
+    }
+
+    // Cada partição, completada com zeros até 2B, vira um espectro fixo.
+    for (size_t p = 0; p < convolver->num_partitions; p++) {
+        Complex* spectrum = convolver->partitions + p * bins;
+        real_t* segment = (real_t*)spectrum;
+        size_t first = p * block;
+        size_t count = (kernel_len - first < block) ? kernel_len - first : block;
+        memcpy(segment, kernel + first, count * sizeof(real_t));
+        memset(segment + count, 0, (2 * block - count) * sizeof(real_t));
+        rfft_execute(convolver->plan, segment, spectrum);
+    }
+    return convolver;
+}
+
+size_t convolver_block_size(const Convolver* convolver) {
+    // Pior caso: um bloco incompleto mais a cauda inteira, no flush.
+    return convolver->block + convolver->kernel_len - 1;
+}
+
+// Convolução direta do bloco acumulado; retorna as B saídas.
+static const real_t* convolver_direct_block(Convolver* convolver) {
+    const size_t taps = convolver->kernel_len;
+    const real_t* h = convolver->kernel;
+    const real_t* x = convolver->history + taps - 1;
+    real_t* y = convolver->output;
+    for (size_t i = 0; i < convolver->block; i++) {
+        real_t sum = 0.0;
+        for (size_t k = 0; k < taps; k++) {
+            sum += h[k] * x[(ptrdiff_t)i - (ptrdiff_t)k];
+        }
+        y[i] = sum;
+    }
+    memmove(convolver->history, convolver->history + convolver->block, (taps - 1) * sizeof(real_t));
+    return y;
+}
+
+// Overlap-save particionado: a FFT do bloco novo entra na linha de atraso e a
+// saída é a soma, em frequência, de cada partição vezes o bloco de mesma idade.
+// Retorna as B saídas, que ficam dentro de 'acc' até o próximo bloco.
+static const real_t* convolver_partitioned_block(Convolver* convolver) {
+    const size_t block = convolver->block;
+    const size_t bins = block + 1;
+    const size_t num_partitions = convolver->num_partitions;
+
+    convolver->head = (convolver->head + 1) % num_partitions;
+    Complex* newest = convolver->spectra + convolver->head * bins;
+    memcpy(newest, convolver->history, 2 * block * sizeof(real_t));
+    rfft_execute(convolver->plan, (const real_t*)newest, newest);
+
+    memset(convolver->acc, 0, bins * sizeof(Complex));
+    for (size_t p = 0; p < num_partitions; p++) {
+        const Complex* x = convolver->spectra + ((convolver->head + num_partitions - p) % num_partitions) * bins;
+        const Complex* h = convolver->partitions + p * bins;
+        for (size_t k = 0; k < bins; k++) {
+            convolver->acc[k].real += x[k].real * h[k].real - x[k].imag * h[k].imag;
+            convolver->acc[k].imag += x[k].real * h[k].imag + x[k].imag * h[k].real;
+        }
+    }
+    real_t* samples = (real_t*)convolver->acc;
+    irfft_execute(convolver->plan, convolver->acc, samples);
+
+    // Só a segunda metade está livre do efeito da convolução circular.
+    memcpy(convolver->history, convolver->history + block, block * sizeof(real_t));
+    return samples + block;
+}
+
+// Processa o bloco completo e entrega as 'count' (<= B) primeiras saídas.
+static size_t convolver_run_block(Convolver* convolver, real_t* out, size_t count) {
+    const real_t* y = convolver->plan ? convolver_partitioned_block(convolver) : convolver_direct_block(convolver);
+    memcpy(out, y, count * sizeof(real_t));
+    convolver->emitted += count;
+    convolver->filled = 0;
+    return count;
+}
+
+// Onde entra a próxima amostra nova em 'history'.
+static real_t* convolver_input_slot(Convolver* convolver) {
+    size_t offset = convolver->plan ? convolver->block : convolver->kernel_len - 1;
+    return convolver->history + offset + convolver->filled;
+}
+
+size_t convolver_process(Convolver* convolver, const real_t* in, size_t n, real_t* out) {
+    size_t produced = 0;
+    size_t i = 0;
+    while (i < n) {
+        size_t take = convolver->block - convolver->filled;
+        if (take > n - i) take = n - i;
+        memcpy(convolver_input_slot(convolver), in + i, take * sizeof(real_t));
+        convolver->filled += take;
+        convolver->consumed += take;
+        i += take;
+        if (convolver->filled == convolver->block) {
+            produced += convolver_run_block(convolver, out + produced, convolver->block);
+        }
+    }
+    return produced;
+}
+
+size_t convolver_flush(Convolver* convolver, real_t* out) {
+    uint64_t total = convolver->consumed + convolver->kernel_len - 1;
+    size_t produced = 0;
+    // Alimenta zeros até que a cauda inteira tenha saído.
+    while (convolver->emitted < total) {
+        memset(convolver_input_slot(convolver), 0, (convolver->block - convolver->filled) * sizeof(real_t));
+        uint64_t left = total - convolver->emitted;
+        size_t count = (left < convolver->block) ? (size_t)left : convolver->block;
+        produced += convolver_run_block(convolver, out + produced, count);
+    }
+    return produced;
+}
+
+void convolver_destroy(Convolver* convolver) {
+    if (convolver) {
+        free(convolver->kernel);
+        free(convolver->output);
+        free(convolver->history);
+        fft_plan_destroy(convolver->plan);
+        free(convolver->partitions);
+        free(convolver->spectra);
+        free(convolver->acc);
+        free(convolver);
+    }
+}
+
+// --- Convolução de um sinal inteiro ---
+
+// Cada trecho [begin, end) de x é convoluído por uma thread. As saídas até 'end'
+// vão direto para y; a cauda, que se sobrepõe ao trecho seguinte, é guardada e
+// somada depois, em série (overlap-add entre os trechos).
+typedef struct {
+    const real_t* x;
+    size_t n;
+    const real_t* h;
+    size_t m;
+    real_t* y;
+    size_t num_segments;
+    real_t** tails;           // m - 1 amostras por trecho (exceto o último)
+    int failed;
+} ConvolvePass;
+
+static void convolve_segments(size_t begin, size_t end, void* ctx) {
+    ConvolvePass* pass = (ConvolvePass*)ctx;
+    for (size_t s = begin; s < end; s++) {
+        size_t first = pass->n * s / pass->num_segments;
+        size_t last = pass->n * (s + 1) / pass->num_segments;
+        Convolver* convolver = convolver_create(pass->h, pass->m, 0);
+        if (!convolver) {
+            pass->failed = 1;
+            continue;
+        }
+
+        real_t* y = pass->y + first;
+        size_t produced = convolver_process(convolver, pass->x + first, last - first, y);
+        if (s + 1 == pass->num_segments) {
+            convolver_flush(convolver, y + produced);
+        } else {
+            ArenaMark mark = arena_mark();
+            real_t* rest = (real_t*)arena_alloc(convolver_block_size(convolver) * sizeof(real_t));
+            if (!rest) {
+                pass->failed = 1;
+                arena_release(mark);
+                convolver_destroy(convolver);
+                continue;
+            }
+            convolver_flush(convolver, rest);
+            size_t own = (last - first) - produced;
+            memcpy(y + produced, rest, own * sizeof(real_t));
+            memcpy(pass->tails[s], rest + own, (pass->m - 1) * sizeof(real_t));
+            arena_release(mark);
+        }
+        convolver_destroy(convolver);
+    }
+}
+
+int convolve(const real_t* x, size_t n, const real_t* h, size_t m, real_t* y) {
+    if (n == 0 || m == 0) {
+        fprintf(stderr, "Convolução com sinal vazio.\n");
+        return -1;
+    }
+    // A convolução é comutativa: o mais curto vira o núcleo.
+    if (m > n) {
+        const real_t* swap = x;
+        x = h;
+        h = swap;
+        size_t swap_len = n;
+        n = m;
+        m = swap_len;
+    }
+
+    size_t min_segment = (CONV_SEGMENT_PER_TAP * m > CONV_MIN_SEGMENT) ? CONV_SEGMENT_PER_TAP * m : CONV_MIN_SEGMENT;
+    size_t num_segments = n / min_segment;
+    if (num_segments > (size_t)thread_pool_size()) num_segments = (size_t)thread_pool_size();
+    if (num_segments < 1) num_segments = 1;
+
+    ConvolvePass pass = { x, n, h, m, y, num_segments, NULL, 0 };
+    pass.tails = (real_t**)calloc(num_segments, sizeof(real_t*));
+    for (size_t s = 0; s + 1 < num_segments; s++) {
+        pass.tails[s] = (real_t*)malloc((m > 1 ? m - 1 : 1) * sizeof(real_t));
+        if (!pass.tails[s]) pass.failed = 1;
+    }
+    if (!pass.failed) parallel_for(num_segments, 1, convolve_segments, &pass);
+
+    for (size_t s = 0; s + 1 < num_segments; s++) {
+        if (!pass.failed) {
+            real_t* out = y + n * (s + 1) / num_segments;
+            for (size_t k = 0; k + 1 < m; k++) {
+                out[k] += pass.tails[s][k];
+            }
+        }
+        free(pass.tails[s]);
+    }
+    free(pass.tails);
+    if (pass.failed) fprintf(stderr, "Memória insuficiente para a convolução.\n");
+    return pass.failed ? -1 : 0;
+}
+
+// --- Correlação cruzada ---
+
+typedef struct {
+    const real_t* a;
+    size_t na;
+    const real_t* b;
+    size_t nb;
+    size_t max_lag;
+    real_t* r;
+
+    // Por FFT
+    size_t fft_size;          // N >= B + 2 * max_lag
+    size_t block;             // B: amostras de 'b' por FFT
+    double* acc;              // Soma dos espectros cruzados (N/2 + 1 bins, real e imag)
+    pthread_mutex_t lock;
+    int failed;
+} CorrelationPass;
+
+static void correlate_direct(size_t begin, size_t end, void* ctx) {
+    CorrelationPass* pass = (CorrelationPass*)ctx;
+    for (size_t j = begin; j < end; j++) {
+        int64_t lag = (int64_t)j - (int64_t)pass->max_lag;
+        // t e t + lag dentro dos dois sinais.
+        int64_t first = (lag < 0) ? -lag : 0;
+        int64_t last = (int64_t)pass->na - lag;
+        if (last > (int64_t)pass->nb) last = (int64_t)pass->nb;
+        double sum = 0.0;
+        for (int64_t t = first; t < last; t++) {
+            sum += (double)pass->a[t + lag] * pass->b[t];
+        }
+        pass->r[j] = (real_t)sum;
+    }
+}
+
+// Blocos [begin, end) de 'b': para o bloco em s, o trecho a[s - L, s + B + L)
+// contém todos os produtos com atraso em [-L, L], e a correlação circular de N
+// pontos dos dois não dá a volta. Os espectros A * conj(B) de todos os blocos
+// somam-se na mesma posição, e uma IFFT final dá r.
+static void correlate_blocks(size_t begin, size_t end, void* ctx) {
+    CorrelationPass* pass = (CorrelationPass*)ctx;
+    const size_t fft_size = pass->fft_size;
+    const size_t bins = fft_size / 2 + 1;
+    ArenaMark mark = arena_mark();
+    Complex* spectrum_a = (Complex*)arena_alloc(bins * sizeof(Complex));
+    Complex* spectrum_b = (Complex*)arena_alloc(bins * sizeof(Complex));
+    double* acc = (double*)arena_alloc(2 * bins * sizeof(double));
+    if (!spectrum_a || !spectrum_b || !acc) {
+        pass->failed = 1;
+        arena_release(mark);
+        return;
+    }
+    memset(acc, 0, 2 * bins * sizeof(double));
+
+    for (size_t blk = begin; blk < end; blk++) {
+        size_t start = blk * pass->block;
+        size_t count = (pass->nb - start < pass->block) ? pass->nb - start : pass->block;
+
+        real_t* segment = (real_t*)spectrum_a;
+        memset(segment, 0, fft_size * sizeof(real_t));
+        int64_t from = (int64_t)start - (int64_t)pass->max_lag;
+        int64_t to = (int64_t)(start + count + pass->max_lag);
+        if (to > (int64_t)pass->na) to = (int64_t)pass->na;
+        int64_t skip = (from < 0) ? -from : 0;
+        if (from + skip < to) {
+            memcpy(segment + skip, pass->a + from + skip, (size_t)(to - from - skip) * sizeof(real_t));
+        }
+        real_t* samples = (real_t*)spectrum_b;
+        memcpy(samples, pass->b + start, count * sizeof(real_t));
+        memset(samples + count, 0, (fft_size - count) * sizeof(real_t));
+        if (rfft(segment, spectrum_a, fft_size) != 0 || rfft(samples, spectrum_b, fft_size) != 0) {
+            pass->failed = 1;
+            break;
+        }
+
+        for (size_t k = 0; k < bins; k++) {
+            acc[2 * k] += (double)spectrum_a[k].real * spectrum_b[k].real + (double)spectrum_a[k].imag * spectrum_b[k].imag;
+            acc[2 * k + 1] += (double)spectrum_a[k].imag * spectrum_b[k].real - (double)spectrum_a[k].real * spectrum_b[k].imag;
+        }
+    }
+
+    pthread_mutex_lock(&pass->lock);
+    for (size_t k = 0; k < 2 * bins; k++) {
+        pass->acc[k] += acc[k];
+    }
+    pthread_mutex_unlock(&pass->lock);
+    arena_release(mark);
+}
+
+int cross_correlate(const real_t* a, size_t na, const real_t* b, size_t nb, size_t max_lag, real_t* r) {
+    if (na == 0 || nb == 0) {
+        fprintf(stderr, "Correlação com sinal vazio.\n");
+        return -1;
+    }
+    size_t num_lags = 2 * max_lag + 1;
+    CorrelationPass pass = { a, na, b, nb, max_lag, r, 0, 0, NULL, PTHREAD_MUTEX_INITIALIZER, 0 };
+
+    if (num_lags <= XCORR_DIRECT_MAX_LAGS) {
+        parallel_for(num_lags, 1, correlate_direct, &pass);
+        return 0;
+    }
+
+    // O bloco acompanha a faixa de atrasos, para que cada FFT renda ao menos
+    // metade de amostras novas de 'b'.
+    size_t block = (2 * max_lag > XCORR_MIN_BLOCK) ? 2 * max_lag : XCORR_MIN_BLOCK;
+    pass.fft_size = fft_next_fast_size(block + 2 * max_lag);
+    pass.block = pass.fft_size - 2 * max_lag;
+    size_t bins = pass.fft_size / 2 + 1;
+    size_t num_blocks = (nb + pass.block - 1) / pass.block;
+    pass.acc = (double*)calloc(2 * bins, sizeof(double));
+    if (!pass.acc) {
+        fprintf(stderr, "Memória insuficiente para a correlação.\n");
+        return -1;
+    }
+
+    parallel_for(num_blocks, 1, correlate_blocks, &pass);
+    if (!pass.failed) {
+        ArenaMark mark = arena_mark();
+        Complex* spectrum = (Complex*)arena_alloc(bins * sizeof(Complex));
+        if (spectrum) {
+            for (size_t k = 0; k < bins; k++) {
+                spectrum[k].real = (real_t)pass.acc[2 * k];
+                spectrum[k].imag = (real_t)pass.acc[2 * k + 1];
+            }
+            real_t* circular = (real_t*)spectrum;
+            if (irfft(spectrum, circular, pass.fft_size) == 0) {
+                memcpy(r, circular, num_lags * sizeof(real_t));
+            } else {
+                pass.failed = 1;
+            }
+        } else {
+            pass.failed = 1;
+        }
+        arena_release(mark);
+    }
+    free(pass.acc);
+    pthread_mutex_destroy(&pass.lock);
+    if (pass.failed) fprintf(stderr, "Memória insuficiente para a correlação.\n");
+    return pass.failed ? -1 : 0;
+}
+
+static double energy(const real_t* x, size_t n) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        sum += (double)x[i] * x[i];
+    }
+    return sum;
+}
+
+int find_correlation_peak(const real_t* a, size_t na, const real_t* b, size_t nb, size_t max_lag,
+                          CorrelationPeak* peak) {
+    real_t* r = (real_t*)malloc((2 * max_lag + 1) * sizeof(real_t));
+    if (!r) {
+        fprintf(stderr, "Memória insuficiente para a correlação.\n");
+        return -1;
+    }
+    TRACE_ALLOC((2 * max_lag + 1) * sizeof(real_t));
+    if (cross_correlate(a, na, b, nb, max_lag, r) != 0) {
+        free(r);
+        return -1;
+    }
+
+    size_t best = 0;
+    for (size_t j = 1; j < 2 * max_lag + 1; j++) {
+        if (fabs((double)r[j]) > fabs((double)r[best])) best = j;
+    }
+    peak->lag = (int64_t)best - (int64_t)max_lag;
+    peak->value = r[best];
+    double norm = sqrt(energy(a, na) * energy(b, nb));
+    peak->coefficient = (norm > 0.0) ? peak->value / norm : 0.0;
+    free(r);
+    return 0;
+}
+
+// --- Sinal inteiro em memória ---
+
+typedef struct {
+    const WavData* wav_data;
+    const WavData* impulse;
+    WavData* output;
+    int failed;
+} ConvolveAudioPass;
+
+static void convolve_channels(size_t begin, size_t end, void* ctx) {
+    ConvolveAudioPass* pass = (ConvolveAudioPass*)ctx;
+    for (size_t c = begin; c < end; c++) {
+        const real_t* h = wav_channel(pass->impulse, (uint16_t)(c % pass->impulse->num_channels));
+        if (convolve(wav_channel(pass->wav_data, (uint16_t)c), pass->wav_data->num_samples,
+                     h, pass->impulse->num_samples, wav_channel(pass->output, (uint16_t)c)) != 0) {
+            pass->failed = 1;
+        }
+    }
+}
+
+WavData* convolve_audio(const WavData* wav_data, const WavData* impulse) {
+    if (wav_data->num_samples == 0 || impulse->num_samples == 0) {
+        fprintf(stderr, "Convolução com sinal vazio.\n");
+        return NULL;
+    }
+    WavData* converted = NULL;
+    if (impulse->sample_rate != wav_data->sample_rate) {
+        converted = resample_audio(impulse, wav_data->sample_rate);
+        if (!converted) return NULL;
+        impulse = converted;
+    }
+
+    size_t num_samples = (size_t)wav_data->num_samples + impulse->num_samples - 1;
+    if (num_samples > UINT32_MAX) {
+        fprintf(stderr, "Saída da convolução longa demais para um WAV.\n");
+        free_wav_data(converted);
+        return NULL;
+    }
+
+    TRACE_BEGIN(span, "convolve");
+    WavData* output = (WavData*)malloc(sizeof(WavData));
+    if (!output) {
+        fprintf(stderr, "Memória insuficiente para a convolução.\n");
+        free_wav_data(converted);
+        return NULL;
+    }
+    *output = *wav_data;
+    output->num_samples = (uint32_t)num_samples;
+    output->data_size = output->num_samples * output->num_channels * (output->bits_per_sample / 8);
+    output->samples = (real_t*)malloc(num_samples * output->num_channels * sizeof(real_t));
+    if (!output->samples) {
+        fprintf(stderr, "Memória insuficiente para a convolução.\n");
+        free(output);
+        free_wav_data(converted);
+        return NULL;
+    }
+    TRACE_ALLOC(num_samples * output->num_channels * sizeof(real_t));
+
+    // Cada canal já se divide entre as threads em convolve.
+    ConvolveAudioPass pass = { wav_data, impulse, output, 0 };
+    parallel_tasks(wav_data->num_channels, convolve_channels, &pass);
+    TRACE_END(span, (size_t)wav_data->num_samples * wav_data->num_channels * sizeof(real_t));
+    free_wav_data(converted);
+    if (pass.failed) {
+        free_wav_data(output);
+        return NULL;
+    }
+    return output;
+}
+
+// Soma dos canais, para correlacionar o conteúdo e não um canal em particular.
+static real_t* downmix(const WavData* wav_data) {
+    real_t* mono = (real_t*)calloc(wav_data->num_samples ? wav_data->num_samples : 1, sizeof(real_t));
+    if (!mono) return NULL;
+    for (uint16_t c = 0; c < wav_data->num_channels; c++) {
+        const real_t* channel = wav_channel(wav_data, c);
+        for (uint32_t i = 0; i < wav_data->num_samples; i++) {
+            mono[i] += channel[i];
+        }
+    }
+    return mono;
+}
+
+int find_alignment(const WavData* reference, const WavData* other, double max_lag_s, CorrelationPeak* peak) {
+    WavData* converted = NULL;
+    if (other->sample_rate != reference->sample_rate) {
+        converted = resample_audio(other, reference->sample_rate);
+        if (!converted) return -1;
+        other = converted;
+    }
+
+    // Atrasos além do sinal mais longo só teriam produtos nulos.
+    size_t longest = (reference->num_samples > other->num_samples) ? reference->num_samples : other->num_samples;
+    size_t max_lag = longest > 0 ? longest - 1 : 0;
+    if (max_lag_s > 0.0 && max_lag_s * reference->sample_rate < (double)max_lag) {
+        max_lag = (size_t)llround(max_lag_s * reference->sample_rate);
+    }
+
+    TRACE_BEGIN(span, "xcorr");
+    real_t* a = downmix(reference);
+    real_t* b = downmix(other);
+    int status = -1;
+    if (a && b) {
+        status = find_correlation_peak(a, reference->num_samples, b, other->num_samples, max_lag, peak);
+    } else {
+        fprintf(stderr, "Memória insuficiente para a correlação.\n");
+    }
+    TRACE_END(span, ((size_t)reference->num_samples + other->num_samples) * sizeof(real_t));
+    free(a);
+    free(b);
+    free_wav_data(converted);
+    return status;
+}
@@ -0,0 +1,71 @@
+#ifndef PROJETO_AUDIO_CONVOLUTION_H
+#define PROJETO_AUDIO_CONVOLUTION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "precision.h"
+#include "wav_handler.h"
+
+// Convolução linear e correlação cruzada sobre fft.h. A escolha entre a conta
+// direta e a feita por FFT é automática, pelo tamanho: núcleos (ou faixas de
+// atraso) curtos são aplicados diretamente; os longos, por FFT, com custo
+// O(log) por amostra em vez de O(tamanho do núcleo).
+
+// --- Convolução em blocos ---
+// Overlap-save particionado uniformemente: o núcleo é dividido em P partições
+// de B coeficientes, cada uma com seu espectro fixo, e cada bloco de B amostras
+// novas entra numa linha de atraso de espectros. B é a menor potência de 2 que
+// cobre o núcleo, limitada por 'max_partition' (a latência interna; 0 = o
+// limite padrão, para uso offline). Segue o contrato dos filtros em blocos de
+// dsp_operations.h (*_process / *_flush / *_block_size), exceto que a saída é a
+// convolução completa: no total, n + kernel_len - 1 amostras, sem compensação
+// de atraso. O núcleo é copiado; NULL em erro.
+typedef struct Convolver Convolver;
+Convolver* convolver_create(const real_t* kernel, size_t kernel_len, size_t max_partition);
+size_t convolver_block_size(const Convolver* convolver);
+size_t convolver_process(Convolver* convolver, const real_t* in, size_t n, real_t* out);
+size_t convolver_flush(Convolver* convolver, real_t* out);
+void convolver_destroy(Convolver* convolver);
+
+// Convolução linear completa de x (n amostras) com h (m amostras): escreve
+// n + m - 1 amostras em 'y', que não pode coincidir com 'x' nem com 'h'. O sinal
+// é dividido em trechos convoluídos em paralelo (thread_pool.h), e o mais curto
+// dos dois faz o papel de núcleo. Retorna 0 ou -1.
+int convolve(const real_t* x, size_t n, const real_t* h, size_t m, real_t* y);
+
+// --- Correlação cruzada ---
+
+// r[k] = soma_t a[t + k] * b[t], para os atrasos k em [-max_lag, max_lag]:
+// 'r' recebe 2 * max_lag + 1 valores, r[0] sendo o atraso -max_lag. Um atraso
+// positivo quer dizer que o conteúdo de 'b' aparece em 'a' k amostras depois.
+// Faixas curtas são calculadas diretamente; as longas, por blocos de FFT cujos
+// espectros cruzados são acumulados (uma única IFFT no fim), com memória
+// O(max_lag) qualquer que seja a duração. Retorna 0 ou -1.
+int cross_correlate(const real_t* a, size_t na, const real_t* b, size_t nb, size_t max_lag, real_t* r);
+
+typedef struct {
+    int64_t lag;              // Atraso do pico, em amostras (ver cross_correlate)
+    double value;             // Correlação no pico (com sinal: negativa = polaridade invertida)
+    double coefficient;       // value / sqrt(energia de a * energia de b), em [-1, 1]
+} CorrelationPeak;
+
+// Atraso de maior |correlação| entre os dois sinais, procurado em
+// [-max_lag, max_lag]. Retorna 0 ou -1.
+int find_correlation_peak(const real_t* a, size_t na, const real_t* b, size_t nb, size_t max_lag,
+                          CorrelationPeak* peak);
+
+// --- Sinal inteiro em memória ---
+
+// Convolui cada canal com uma resposta ao impulso (ex.: reverb). O canal c usa
+// o canal c % impulse->num_channels da resposta, que é convertida para a taxa
+// do sinal se preciso. A saída tem os canais e o formato de 'wav_data' e
+// impulse->num_samples - 1 amostras a mais (a cauda). NULL em erro.
+WavData* convolve_audio(const WavData* wav_data, const WavData* impulse);
+
+// Atraso de 'other' em relação a 'reference' (canais somados), procurado em
+// até 'max_lag_s' segundos para cada lado; 'other' é convertido para a taxa de
+// 'reference' se preciso. Para alinhar, atrase 'other' de peak->lag amostras
+// (o deslocamento de mixer.h). Retorna 0 ou -1.
+int find_alignment(const WavData* reference, const WavData* other, double max_lag_s, CorrelationPeak* peak);
+
+#endif //PROJETO_AUDIO_CONVOLUTION_H
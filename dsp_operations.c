@@ -1,5 +1,10 @@
 #include "dsp_operations.h"
 #include "fft.h" // ADICIONADO: Para conhecer 'Complex', 'fft' e 'ifft'
+#include "thread_pool.h"
+#include "arena.h"
+#include "resampler.h"
+#include "moving_stats.h"
+#include "trace.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
@@ -13,116 +18,516 @@ size_t find_next_power_of_2(size_t n) {
     return power;
 }
 
+// Contexto da mixagem: cada tarefa soma um canal de saída e guarda seu pico.
+typedef struct {
+    const WavData* wav1;
+    const WavData* wav2;
+    WavData* mixed;
+    double* channel_peaks;
+    double norm_factor;
+} MixPass;
+
+// Canal de 'wav' usado para o canal de saída 'c': se a entrada tiver menos
+// canais (ex.: mono mixado com estéreo), seus canais são repetidos.
+static const real_t* mix_source_channel(const WavData* wav, uint16_t c) {
+    return wav_channel(wav, (uint16_t)(c % wav->num_channels));
+}
+
+static void mix_channels(size_t begin, size_t end, void* ctx) {
+    MixPass* pass = (MixPass*)ctx;
+    for (size_t c = begin; c < end; c++) {
+        const real_t* in1 = mix_source_channel(pass->wav1, (uint16_t)c);
+        const real_t* in2 = mix_source_channel(pass->wav2, (uint16_t)c);
+        real_t* out = wav_channel(pass->mixed, (uint16_t)c);
+        uint32_t max_samples = pass->mixed->num_samples;
+
+        double max_abs_val = 0.0;
+        for (uint32_t i = 0; i < max_samples; i++) {
+            real_t s1 = (i < pass->wav1->num_samples) ? in1[i] : 0.0;
+            real_t s2 = (i < pass->wav2->num_samples) ? in2[i] : 0.0;
+            out[i] = s1 + s2;
+            if (fabs(out[i]) > max_abs_val) {
+                max_abs_val = fabs(out[i]);
+            }
+        }
+        pass->channel_peaks[c] = max_abs_val;
+    }
+}
+
+static void normalize_channels(size_t begin, size_t end, void* ctx) {
+    MixPass* pass = (MixPass*)ctx;
+    for (size_t c = begin; c < end; c++) {
+        real_t* out = wav_channel(pass->mixed, (uint16_t)c);
+        for (uint32_t i = 0; i < pass->mixed->num_samples; i++) {
+            out[i] *= pass->norm_factor;
+        }
+    }
+}
+
+// Conversão de taxa de um sinal inteiro; cada canal pode rodar numa thread.
+typedef struct {
+    const WavData* in;
+    WavData* out;
+    int failed;
+} ResamplePass;
+
+static void resample_channels(size_t begin, size_t end, void* ctx) {
+    ResamplePass* pass = (ResamplePass*)ctx;
+    for (size_t c = begin; c < end; c++) {
+        Resampler* resampler = resampler_create(pass->in->sample_rate, pass->out->sample_rate);
+        if (!resampler) {
+            pass->failed = 1;
+            continue;
+        }
+        real_t* out = wav_channel(pass->out, (uint16_t)c);
+        size_t produced = resampler_process(resampler, wav_channel(pass->in, (uint16_t)c), pass->in->num_samples, out);
+        resampler_flush(resampler, out + produced);
+        if (resampler_failed(resampler)) pass->failed = 1;
+        resampler_destroy(resampler);
+    }
+}
+
+WavData* resample_audio(const WavData* wav_data, uint32_t sample_rate) {
+    size_t num_samples = resampler_output_length(wav_data->sample_rate, sample_rate, wav_data->num_samples);
+    if (sample_rate == 0 || num_samples > UINT32_MAX) {
+        fprintf(stderr, "Taxa de amostragem inválida: %u Hz.\n", sample_rate);
+        return NULL;
+    }
+
+    TRACE_BEGIN(span, "resample");
+    WavData* resampled = (WavData*)malloc(sizeof(WavData));
+    *resampled = *wav_data;
+    resampled->sample_rate = sample_rate;
+    resampled->num_samples = (uint32_t)num_samples;
+    resampled->data_size = resampled->num_samples * resampled->num_channels * (resampled->bits_per_sample / 8);
+    resampled->samples = (real_t*)malloc((num_samples ? num_samples : 1) * wav_data->num_channels * sizeof(real_t));
+    if (!resampled->samples) {
+        fprintf(stderr, "Memória insuficiente para a conversão de taxa.\n");
+        free(resampled);
+        return NULL;
+    }
+    TRACE_ALLOC(num_samples * wav_data->num_channels * sizeof(real_t));
+
+    ResamplePass pass = { wav_data, resampled, 0 };
+    parallel_for(wav_data->num_channels, 1, resample_channels, &pass);
+    TRACE_END(span, (size_t)wav_data->num_samples * wav_data->num_channels * sizeof(real_t));
+    if (pass.failed) {
+        free_wav_data(resampled);
+        return NULL;
+    }
+    return resampled;
+}
+
 WavData* mix_audio(const WavData* wav1, const WavData* wav2) {
+    // A segunda entrada é levada para a taxa da primeira.
+    WavData* converted = NULL;
+    if (wav2->sample_rate != wav1->sample_rate) {
+        converted = resample_audio(wav2, wav1->sample_rate);
+        if (!converted) return NULL;
+        wav2 = converted;
+    }
+
+    TRACE_BEGIN(span, "mix");
     uint32_t max_samples = (wav1->num_samples > wav2->num_samples) ? wav1->num_samples : wav2->num_samples;
+    uint16_t num_channels = (wav1->num_channels > wav2->num_channels) ? wav1->num_channels : wav2->num_channels;
 
     WavData* mixed_wav = (WavData*)malloc(sizeof(WavData));
 
     mixed_wav->sample_rate = wav1->sample_rate;
-    mixed_wav->num_channels = wav1->num_channels;
+    mixed_wav->num_channels = num_channels;
     mixed_wav->bits_per_sample = wav1->bits_per_sample;
+    mixed_wav->format = wav1->format;
     mixed_wav->num_samples = max_samples;
     mixed_wav->data_size = max_samples * mixed_wav->num_channels * (mixed_wav->bits_per_sample / 8);
 
-    mixed_wav->data_double = (double*)calloc(max_samples, sizeof(double));
+    mixed_wav->samples = (real_t*)calloc((size_t)max_samples * num_channels, sizeof(real_t));
+    TRACE_ALLOC((size_t)max_samples * num_channels * sizeof(real_t));
 
-    for (uint32_t i = 0; i < max_samples; i++) {
-        double s1 = (i < wav1->num_samples) ? wav1->data_double[i] : 0.0;
-        double s2 = (i < wav2->num_samples) ? wav2->data_double[i] : 0.0;
-        mixed_wav->data_double[i] = s1 + s2;
-    }
+    double* channel_peaks = (double*)calloc(num_channels, sizeof(double));
+    MixPass pass = { wav1, wav2, mixed_wav, channel_peaks, 1.0 };
+    parallel_for(num_channels, 1, mix_channels, &pass);
 
+    // Um único fator para todos os canais preserva o balanço entre eles.
     double max_abs_val = 0.0;
-    for (uint32_t i = 0; i < max_samples; i++) {
-        if (fabs(mixed_wav->data_double[i]) > max_abs_val) {
-            max_abs_val = fabs(mixed_wav->data_double[i]);
+    for (uint16_t c = 0; c < num_channels; c++) {
+        if (channel_peaks[c] > max_abs_val) {
+            max_abs_val = channel_peaks[c];
         }
     }
 
     if (max_abs_val > 1.0) {
-        double norm_factor = 1.0 / max_abs_val;
-        for (uint32_t i = 0; i < max_samples; i++) {
-            mixed_wav->data_double[i] *= norm_factor;
-        }
+        pass.norm_factor = 1.0 / max_abs_val;
+        parallel_for(num_channels, 1, normalize_channels, &pass);
     }
+    free(channel_peaks);
+    free_wav_data(converted);
+    TRACE_END(span, (size_t)max_samples * num_channels * sizeof(real_t));
     return mixed_wav;
 }
 
-void apply_fft_filter(WavData* wav_data, double cutoff_freq, int is_high_pass) {
-    size_t original_size = wav_data->num_samples;
-    size_t fft_size = find_next_power_of_2(original_size);
+// Contexto do laço de mascaramento, dividido entre as threads por faixas de bins.
+typedef struct {
+    Complex* spectrum;
+    size_t fft_size;
+    uint32_t sample_rate;
+    double cutoff_freq;
+    int is_high_pass;
+} FftMaskPass;
 
-    Complex* spectrum = (Complex*)calloc(fft_size, sizeof(Complex));
-    for(size_t i = 0; i < original_size; i++) {
-        spectrum[i].real = wav_data->data_double[i];
-        spectrum[i].imag = 0.0;
-    }
-
-    fft(spectrum, fft_size);
-
-    for (size_t k = 0; k < fft_size / 2 + 1; k++) {
-        double freq = (double)k * wav_data->sample_rate / fft_size;
+static void fft_mask_bins(size_t begin, size_t end, void* ctx) {
+    FftMaskPass* pass = (FftMaskPass*)ctx;
+    for (size_t k = begin; k < end; k++) {
+        double freq = (double)k * pass->sample_rate / pass->fft_size;
         int should_zero = 0;
-        if (is_high_pass) {
-            if (freq < cutoff_freq) should_zero = 1;
+        if (pass->is_high_pass) {
+            if (freq < pass->cutoff_freq) should_zero = 1;
         } else {
-            if (freq > cutoff_freq) should_zero = 1;
+            if (freq > pass->cutoff_freq) should_zero = 1;
         }
 
         if (should_zero) {
-            spectrum[k].real = 0;
-            spectrum[k].imag = 0;
-            if (k > 0 && k < fft_size / 2) {
-                spectrum[fft_size - k].real = 0;
-                spectrum[fft_size - k].imag = 0;
-            }
+            pass->spectrum[k].real = 0;
+            pass->spectrum[k].imag = 0;
         }
     }
+}
+
+// Filtra um único canal de 'length' amostras, no lugar. -1 se faltar memória.
+static int fft_filter_channel(real_t* channel, size_t length, uint32_t sample_rate,
+                              double cutoff_freq, int is_high_pass) {
+    size_t fft_size = fft_next_fast_size(length);
+    size_t num_bins = fft_size / 2 + 1;
+
+    // O sinal é real: a FFT real trabalha no próprio buffer do espectro,
+    // que guarda só os bins não redundantes (metade da memória da FFT complexa).
+    // O buffer vem da arena da thread e é reaproveitado pelo próximo canal/arquivo.
+    ArenaMark mark = arena_mark();
+    Complex* spectrum = (Complex*)arena_alloc(num_bins * sizeof(Complex));
+    if (!spectrum) {
+        fprintf(stderr, "Memória insuficiente para o filtro FFT.\n");
+        arena_release(mark);
+        return -1;
+    }
+    real_t* samples = (real_t*)spectrum;
+    memcpy(samples, channel, length * sizeof(real_t));
+    memset(samples + length, 0, (num_bins * 2 - length) * sizeof(real_t));
+
+    TRACE_BEGIN(forward, "fft_forward");
+    int status = rfft(samples, spectrum, fft_size);
+    TRACE_END(forward, fft_size * sizeof(real_t));
+    if (status != 0) {
+        arena_release(mark);
+        return -1;
+    }
+
+    TRACE_BEGIN(masking, "fft_mask");
+    FftMaskPass mask = { spectrum, fft_size, sample_rate, cutoff_freq, is_high_pass };
+    parallel_for(num_bins, 65536, fft_mask_bins, &mask);
+    TRACE_END(masking, num_bins * sizeof(Complex));
 
-    ifft(spectrum, fft_size);
+    TRACE_BEGIN(inverse, "fft_inverse");
+    status = irfft(spectrum, samples, fft_size);
+    TRACE_END(inverse, fft_size * sizeof(real_t));
+
+    // Em erro, o canal fica como estava.
+    if (status == 0) memcpy(channel, samples, length * sizeof(real_t));
+    arena_release(mark);
+    return status;
+}
 
-    for (size_t i = 0; i < original_size; i++) {
-        wav_data->data_double[i] = spectrum[i].real;
+// Contexto comum às operações aplicadas canal a canal.
+typedef struct {
+    WavData* wav_data;
+    double cutoff_freq;
+    int is_high_pass;
+    int window_size;
+    int failed;
+} ChannelPass;
+
+static void fft_filter_channels(size_t begin, size_t end, void* ctx) {
+    ChannelPass* pass = (ChannelPass*)ctx;
+    for (size_t c = begin; c < end; c++) {
+        if (fft_filter_channel(wav_channel(pass->wav_data, (uint16_t)c), pass->wav_data->num_samples,
+                               pass->wav_data->sample_rate, pass->cutoff_freq, pass->is_high_pass) != 0) {
+            pass->failed = 1;
+        }
     }
+}
 
-    free(spectrum);
+// Os canais são independentes: com canais suficientes, cada thread filtra um;
+// senão, um canal por vez, com a FFT paralela.
+int apply_fft_filter(WavData* wav_data, double cutoff_freq, int is_high_pass) {
+    ChannelPass pass = { wav_data, cutoff_freq, is_high_pass, 0, 0 };
+    parallel_tasks(wav_data->num_channels, fft_filter_channels, &pass);
+    return pass.failed ? -1 : 0;
+}
+
+// In-place: a janela fica no anel de MovingStats, sem cópia do canal inteiro.
+static void sma_filter_channel(real_t* channel, uint32_t num_samples, int window_size) {
+    MovingStatsConfig config = { MOVING_MEAN, (size_t)window_size, 0.0, 0.0, 0 };
+    MovingStats* stats = moving_stats_create(&config);
+    if (!stats) return;
+    MovingStatsOutput out = { channel, NULL, NULL, NULL, NULL };
+    moving_stats_process(stats, channel, num_samples, &out);
+    moving_stats_destroy(stats);
+}
+
+static void sma_filter_channels(size_t begin, size_t end, void* ctx) {
+    ChannelPass* pass = (ChannelPass*)ctx;
+    for (size_t c = begin; c < end; c++) {
+        sma_filter_channel(wav_channel(pass->wav_data, (uint16_t)c), pass->wav_data->num_samples, pass->window_size);
+    }
 }
 
 void apply_sma_filter(WavData* wav_data, int window_size) {
     if (window_size <= 1) return;
 
-    double* temp_buffer = (double*)malloc(wav_data->num_samples * sizeof(double));
-    double sum = 0.0;
+    TRACE_BEGIN(span, "sma");
+    ChannelPass pass = { wav_data, 0.0, 0, window_size, 0 };
+    parallel_for(wav_data->num_channels, 1, sma_filter_channels, &pass);
+    TRACE_END(span, (size_t)wav_data->num_samples * wav_data->num_channels * sizeof(real_t));
+}
+
+// Contexto do espectro: o canal c é transformado em spectra + c * num_bins.
+typedef struct {
+    const WavData* wav_data;
+    Complex* spectra;
+    size_t fft_size;
+    int failed;
+} SpectrumPass;
 
-    for (int i = 0; i < window_size; i++) {
-        if (i < wav_data->num_samples) {
-             sum += wav_data->data_double[i];
+static void spectrum_channels(size_t begin, size_t end, void* ctx) {
+    SpectrumPass* pass = (SpectrumPass*)ctx;
+    size_t num_bins = pass->fft_size / 2 + 1;
+    for (size_t c = begin; c < end; c++) {
+        Complex* spectrum = pass->spectra + c * num_bins;
+        real_t* samples = (real_t*)spectrum;
+        memcpy(samples, wav_channel(pass->wav_data, (uint16_t)c), pass->wav_data->num_samples * sizeof(real_t));
+        if (rfft(samples, spectrum, pass->fft_size) != 0) pass->failed = 1;
+    }
+}
+
+Complex* get_spectrum(const WavData* wav_data, size_t* fft_size_out) {
+    size_t original_size = wav_data->num_samples;
+    size_t fft_size = fft_next_fast_size(original_size);
+    *fft_size_out = fft_size;
+
+    // Apenas os fft_size / 2 + 1 bins não redundantes de cada canal são retornados.
+    TRACE_BEGIN(span, "spectrum");
+    Complex* spectra = (Complex*)calloc((fft_size / 2 + 1) * wav_data->num_channels, sizeof(Complex));
+    if (!spectra) {
+        fprintf(stderr, "Memória insuficiente para o espectro.\n");
+        return NULL;
+    }
+    TRACE_ALLOC((fft_size / 2 + 1) * wav_data->num_channels * sizeof(Complex));
+    SpectrumPass pass = { wav_data, spectra, fft_size, 0 };
+    parallel_tasks(wav_data->num_channels, spectrum_channels, &pass);
+    TRACE_END(span, fft_size * wav_data->num_channels * sizeof(real_t));
+    if (pass.failed) {
+        free(spectra);
+        return NULL;
+    }
+    return spectra;
+}
+
+void compare_signals(const WavData* reference, const WavData* test, SignalComparison* result) {
+    result->num_samples = (reference->num_samples < test->num_samples) ? reference->num_samples : test->num_samples;
+    result->num_channels = (reference->num_channels < test->num_channels) ? reference->num_channels : test->num_channels;
+    result->max_abs_error = 0.0;
+
+    double signal_energy = 0.0;
+    double error_energy = 0.0;
+    for (uint16_t c = 0; c < result->num_channels; c++) {
+        const real_t* ref = wav_channel(reference, c);
+        const real_t* out = wav_channel(test, c);
+        for (uint32_t i = 0; i < result->num_samples; i++) {
+            double error = (double)out[i] - (double)ref[i];
+            if (fabs(error) > result->max_abs_error) {
+                result->max_abs_error = fabs(error);
+            }
+            signal_energy += (double)ref[i] * ref[i];
+            error_energy += error * error;
         }
     }
 
-    for (uint32_t i = 0; i < wav_data->num_samples; i++) {
-        if (i >= window_size) {
-            sum += wav_data->data_double[i] - wav_data->data_double[i - window_size];
+    size_t count = (size_t)result->num_samples * result->num_channels;
+    result->rms_error = count ? sqrt(error_energy / count) : 0.0;
+    result->snr_db = (error_energy > 0.0) ? 10.0 * log10(signal_energy / error_energy) : INFINITY;
+}
+
+
+// --- Média móvel em blocos ---
+
+struct SmaStream {
+    MovingStats* stats;
+};
+
+SmaStream* sma_stream_create(int window_size) {
+    if (window_size < 1) window_size = 1;
+    MovingStatsConfig config = { MOVING_MEAN, (size_t)window_size, 0.0, 0.0, 0 };
+    SmaStream* stream = (SmaStream*)calloc(1, sizeof(SmaStream));
+    if (!stream) return NULL;
+    stream->stats = moving_stats_create(&config);
+    if (!stream->stats) {
+        free(stream);
+        return NULL;
+    }
+    return stream;
+}
+
+size_t sma_stream_block_size(const SmaStream* stream) {
+    (void)stream;
+    return 0;
+}
+
+size_t sma_stream_process(SmaStream* stream, const real_t* in, size_t n, real_t* out) {
+    MovingStatsOutput outputs = { out, NULL, NULL, NULL, NULL };
+    moving_stats_process(stream->stats, in, n, &outputs);
+    return n;
+}
+
+size_t sma_stream_flush(SmaStream* stream, real_t* out) {
+    (void)stream;
+    (void)out;
+    return 0;
+}
+
+void sma_stream_destroy(SmaStream* stream) {
+    if (stream) {
+        moving_stats_destroy(stream->stats);
+        free(stream);
+    }
+}
+
+// --- Filtro FFT em blocos (overlap-save) ---
+
+// Número de coeficientes do FIR (ímpar, para ter atraso inteiro) e tamanho da FFT.
+#define STREAM_FIR_TAPS 4095
+#define STREAM_FFT_SIZE 16384
+
+struct FftFilterStream {
+    FftPlan* plan;       // FFT real de STREAM_FFT_SIZE pontos, reusada a cada bloco
+    Complex* response;   // FFT real do FIR: STREAM_FFT_SIZE / 2 + 1 bins
+    Complex* work;       // Buffer de trabalho da FFT real (mesmo tamanho)
+    real_t* history;     // Janela de entrada: (taps - 1) amostras antigas + bloco novo
+    size_t block_size;   // Amostras novas por FFT: STREAM_FFT_SIZE - taps + 1
+    size_t filled;       // Amostras novas já acumuladas no bloco atual
+    size_t to_skip;      // Saídas ainda a descartar para compensar o atraso do FIR
+    size_t pending;      // Amostras de entrada que ainda não geraram saída
+};
+
+FftFilterStream* fft_filter_stream_create(uint32_t sample_rate, double cutoff_freq, int is_high_pass) {
+    const size_t taps = STREAM_FIR_TAPS;
+    const size_t fft_size = STREAM_FFT_SIZE;
+    const size_t center = (taps - 1) / 2;
+
+    FftFilterStream* stream = (FftFilterStream*)calloc(1, sizeof(FftFilterStream));
+    if (!stream) return NULL;
+    stream->plan = fft_plan_create_real(fft_size);
+    stream->response = (Complex*)calloc(fft_size / 2 + 1, sizeof(Complex));
+    stream->work = (Complex*)malloc((fft_size / 2 + 1) * sizeof(Complex));
+    stream->history = (real_t*)calloc(fft_size, sizeof(real_t));
+    if (!stream->plan || !stream->response || !stream->work || !stream->history) {
+        fprintf(stderr, "Memória insuficiente para o filtro FFT em blocos.\n");
+        fft_filter_stream_destroy(stream);
+        return NULL;
+    }
+    stream->block_size = fft_size - taps + 1;
+    stream->to_skip = center;
+
+    // Sinc janelado (Blackman) passa-baixa; o passa-alta é o impulso menos o passa-baixa.
+    double fc = cutoff_freq / sample_rate;
+    if (fc > 0.5) fc = 0.5;
+    if (fc < 0.0) fc = 0.0;
+    real_t* taps_buffer = (real_t*)stream->response;
+    for (size_t i = 0; i < taps; i++) {
+        double m = (double)i - (double)center;
+        double sinc = (m == 0.0) ? 2.0 * fc : sin(2.0 * M_PI * fc * m) / (M_PI * m);
+        double window = 0.42 - 0.5 * cos(2.0 * M_PI * i / (taps - 1)) + 0.08 * cos(4.0 * M_PI * i / (taps - 1));
+        double h = sinc * window;
+        if (is_high_pass) {
+            h = ((m == 0.0) ? 1.0 : 0.0) - h;
         }
-        temp_buffer[i] = sum / window_size;
+        taps_buffer[i] = h;
     }
+    rfft_execute(stream->plan, taps_buffer, stream->response);
+    return stream;
+}
 
-    memcpy(wav_data->data_double, temp_buffer, wav_data->num_samples * sizeof(double));
-    free(temp_buffer);
+size_t fft_filter_stream_block_size(const FftFilterStream* stream) {
+    // Pior caso: um bloco inteiro mais o atraso ainda pendente no flush.
+    (void)stream;
+    return STREAM_FFT_SIZE;
 }
 
-Complex* get_spectrum(const WavData* wav_data, size_t* fft_size_out) {
-    size_t original_size = wav_data->num_samples;
-    size_t fft_size = find_next_power_of_2(original_size);
-    *fft_size_out = fft_size;
+// Filtra o bloco acumulado em 'history' e escreve as saídas válidas em 'out'.
+static size_t fft_filter_stream_run_block(FftFilterStream* stream, real_t* out) {
+    const size_t fft_size = STREAM_FFT_SIZE;
+    const size_t overlap = fft_size - stream->block_size;
+
+    real_t* samples = (real_t*)stream->work;
+    memcpy(samples, stream->history, fft_size * sizeof(real_t));
+    rfft_execute(stream->plan, samples, stream->work);
+    for (size_t k = 0; k < fft_size / 2 + 1; k++) {
+        Complex a = stream->work[k];
+        Complex b = stream->response[k];
+        stream->work[k].real = a.real * b.real - a.imag * b.imag;
+        stream->work[k].imag = a.real * b.imag + a.imag * b.real;
+    }
+    irfft_execute(stream->plan, stream->work, samples);
+
+    // As primeiras 'overlap' saídas estão contaminadas pela convolução circular.
+    size_t produced = 0;
+    for (size_t i = overlap; i < overlap + stream->filled; i++) {
+        if (stream->to_skip > 0) {
+            stream->to_skip--;
+            continue;
+        }
+        if (stream->pending == 0) break;
+        out[produced++] = samples[i];
+        stream->pending--;
+    }
+
+    // Mantém as últimas 'overlap' amostras como histórico do próximo bloco.
+    memmove(stream->history, stream->history + stream->filled, overlap * sizeof(real_t));
+    stream->filled = 0;
+    return produced;
+}
+
+size_t fft_filter_stream_process(FftFilterStream* stream, const real_t* in, size_t n, real_t* out) {
+    const size_t overlap = STREAM_FFT_SIZE - stream->block_size;
+    size_t produced = 0;
 
-    Complex* spectrum = (Complex*)calloc(fft_size, sizeof(Complex));
-    for(size_t i = 0; i < original_size; i++) {
-        spectrum[i].real = wav_data->data_double[i];
-        spectrum[i].imag = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        stream->history[overlap + stream->filled++] = in[i];
+        stream->pending++;
+        if (stream->filled == stream->block_size) {
+            produced += fft_filter_stream_run_block(stream, out + produced);
+        }
     }
+    return produced;
+}
 
-    fft(spectrum, fft_size);
-    return spectrum;
+size_t fft_filter_stream_flush(FftFilterStream* stream, real_t* out) {
+    const size_t overlap = STREAM_FFT_SIZE - stream->block_size;
+    size_t produced = 0;
+
+    // Alimenta zeros até que todo o atraso do FIR tenha saído.
+    while (stream->pending > 0) {
+        while (stream->filled < stream->block_size) {
+            stream->history[overlap + stream->filled++] = 0.0;
+        }
+        produced += fft_filter_stream_run_block(stream, out + produced);
+    }
+    return produced;
 }
 
+void fft_filter_stream_destroy(FftFilterStream* stream) {
+    if (stream) {
+        fft_plan_destroy(stream->plan);
+        free(stream->response);
+        free(stream->work);
+        free(stream->history);
+        free(stream);
+    }
+}
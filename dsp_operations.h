@@ -4,12 +4,62 @@
 #include "wav_handler.h"
 #include "fft.h"
 
+// Todas as operações tratam cada canal de forma independente (e em paralelo).
+
 // Corrigido: Adicionado 'const' para combinar com o arquivo .c
+// O resultado tem o maior número de canais entre as entradas; uma entrada com
+// menos canais tem os seus repetidos (ex.: mono + estéreo). Se as taxas
+// diferirem, 'wav2' é convertido para a de 'wav1' (resample_audio).
 WavData* mix_audio(const WavData* wav1, const WavData* wav2);
 
-void apply_fft_filter(WavData* wav_data, double cutoff_freq, int is_high_pass);
+// Novo WavData com o sinal convertido para 'sample_rate' Hz pelo conversor
+// polifásico de resampler.h (mesma duração, mesmo formato). NULL em erro.
+WavData* resample_audio(const WavData* wav_data, uint32_t sample_rate);
+
+// Retorna 0, ou -1 se faltar memória (o sinal pode ficar parcialmente filtrado).
+int apply_fft_filter(WavData* wav_data, double cutoff_freq, int is_high_pass);
+// Média móvel causal (moving_stats.h), in-place: a saída i é a média de
+// (i - janela, i], ou das i + 1 primeiras amostras enquanto a janela enche.
 void apply_sma_filter(WavData* wav_data, int window_size);
 size_t find_next_power_of_2(size_t n);
+// Retorna fft_size / 2 + 1 bins por canal: o canal c começa em c * (fft_size / 2 + 1).
+// NULL se faltar memória.
 Complex* get_spectrum(const WavData* wav_data, size_t* fft_size);
 
+// Erro de 'test' em relação a 'reference' (ex.: a mesma operação nas
+// compilações em double e em float), nos canais e amostras em comum.
+typedef struct {
+    uint32_t num_samples;     // Amostras comparadas por canal
+    uint16_t num_channels;
+    double max_abs_error;     // Maior |test - reference|
+    double rms_error;
+    double snr_db;            // Energia da referência sobre a do erro; INFINITY se idênticos
+} SignalComparison;
+
+void compare_signals(const WavData* reference, const WavData* test, SignalComparison* result);
+
+// --- Versões em blocos (streaming) dos filtros ---
+// Cada chamada a *_process consome 'n' amostras e escreve em 'out' as que já
+// estiverem prontas, retornando a quantidade escrita. Como há latência interna,
+// 'out' deve ter espaço para n + *_block_size(...) amostras. *_flush esvazia o
+// que restou no fim do sinal; no total, saem exatamente tantas amostras quantas entraram.
+
+// Média móvel: produz a mesma saída que apply_sma_filter, bloco a bloco e sem latência.
+typedef struct SmaStream SmaStream;
+SmaStream* sma_stream_create(int window_size);
+size_t sma_stream_block_size(const SmaStream* stream);
+size_t sma_stream_process(SmaStream* stream, const real_t* in, size_t n, real_t* out);
+size_t sma_stream_flush(SmaStream* stream, real_t* out);
+void sma_stream_destroy(SmaStream* stream);
+
+// Filtro passa-baixa/alta por overlap-save. A resposta "parede de tijolos" de
+// apply_fft_filter é aproximada por um FIR de fase linear (sinc janelado), cujo
+// atraso de grupo é compensado para manter a saída alinhada com a entrada.
+typedef struct FftFilterStream FftFilterStream;
+FftFilterStream* fft_filter_stream_create(uint32_t sample_rate, double cutoff_freq, int is_high_pass);
+size_t fft_filter_stream_block_size(const FftFilterStream* stream);
+size_t fft_filter_stream_process(FftFilterStream* stream, const real_t* in, size_t n, real_t* out);
+size_t fft_filter_stream_flush(FftFilterStream* stream, real_t* out);
+void fft_filter_stream_destroy(FftFilterStream* stream);
+
 #endif //DSP_OPERATIONS_H
\ No newline at end of file
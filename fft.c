@@ -1,65 +1,1063 @@
 #include "fft.h"
+#include "fft_simd.h"
+#include "thread_pool.h"
+#include "arena.h"
 #include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 
-// Função auxiliar para a permutação bit-reversal
-static void bit_reverse_reorder(Complex* data, size_t n) {
+// Maior número de fatores de um tamanho 5-smooth que cabe em size_t.
+#define MAX_FACTORS 64
+
+// Como cada tamanho é transformado:
+// - potência de 2: Cooley-Tukey radix-2 in-place;
+// - apenas fatores 2, 3 e 5: Cooley-Tukey misto com kernels radix-2/3/4/5;
+// - qualquer outro fator primo: Bluestein (chirp-z), via convolução em potência de 2.
+typedef enum {
+    FFT_RADIX2,
+    FFT_MIXED_RADIX,
+    FFT_BLUESTEIN
+} FftAlgorithm;
+
+// Tabelas pré-calculadas para um tamanho de FFT. São criadas na primeira
+// transformada de cada tamanho e reaproveitadas por todas as seguintes.
+typedef struct FftTables {
+    size_t n;
+    FftAlgorithm algorithm;
+    uint32_t* bitrev;         // Radix-2: bitrev[i] = índice de i com os bits invertidos
+    double* tw_re;            // Radix-2, por estágio (SoA): tw_re[half + j] + i*tw_im[half + j] = e^{i*pi*j/half}
+    double* tw_im;
+    float* tw_re_f32;         // Os mesmos twiddles em float, para fftf/ifftf (sob demanda; sempre, se real_t é float)
+    float* tw_im_f32;
+    Complex* twiddles;        // Misto, por estágio: (p - 1) twiddles contíguos para cada u < m
+    Complex* real_twiddles;   // e^{i*pi*k/n}, k < n; usado por rfft/irfft de tamanho 2n (criado sob demanda)
+    size_t factors[2 * MAX_FACTORS]; // Misto: pares (radix p, comprimento restante m)
+    size_t conv_size;         // Bluestein: tamanho (potência de 2) da convolução
+    struct FftTables* conv_tables; // Bluestein: tabelas da FFT de tamanho conv_size
+    Complex* chirp;           // Bluestein: e^{i*pi*k^2/n}, k < n
+    Complex* chirp_filter;    // Bluestein: FFT do filtro conj(chirp) espelhado
+    struct FftTables* next;
+} FftTables;
+
+static FftTables* table_cache = NULL;
+
+// Protege 'table_cache' e a criação preguiçosa de tabelas. É recursivo porque
+// criar as tabelas de Bluestein executa uma FFT de outro tamanho.
+static pthread_mutex_t table_lock;
+static pthread_once_t table_lock_once = PTHREAD_ONCE_INIT;
+
+static void init_table_lock(void) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&table_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+static void lock_tables(void) {
+    pthread_once(&table_lock_once, init_table_lock);
+    pthread_mutex_lock(&table_lock);
+}
+
+static void unlock_tables(void) {
+    pthread_mutex_unlock(&table_lock);
+}
+
+static FftTables* get_tables(size_t n);
+static int transform(Complex* data, size_t n, int inverse);
+
+// Alinhamento do scratch dos planos (uma linha de cache).
+#define SCRATCH_ALIGNMENT 64
+
+static int is_power_of_2(size_t n) {
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+// Decompõe 'n' em fatores 4, 2, 3 e 5 (nessa ordem de preferência).
+// Retorna 0 se sobrar algum outro fator primo.
+static int factorize(size_t n, size_t* factors) {
+    static const size_t radices[] = { 4, 2, 3, 5 };
+    size_t remaining = n;
+    size_t count = 0;
+    for (size_t r = 0; r < sizeof(radices) / sizeof(radices[0]); r++) {
+        while (remaining % radices[r] == 0) {
+            remaining /= radices[r];
+            factors[2 * count] = radices[r];
+            factors[2 * count + 1] = remaining;
+            count++;
+        }
+    }
+    return remaining == 1;
+}
+
+// No estágio de radix p com 'm' pontos restantes e passo 'fstride', o elemento
+// q da butterfly u é multiplicado por e^{2*i*pi*q*u*fstride/n}. Esses valores
+// são gravados em sequência, na ordem em que a butterfly os consome.
+static void create_mixed_radix_tables(FftTables* tables) {
+    size_t n = tables->n;
+    size_t total = 0;
+    for (const size_t* f = tables->factors; ; f += 2) {
+        total += (f[0] - 1) * f[1];
+        if (f[1] == 1) break;
+    }
+    tables->twiddles = (Complex*)malloc(total * sizeof(Complex));
+
+    Complex* tw = tables->twiddles;
+    size_t fstride = 1;
+    for (const size_t* f = tables->factors; ; f += 2) {
+        size_t p = f[0];
+        size_t m = f[1];
+        for (size_t u = 0; u < m; u++) {
+            for (size_t q = 1; q < p; q++) {
+                double angle = 2.0 * M_PI * (double)((q * u * fstride) % n) / (double)n;
+                tw->real = cos(angle);
+                tw->imag = sin(angle);
+                tw++;
+            }
+        }
+        fstride *= p;
+        if (m == 1) break;
+    }
+}
+
+static void create_bluestein_tables(FftTables* tables) {
+    size_t n = tables->n;
+    size_t conv_size = 1;
+    while (conv_size < 2 * n - 1) {
+        conv_size <<= 1;
+    }
+    tables->conv_size = conv_size;
+    tables->conv_tables = get_tables(conv_size);
+
+    // k^2 é reduzido módulo 2n antes de virar ângulo, para não perder precisão.
+    tables->chirp = (Complex*)malloc(n * sizeof(Complex));
+    for (size_t k = 0; k < n; k++) {
+        size_t k2 = (size_t)(((unsigned long long)k * k) % (2 * (unsigned long long)n));
+        double angle = M_PI * (double)k2 / (double)n;
+        tables->chirp[k].real = cos(angle);
+        tables->chirp[k].imag = sin(angle);
+    }
+
+    // Filtro b[t] = conj(chirp[|t|]) para t em -(n-1)..(n-1), em ordem circular.
+    tables->chirp_filter = (Complex*)calloc(conv_size, sizeof(Complex));
+    for (size_t k = 0; k < n; k++) {
+        Complex b = { tables->chirp[k].real, -tables->chirp[k].imag };
+        tables->chirp_filter[k] = b;
+        if (k > 0) tables->chirp_filter[conv_size - k] = b;
+    }
+    transform(tables->chirp_filter, conv_size, 0);
+}
+
+static void ensure_f32_twiddles(FftTables* tables);
+
+static FftTables* create_tables(size_t n) {
+    FftTables* tables = (FftTables*)calloc(1, sizeof(FftTables));
+    tables->n = n;
+
+    if (!is_power_of_2(n)) {
+        if (factorize(n, tables->factors)) {
+            tables->algorithm = FFT_MIXED_RADIX;
+            create_mixed_radix_tables(tables);
+        } else {
+            tables->algorithm = FFT_BLUESTEIN;
+            create_bluestein_tables(tables);
+        }
+        return tables;
+    }
+
+    tables->algorithm = FFT_RADIX2;
+    tables->bitrev = (uint32_t*)malloc(n * sizeof(uint32_t));
+    tables->tw_re = (double*)malloc((n > 1 ? n : 1) * sizeof(double));
+    tables->tw_im = (double*)malloc((n > 1 ? n : 1) * sizeof(double));
+
+    // Permutação bit-reversal, calculada uma única vez
+    tables->bitrev[0] = 0;
     for (size_t i = 1, j = 0; i < n; i++) {
         size_t bit = n >> 1;
         for (; j & bit; bit >>= 1) {
             j ^= bit;
         }
         j ^= bit;
-        if (i < j) {
-            Complex temp = data[i];
-            data[i] = data[j];
-            data[j] = temp;
-        }
-    }
-}
-
-// Função principal que implementa o algoritmo Cooley-Tukey Radix-2
-static void transform(Complex* data, size_t n, int inverse) {
-    if (n == 0) return;
-
-    bit_reverse_reorder(data, n);
-
-    for (size_t len = 2; len <= n; len <<= 1) {
-        double angle = 2 * M_PI / len * (inverse? -1 : 1);
-        Complex wlen = {cos(angle), sin(angle)};
-        for (size_t i = 0; i < n; i += len) {
-            Complex w = {1.0, 0.0};
-            for (size_t j = 0; j < len / 2; j++) {
-                Complex u = data[i + j];
-                Complex v = {
-                    data[i + j + len / 2].real * w.real - data[i + j + len / 2].imag * w.imag,
-                    data[i + j + len / 2].real * w.imag + data[i + j + len / 2].imag * w.real
-                };
-                data[i + j].real = u.real + v.real;
-                data[i + j].imag = u.imag + v.imag;
-                data[i + j + len / 2].real = u.real - v.real;
-                data[i + j + len / 2].imag = u.imag - v.imag;
-
-                Complex next_w = {
-                    w.real * wlen.real - w.imag * wlen.imag,
-                    w.real * wlen.imag + w.imag * wlen.real
-                };
-                w = next_w;
+        tables->bitrev[i] = (uint32_t)j;
+    }
+
+    // Cada twiddle é calculado diretamente com cos/sin, em vez da recorrência
+    // w *= wlen, que acumula erro de arredondamento ao longo do estágio.
+    // Os twiddles de cada estágio ficam contíguos para acesso sequencial e vetorial.
+    for (size_t half = 1; half < n; half <<= 1) {
+        for (size_t j = 0; j < half; j++) {
+            double angle = M_PI * (double)j / (double)half;
+            tables->tw_re[half + j] = cos(angle);
+            tables->tw_im[half + j] = sin(angle);
+        }
+    }
+#ifdef PROJETO_AUDIO_SINGLE_PRECISION
+    ensure_f32_twiddles(tables);
+#endif
+    return tables;
+}
+
+// Busca (ou cria) as tabelas do tamanho 'n'.
+static FftTables* get_tables(size_t n) {
+    lock_tables();
+    FftTables* tables = table_cache;
+    while (tables && tables->n != n) {
+        tables = tables->next;
+    }
+    if (!tables) {
+        tables = create_tables(n);
+        tables->next = table_cache;
+        table_cache = tables;
+    }
+    unlock_tables();
+    return tables;
+}
+
+// Twiddles extras usados na etapa de desempacotamento da FFT real. Depois de
+// criados, são lidos sem o lock (publicados com release/acquire).
+static const Complex* get_real_twiddles(FftTables* tables) {
+    Complex* twiddles = __atomic_load_n(&tables->real_twiddles, __ATOMIC_ACQUIRE);
+    if (twiddles) return twiddles;
+
+    lock_tables();
+    twiddles = tables->real_twiddles;
+    if (!twiddles) {
+        size_t m = tables->n;
+        twiddles = (Complex*)malloc(m * sizeof(Complex));
+        for (size_t k = 0; k < m; k++) {
+            double angle = M_PI * (double)k / (double)m;
+            twiddles[k].real = cos(angle);
+            twiddles[k].imag = sin(angle);
+        }
+        __atomic_store_n(&tables->real_twiddles, twiddles, __ATOMIC_RELEASE);
+    }
+    unlock_tables();
+    return twiddles;
+}
+
+// Twiddles radix-2 em precisão simples, derivados dos de precisão dupla.
+// Precisa ser chamada antes de radix2_transform_f32.
+static void ensure_f32_twiddles(FftTables* tables) {
+    lock_tables();
+    if (!tables->tw_re_f32) {
+        size_t n = tables->n;
+        float* tw_re = (float*)malloc((n > 1 ? n : 1) * sizeof(float));
+        float* tw_im = (float*)malloc((n > 1 ? n : 1) * sizeof(float));
+        for (size_t k = 1; k < n; k++) {
+            tw_re[k] = (float)tables->tw_re[k];
+            tw_im[k] = (float)tables->tw_im[k];
+        }
+        tables->tw_im_f32 = tw_im;
+        tables->tw_re_f32 = tw_re;
+    }
+    unlock_tables();
+}
+
+// Os estágios com butterflies de até RADIX2_BLOCK pontos são independentes
+// entre blocos: rodam bloco a bloco enquanto os dados estão no cache (L2),
+// e só os estágios maiores percorrem o vetor inteiro.
+#define RADIX2_BLOCK 8192
+
+// Abaixo deste tamanho a transformada roda inteira na thread que chama.
+#define PARALLEL_MIN_SIZE 32768
+// Menor pedaço de trabalho (em amostras ou butterflies) entregue a uma thread.
+#define PARALLEL_MIN_CHUNK 8192
+
+// Estado compartilhado pelas etapas paralelas de uma transformada radix-2.
+// Só um dos conjuntos (double ou float) é usado, conforme 'is_f32'.
+typedef struct {
+    int is_f32;
+    size_t n;
+    size_t half;              // Estágio atual (etapa de estágios grandes)
+    size_t block;             // Tamanho dos blocos da etapa em cache
+    int inverse;
+    const FftKernels* kernels;
+    const uint32_t* bitrev;
+    Complex* data;
+    double* re;
+    double* im;
+    const double* tw_re;
+    const double* tw_im;
+    ComplexF* data_f32;
+    float* re_f32;
+    float* im_f32;
+    const float* tw_re_f32;
+    const float* tw_im_f32;
+} Radix2Pass;
+
+// Separa [begin, end) em re/im já na ordem bit-reversal.
+static void radix2_gather(size_t begin, size_t end, void* ctx) {
+    Radix2Pass* pass = (Radix2Pass*)ctx;
+    for (size_t i = begin; i < end; i++) {
+        if (pass->is_f32) {
+            const ComplexF* src = &pass->data_f32[pass->bitrev[i]];
+            pass->re_f32[i] = src->real;
+            pass->im_f32[i] = src->imag;
+        } else {
+            const Complex* src = &pass->data[pass->bitrev[i]];
+            pass->re[i] = src->real;
+            pass->im[i] = src->imag;
+        }
+    }
+}
+
+// Reintercala [begin, end), normalizando na inversa.
+static void radix2_scatter(size_t begin, size_t end, void* ctx) {
+    Radix2Pass* pass = (Radix2Pass*)ctx;
+    size_t n = pass->n;
+    for (size_t i = begin; i < end; i++) {
+        if (pass->is_f32) {
+            pass->data_f32[i].real = pass->inverse ? pass->re_f32[i] / n : pass->re_f32[i];
+            pass->data_f32[i].imag = pass->inverse ? pass->im_f32[i] / n : pass->im_f32[i];
+        } else {
+            pass->data[i].real = pass->inverse ? pass->re[i] / n : pass->re[i];
+            pass->data[i].imag = pass->inverse ? pass->im[i] / n : pass->im[i];
+        }
+    }
+}
+
+// Executa as butterflies [begin, end) do estágio 'half', numeradas grupo a
+// grupo; cada trecho contíguo dentro de um grupo vira uma chamada ao kernel.
+static void radix2_stage_range(const Radix2Pass* pass, size_t half, size_t offset, size_t begin, size_t end) {
+    double sign = pass->inverse ? -1.0 : 1.0;
+    size_t t = begin;
+    while (t < end) {
+        size_t j = t % half;
+        size_t i = offset + (t / half) * 2 * half + j;
+        size_t count = half - j;
+        if (count > end - t) count = end - t;
+        if (pass->is_f32) {
+            pass->kernels->radix2_span_f32(pass->re_f32 + i, pass->im_f32 + i,
+                                           pass->re_f32 + i + half, pass->im_f32 + i + half,
+                                           pass->tw_re_f32 + half + j, pass->tw_im_f32 + half + j,
+                                           count, (float)sign);
+        } else {
+            pass->kernels->radix2_span(pass->re + i, pass->im + i, pass->re + i + half, pass->im + i + half,
+                                       pass->tw_re + half + j, pass->tw_im + half + j, count, sign);
+        }
+        t += count;
+    }
+}
+
+// Estágios com grupos curtos demais para um vetor: laço escalar direto, com
+// as mesmas contas dos kernels, evitando uma chamada por butterfly.
+#define RADIX2_SMALL_HALF 8
+
+static void radix2_small_stage(const Radix2Pass* pass, size_t half, size_t offset, size_t len) {
+    double sign = pass->inverse ? -1.0 : 1.0;
+    for (size_t i = offset; i < offset + len; i += 2 * half) {
+        for (size_t j = 0; j < half; j++) {
+            size_t a = i + j;
+            size_t b = a + half;
+            if (pass->is_f32) {
+                float w_re = pass->tw_re_f32[half + j];
+                float w_im = (float)sign * pass->tw_im_f32[half + j];
+                float v_re = pass->re_f32[b] * w_re - pass->im_f32[b] * w_im;
+                float v_im = pass->re_f32[b] * w_im + pass->im_f32[b] * w_re;
+                float u_re = pass->re_f32[a];
+                float u_im = pass->im_f32[a];
+                pass->re_f32[a] = u_re + v_re;
+                pass->im_f32[a] = u_im + v_im;
+                pass->re_f32[b] = u_re - v_re;
+                pass->im_f32[b] = u_im - v_im;
+            } else {
+                double w_re = pass->tw_re[half + j];
+                double w_im = sign * pass->tw_im[half + j];
+                double v_re = pass->re[b] * w_re - pass->im[b] * w_im;
+                double v_im = pass->re[b] * w_im + pass->im[b] * w_re;
+                double u_re = pass->re[a];
+                double u_im = pass->im[a];
+                pass->re[a] = u_re + v_re;
+                pass->im[a] = u_im + v_im;
+                pass->re[b] = u_re - v_re;
+                pass->im[b] = u_im - v_im;
+            }
+        }
+    }
+}
+
+// Primeiros estágios (half < block), bloco a bloco: [begin, end) são blocos.
+static void radix2_blocks(size_t begin, size_t end, void* ctx) {
+    Radix2Pass* pass = (Radix2Pass*)ctx;
+    for (size_t b = begin; b < end; b++) {
+        size_t offset = b * pass->block;
+        for (size_t half = 1; half < pass->block; half <<= 1) {
+            if (half < RADIX2_SMALL_HALF) {
+                radix2_small_stage(pass, half, offset, pass->block);
+            } else {
+                radix2_stage_range(pass, half, offset, 0, pass->block / 2);
             }
         }
     }
+}
+
+// Um estágio grande: [begin, end) são butterflies do vetor inteiro.
+static void radix2_large_stage(size_t begin, size_t end, void* ctx) {
+    Radix2Pass* pass = (Radix2Pass*)ctx;
+    radix2_stage_range(pass, pass->half, 0, begin, end);
+}
+
+// Cooley-Tukey radix-2. Os dados são separados em vetores real/imaginário
+// (SoA) já na ordem bit-reversal, para que cada estágio rode no kernel
+// vetorial escolhido em fft_simd.c, e depois reintercalados. Para tamanhos
+// grandes, cada etapa é dividida entre as threads do pool.
+static void radix2_run(Radix2Pass* pass) {
+    size_t n = pass->n;
+    size_t min_chunk = (n < PARALLEL_MIN_SIZE) ? n : PARALLEL_MIN_CHUNK;
+
+    parallel_for(n, min_chunk, radix2_gather, pass);
+
+    pass->block = (n < RADIX2_BLOCK) ? n : RADIX2_BLOCK;
+    parallel_for(n / pass->block, 1, radix2_blocks, pass);
+
+    for (size_t half = pass->block; half < n; half <<= 1) {
+        pass->half = half;
+        parallel_for(n / 2, min_chunk, radix2_large_stage, pass);
+    }
+
+    parallel_for(n, min_chunk, radix2_scatter, pass);
+}
+
+static void radix2_transform_f32(ComplexF* data, const FftTables* tables, int inverse, void* scratch);
+
+// 'scratch' comporta 2n real_t (vetores re e im).
+static void radix2_transform(Complex* data, const FftTables* tables, int inverse, void* scratch) {
+#ifdef PROJETO_AUDIO_SINGLE_PRECISION
+    // Complex já é float: os kernels de precisão simples servem diretamente.
+    radix2_transform_f32((ComplexF*)data, tables, inverse, scratch);
+#else
+    size_t n = tables->n;
+    Radix2Pass pass = { 0 };
+    pass.n = n;
+    pass.inverse = inverse;
+    pass.kernels = fft_simd_kernels();
+    pass.bitrev = tables->bitrev;
+    pass.data = data;
+    pass.re = (double*)scratch;
+    pass.im = pass.re + n;
+    pass.tw_re = tables->tw_re;
+    pass.tw_im = tables->tw_im;
+    radix2_run(&pass);
+#endif
+}
+
+static void radix2_transform_f32(ComplexF* data, const FftTables* tables, int inverse, void* scratch) {
+    size_t n = tables->n;
+    Radix2Pass pass = { 0 };
+    pass.is_f32 = 1;
+    pass.n = n;
+    pass.inverse = inverse;
+    pass.kernels = fft_simd_kernels();
+    pass.bitrev = tables->bitrev;
+    pass.data_f32 = data;
+    pass.re_f32 = (float*)scratch;
+    pass.im_f32 = pass.re_f32 + n;
+    pass.tw_re_f32 = tables->tw_re_f32;
+    pass.tw_im_f32 = tables->tw_im_f32;
+    radix2_run(&pass);
+}
+
+// --- Kernels do Cooley-Tukey misto ---
+// Cada butterfly combina 'p' sub-transformadas de tamanho 'm' guardadas em
+// out[q * m + u]: multiplica pelos twiddles e aplica uma DFT de tamanho p.
+// Processa u em [u_begin, u_end), para que o estágio possa ser dividido.
+
+static Complex cmul(Complex a, Complex b) {
+    Complex r = { a.real * b.real - a.imag * b.imag, a.real * b.imag + a.imag * b.real };
+    return r;
+}
+
+static void butterfly_2(Complex* out, size_t m, const Complex* tw, size_t u_begin, size_t u_end) {
+    tw += 1 * u_begin;
+    for (size_t u = u_begin; u < u_end; u++, tw += 1) {
+        Complex a0 = out[u];
+        Complex a1 = cmul(out[u + m], tw[0]);
+        out[u].real = a0.real + a1.real;
+        out[u].imag = a0.imag + a1.imag;
+        out[u + m].real = a0.real - a1.real;
+        out[u + m].imag = a0.imag - a1.imag;
+    }
+}
+
+static void butterfly_3(Complex* out, size_t m, const Complex* tw, size_t u_begin, size_t u_end) {
+    const Complex w1 = { -0.5, 0.86602540378443864676 }; // e^{2*i*pi/3}
+    tw += 2 * u_begin;
+    for (size_t u = u_begin; u < u_end; u++, tw += 2) {
+        Complex a0 = out[u];
+        Complex a1 = cmul(out[u + m], tw[0]);
+        Complex a2 = cmul(out[u + 2 * m], tw[1]);
+
+        Complex t = { a1.real + a2.real, a1.imag + a2.imag };
+        Complex d = { a1.real - a2.real, a1.imag - a2.imag };
+        Complex base = { a0.real + w1.real * t.real, a0.imag + w1.real * t.imag };
+        Complex rot = { -w1.imag * d.imag, w1.imag * d.real }; // i * Im(w1) * d
+
+        out[u].real = a0.real + t.real;
+        out[u].imag = a0.imag + t.imag;
+        out[u + m].real = base.real + rot.real;
+        out[u + m].imag = base.imag + rot.imag;
+        out[u + 2 * m].real = base.real - rot.real;
+        out[u + 2 * m].imag = base.imag - rot.imag;
+    }
+}
+
+static void butterfly_4(Complex* out, size_t m, const Complex* tw, size_t u_begin, size_t u_end) {
+    tw += 3 * u_begin;
+    for (size_t u = u_begin; u < u_end; u++, tw += 3) {
+        Complex a0 = out[u];
+        Complex a1 = cmul(out[u + m], tw[0]);
+        Complex a2 = cmul(out[u + 2 * m], tw[1]);
+        Complex a3 = cmul(out[u + 3 * m], tw[2]);
+
+        Complex s0 = { a0.real + a2.real, a0.imag + a2.imag };
+        Complex s1 = { a0.real - a2.real, a0.imag - a2.imag };
+        Complex s2 = { a1.real + a3.real, a1.imag + a3.imag };
+        Complex s3 = { a1.real - a3.real, a1.imag - a3.imag };
+
+        // Com a convenção e^{+i}, a raiz quarta da unidade é +i.
+        out[u].real = s0.real + s2.real;
+        out[u].imag = s0.imag + s2.imag;
+        out[u + m].real = s1.real - s3.imag;
+        out[u + m].imag = s1.imag + s3.real;
+        out[u + 2 * m].real = s0.real - s2.real;
+        out[u + 2 * m].imag = s0.imag - s2.imag;
+        out[u + 3 * m].real = s1.real + s3.imag;
+        out[u + 3 * m].imag = s1.imag - s3.real;
+    }
+}
+
+static void butterfly_5(Complex* out, size_t m, const Complex* tw, size_t u_begin, size_t u_end) {
+    const Complex w1 = { 0.30901699437494742410, 0.95105651629515357212 };  // e^{2*i*pi/5}
+    const Complex w2 = { -0.80901699437494742410, 0.58778525229247312917 }; // e^{4*i*pi/5}
+    tw += 4 * u_begin;
+    for (size_t u = u_begin; u < u_end; u++, tw += 4) {
+        Complex a0 = out[u];
+        Complex a1 = cmul(out[u + m], tw[0]);
+        Complex a2 = cmul(out[u + 2 * m], tw[1]);
+        Complex a3 = cmul(out[u + 3 * m], tw[2]);
+        Complex a4 = cmul(out[u + 4 * m], tw[3]);
+
+        Complex t1 = { a1.real + a4.real, a1.imag + a4.imag };
+        Complex d1 = { a1.real - a4.real, a1.imag - a4.imag };
+        Complex t2 = { a2.real + a3.real, a2.imag + a3.imag };
+        Complex d2 = { a2.real - a3.real, a2.imag - a3.imag };
+
+        Complex base1 = {
+            a0.real + w1.real * t1.real + w2.real * t2.real,
+            a0.imag + w1.real * t1.imag + w2.real * t2.imag
+        };
+        Complex base2 = {
+            a0.real + w2.real * t1.real + w1.real * t2.real,
+            a0.imag + w2.real * t1.imag + w1.real * t2.imag
+        };
+        // i * (Im(w1) d1 + Im(w2) d2) e i * (Im(w2) d1 - Im(w1) d2)
+        Complex rot1 = {
+            -(w1.imag * d1.imag + w2.imag * d2.imag),
+            w1.imag * d1.real + w2.imag * d2.real
+        };
+        Complex rot2 = {
+            -(w2.imag * d1.imag - w1.imag * d2.imag),
+            w2.imag * d1.real - w1.imag * d2.real
+        };
+
+        out[u].real = a0.real + t1.real + t2.real;
+        out[u].imag = a0.imag + t1.imag + t2.imag;
+        out[u + m].real = base1.real + rot1.real;
+        out[u + m].imag = base1.imag + rot1.imag;
+        out[u + 4 * m].real = base1.real - rot1.real;
+        out[u + 4 * m].imag = base1.imag - rot1.imag;
+        out[u + 2 * m].real = base2.real + rot2.real;
+        out[u + 2 * m].imag = base2.imag + rot2.imag;
+        out[u + 3 * m].real = base2.real - rot2.real;
+        out[u + 3 * m].imag = base2.imag - rot2.imag;
+    }
+}
+
+static void mixed_radix_butterfly(Complex* out, size_t p, size_t m, const Complex* tw,
+                                  size_t u_begin, size_t u_end) {
+    switch (p) {
+        case 2: butterfly_2(out, m, tw, u_begin, u_end); break;
+        case 3: butterfly_3(out, m, tw, u_begin, u_end); break;
+        case 4: butterfly_4(out, m, tw, u_begin, u_end); break;
+        default: butterfly_5(out, m, tw, u_begin, u_end); break;
+    }
+}
+
+// Decimação no tempo recursiva e fora do lugar: 'in' é lido com passo
+// 'fstride' e o resultado de tamanho p * m é escrito em 'out'. 'tw' aponta
+// para os twiddles do estágio atual; os dos estágios seguintes vêm logo depois.
+static void mixed_radix_work(Complex* out, const Complex* in, size_t fstride,
+                             const size_t* factors, const Complex* tw) {
+    size_t p = factors[0];
+    size_t m = factors[1];
+
+    if (m == 1) {
+        for (size_t q = 0; q < p; q++) {
+            out[q] = in[q * fstride];
+        }
+    } else {
+        const Complex* next_tw = tw + (p - 1) * m;
+        for (size_t q = 0; q < p; q++) {
+            mixed_radix_work(out + q * m, in + q * fstride, fstride * p, factors + 2, next_tw);
+        }
+    }
 
-    if (inverse) {
+    mixed_radix_butterfly(out, p, m, tw, 0, m);
+}
+
+// A inversa dos caminhos misto e Bluestein usa ifft(x) = conj(fft(conj(x))) / n.
+static void conjugate(Complex* data, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        data[i].imag = -data[i].imag;
+    }
+}
+
+// Paralelismo do caminho misto: as p1 * p2 sub-transformadas dos dois
+// primeiros níveis são independentes; depois vêm as butterflies do segundo
+// nível (p1 grupos de m2 posições) e a do primeiro, divididas por faixas de u.
+typedef struct {
+    Complex* out;
+    const Complex* in;
+    const FftTables* tables;
+} MixedRadixPass;
+
+static void mixed_radix_subtransforms(size_t begin, size_t end, void* ctx) {
+    MixedRadixPass* pass = (MixedRadixPass*)ctx;
+    const size_t* f = pass->tables->factors;
+    size_t p1 = f[0], m1 = f[1], p2 = f[2], m2 = f[3];
+    const Complex* tw3 = pass->tables->twiddles + (p1 - 1) * m1 + (p2 - 1) * m2;
+    for (size_t t = begin; t < end; t++) {
+        size_t q1 = t / p2;
+        size_t q2 = t % p2;
+        Complex* out = pass->out + q1 * m1 + q2 * m2;
+        const Complex* in = pass->in + q1 + q2 * p1;
+        if (m2 == 1) {
+            *out = *in;
+        } else {
+            mixed_radix_work(out, in, p1 * p2, f + 4, tw3);
+        }
+    }
+}
+
+static void mixed_radix_second_butterflies(size_t begin, size_t end, void* ctx) {
+    MixedRadixPass* pass = (MixedRadixPass*)ctx;
+    const size_t* f = pass->tables->factors;
+    size_t m1 = f[1], p2 = f[2], m2 = f[3];
+    const Complex* tw2 = pass->tables->twiddles + (f[0] - 1) * m1;
+    size_t t = begin;
+    while (t < end) {
+        size_t q1 = t / m2;
+        size_t u = t % m2;
+        size_t u_end = (q1 + 1) * m2 <= end ? m2 : end - q1 * m2;
+        mixed_radix_butterfly(pass->out + q1 * m1, p2, m2, tw2, u, u_end);
+        t = q1 * m2 + u_end;
+    }
+}
+
+static void mixed_radix_top_butterfly(size_t begin, size_t end, void* ctx) {
+    MixedRadixPass* pass = (MixedRadixPass*)ctx;
+    const size_t* f = pass->tables->factors;
+    mixed_radix_butterfly(pass->out, f[0], f[1], pass->tables->twiddles, begin, end);
+}
+
+// 'scratch' comporta n Complex: a recursão é fora do lugar.
+static void mixed_radix_transform(Complex* data, const FftTables* tables, Complex* scratch) {
+    size_t n = tables->n;
+    const size_t* f = tables->factors;
+
+    if (n < PARALLEL_MIN_SIZE || f[1] == 1) {
+        mixed_radix_work(scratch, data, 1, f, tables->twiddles);
+    } else {
+        MixedRadixPass pass = { scratch, data, tables };
+        parallel_for(f[0] * f[2], 1, mixed_radix_subtransforms, &pass);
+        parallel_for(f[0] * f[3], PARALLEL_MIN_CHUNK, mixed_radix_second_butterflies, &pass);
+        parallel_for(f[1], PARALLEL_MIN_CHUNK, mixed_radix_top_butterfly, &pass);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        data[i] = scratch[i];
+    }
+}
+
+static void transform_tables(Complex* data, const FftTables* tables, int inverse, void* scratch);
+
+// Bytes de scratch usados por transform_tables com estas tabelas.
+static size_t transform_scratch_bytes(const FftTables* tables) {
+    switch (tables->algorithm) {
+        case FFT_RADIX2: return 2 * tables->n * sizeof(real_t);
+        case FFT_MIXED_RADIX: return tables->n * sizeof(Complex);
+        default: return tables->conv_size * sizeof(Complex) + transform_scratch_bytes(tables->conv_tables);
+    }
+}
+
+// X[k] = c[k] * sum_j (x[j] c[j]) conj(c[k - j]), com c[k] = e^{i*pi*k^2/n}:
+// a DFT vira uma convolução, calculada com FFTs radix-2 de tamanho conv_size.
+// 'scratch' guarda o vetor da convolução, seguido do scratch dessas FFTs.
+static void bluestein_transform(Complex* data, const FftTables* tables, void* scratch) {
+    size_t n = tables->n;
+    size_t conv_size = tables->conv_size;
+    Complex* work = (Complex*)scratch;
+    void* conv_scratch = work + conv_size;
+
+    for (size_t k = 0; k < n; k++) {
+        work[k] = cmul(data[k], tables->chirp[k]);
+    }
+    for (size_t k = n; k < conv_size; k++) {
+        work[k].real = 0.0;
+        work[k].imag = 0.0;
+    }
+    transform_tables(work, tables->conv_tables, 0, conv_scratch);
+    for (size_t k = 0; k < conv_size; k++) {
+        work[k] = cmul(work[k], tables->chirp_filter[k]);
+    }
+    transform_tables(work, tables->conv_tables, 1, conv_scratch);
+    for (size_t k = 0; k < n; k++) {
+        data[k] = cmul(work[k], tables->chirp[k]);
+    }
+}
+
+// Despacha para radix-2, misto ou Bluestein conforme as tabelas. 'scratch'
+// tem ao menos transform_scratch_bytes(tables) bytes.
+static void transform_tables(Complex* data, const FftTables* tables, int inverse, void* scratch) {
+    size_t n = tables->n;
+
+    if (tables->algorithm != FFT_RADIX2) {
+        if (inverse) conjugate(data, n);
+        if (tables->algorithm == FFT_MIXED_RADIX) {
+            mixed_radix_transform(data, tables, (Complex*)scratch);
+        } else {
+            bluestein_transform(data, tables, scratch);
+        }
+        if (inverse) {
+            for (size_t i = 0; i < n; i++) {
+                data[i].real /= n;
+                data[i].imag = -data[i].imag / n;
+            }
+        }
+        return;
+    }
+
+    radix2_transform(data, tables, inverse, scratch);
+}
+
+// Buffer temporário das transformadas avulsas, da arena da thread.
+static void* arena_scratch(size_t bytes, size_t n) {
+    void* scratch = arena_alloc(bytes);
+    if (!scratch) fprintf(stderr, "Memória insuficiente para a FFT de %zu pontos.\n", n);
+    return scratch;
+}
+
+// Transformada avulsa: o scratch vem da arena da thread.
+static int transform(Complex* data, size_t n, int inverse) {
+    if (n == 0) return 0;
+
+    FftTables* tables = get_tables(n);
+    ArenaMark mark = arena_mark();
+    void* scratch = arena_scratch(transform_scratch_bytes(tables), n);
+    if (scratch) transform_tables(data, tables, inverse, scratch);
+    arena_release(mark);
+    return scratch ? 0 : -1;
+}
+
+// Precisão simples: potências de 2 usam os kernels float; os demais tamanhos
+// passam pela transformada em double, num buffer temporário da arena.
+static int transform_f32(ComplexF* data, size_t n, int inverse) {
+#ifdef PROJETO_AUDIO_SINGLE_PRECISION
+    return transform((Complex*)data, n, inverse);
+#else
+    if (n == 0) return 0;
+
+    FftTables* tables = get_tables(n);
+    ArenaMark mark = arena_mark();
+    if (tables->algorithm == FFT_RADIX2) {
+        ensure_f32_twiddles(tables);
+        void* scratch = arena_scratch(2 * n * sizeof(float), n);
+        if (scratch) radix2_transform_f32(data, tables, inverse, scratch);
+        arena_release(mark);
+        return scratch ? 0 : -1;
+    }
+
+    Complex* wide = (Complex*)arena_scratch(n * sizeof(Complex), n);
+    void* scratch = wide ? arena_scratch(transform_scratch_bytes(tables), n) : NULL;
+    if (!scratch) {
+        arena_release(mark);
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        wide[i].real = data[i].real;
+        wide[i].imag = data[i].imag;
+    }
+    transform_tables(wide, tables, inverse, scratch);
+    for (size_t i = 0; i < n; i++) {
+        data[i].real = (float)wide[i].real;
+        data[i].imag = (float)wide[i].imag;
+    }
+    arena_release(mark);
+    return 0;
+#endif
+}
+
+int fft(Complex* data, size_t n) {
+    return transform(data, n, 0);
+}
+
+int ifft(Complex* data, size_t n) {
+    return transform(data, n, 1);
+}
+
+int fftf(ComplexF* data, size_t n) {
+    return transform_f32(data, n, 0);
+}
+
+int ifftf(ComplexF* data, size_t n) {
+    return transform_f32(data, n, 1);
+}
+
+size_t fft_next_fast_size(size_t n) {
+    if (n <= 2) return 2;
+    size_t candidate = n + (n & 1);
+    for (;; candidate += 2) {
+        size_t remaining = candidate;
+        while (remaining % 2 == 0) remaining /= 2;
+        while (remaining % 3 == 0) remaining /= 3;
+        while (remaining % 5 == 0) remaining /= 5;
+        if (remaining == 1) return candidate;
+    }
+}
+
+// As FFTs reais de tamanho n usam as tabelas de tamanho n/2 (n par) ou n (ímpar).
+static FftTables* get_real_tables(size_t n) {
+    return get_tables(n % 2 == 0 ? n / 2 : n);
+}
+
+// Scratch de rfft/irfft: no caso ímpar, o espectro completo vem antes do
+// scratch da transformada complexa.
+static size_t real_scratch_bytes(size_t n, const FftTables* tables) {
+    size_t bytes = transform_scratch_bytes(tables);
+    if (n % 2 != 0) bytes += n * sizeof(Complex);
+    return bytes;
+}
+
+// FFT real pelo "truque do empacotamento": as amostras pares e ímpares viram
+// as partes real e imaginária de um sinal complexo de tamanho n/2, que é
+// transformado e depois separado em X[k] = E[k] + W^k * O[k].
+static void rfft_tables(const real_t* in, Complex* out, size_t n, FftTables* tables, void* scratch) {
+    if (n % 2 != 0) {
+        // Tamanho ímpar: não há empacotamento possível, usa a FFT complexa.
+        Complex* full = (Complex*)scratch;
         for (size_t i = 0; i < n; i++) {
-            data[i].real /= n;
-            data[i].imag /= n;
+            full[i].real = in[i];
+            full[i].imag = 0.0;
+        }
+        transform_tables(full, tables, 0, full + n);
+        for (size_t k = 0; k <= n / 2; k++) {
+            out[k] = full[k];
+        }
+        return;
+    }
+
+    size_t m = n / 2;
+
+    // Empacota; quando 'in' aponta para 'out' isto não move nada.
+    if (in != (const real_t*)out) {
+        for (size_t i = 0; i < m; i++) {
+            out[i].real = in[2 * i];
+            out[i].imag = in[2 * i + 1];
         }
     }
+    transform_tables(out, tables, 0, scratch);
+
+    const Complex* w = get_real_twiddles(tables);
+
+    // Bins 0 e n/2 dependem apenas de Z[0].
+    double z0_real = out[0].real;
+    double z0_imag = out[0].imag;
+    out[0].real = z0_real + z0_imag;
+    out[0].imag = 0.0;
+    out[m].real = z0_real - z0_imag;
+    out[m].imag = 0.0;
+
+    // Desempacota os pares (k, m - k) juntos, permitindo operar no mesmo buffer.
+    for (size_t k = 1; k <= m / 2; k++) {
+        Complex zk = out[k];
+        Complex zmk = out[m - k];
+
+        // E = (Z[k] + conj(Z[m-k])) / 2 ; O = (Z[k] - conj(Z[m-k])) / 2i
+        Complex e = { 0.5 * (zk.real + zmk.real), 0.5 * (zk.imag - zmk.imag) };
+        Complex o = { 0.5 * (zk.imag + zmk.imag), -0.5 * (zk.real - zmk.real) };
+
+        // X[k] = E + W^k O
+        Complex wo = {
+            w[k].real * o.real - w[k].imag * o.imag,
+            w[k].real * o.imag + w[k].imag * o.real
+        };
+        // X[m-k] = conj(E) + W^(m-k) conj(O), com W^(m-k) = -conj(W^k)
+        Complex wmk = { -w[k].real, w[k].imag };
+        Complex wo_mk = {
+            wmk.real * o.real + wmk.imag * o.imag,
+            wmk.imag * o.real - wmk.real * o.imag
+        };
+
+        out[k].real = e.real + wo.real;
+        out[k].imag = e.imag + wo.imag;
+        out[m - k].real = e.real + wo_mk.real;
+        out[m - k].imag = -e.imag + wo_mk.imag;
+    }
+}
+
+// Inversa de rfft: reconstrói o sinal complexo de tamanho n/2, aplica a IFFT
+// e desentrelaça. 'out' pode apontar para o mesmo buffer de 'in'.
+static void irfft_tables(const Complex* in, real_t* out, size_t n, FftTables* tables, void* scratch) {
+    if (n % 2 != 0) {
+        // Tamanho ímpar: reconstrói o espectro hermitiano completo.
+        Complex* full = (Complex*)scratch;
+        for (size_t k = 0; k <= n / 2; k++) {
+            full[k] = in[k];
+            if (k > 0) {
+                full[n - k].real = in[k].real;
+                full[n - k].imag = -in[k].imag;
+            }
+        }
+        transform_tables(full, tables, 1, full + n);
+        for (size_t i = 0; i < n; i++) {
+            out[i] = full[i].real;
+        }
+        return;
+    }
+
+    size_t m = n / 2;
+    Complex* z = (Complex*)out;
+    Complex x_nyquist = in[m];
+    if ((const Complex*)out != in) {
+        for (size_t k = 0; k < m; k++) {
+            z[k] = in[k];
+        }
+    }
+
+    const Complex* w = get_real_twiddles(tables);
+
+    // Z[0] a partir de X[0] e X[n/2].
+    double x0 = z[0].real;
+    z[0].real = 0.5 * (x0 + x_nyquist.real);
+    z[0].imag = 0.5 * (x0 - x_nyquist.real);
+
+    for (size_t k = 1; k <= m / 2; k++) {
+        Complex xk = z[k];
+        Complex xmk = z[m - k];
+
+        // E = (X[k] + conj(X[m-k])) / 2 ; O = (X[k] - conj(X[m-k])) * W^-k / 2
+        Complex e = { 0.5 * (xk.real + xmk.real), 0.5 * (xk.imag - xmk.imag) };
+        Complex d = { 0.5 * (xk.real - xmk.real), 0.5 * (xk.imag + xmk.imag) };
+        Complex o = {
+            d.real * w[k].real + d.imag * w[k].imag,
+            d.imag * w[k].real - d.real * w[k].imag
+        };
+
+        // Z[k] = E + iO ; Z[m-k] = conj(E) + i*conj(O)
+        z[k].real = e.real - o.imag;
+        z[k].imag = e.imag + o.real;
+        z[m - k].real = e.real + o.imag;
+        z[m - k].imag = -e.imag + o.real;
+    }
+
+    transform_tables(z, tables, 1, scratch);
+    // O layout de 'z' já é o das amostras intercaladas pares/ímpares.
+}
+
+int rfft(const real_t* in, Complex* out, size_t n) {
+    if (n == 0) return 0;
+    FftTables* tables = get_real_tables(n);
+    ArenaMark mark = arena_mark();
+    void* scratch = arena_scratch(real_scratch_bytes(n, tables), n);
+    if (scratch) rfft_tables(in, out, n, tables, scratch);
+    arena_release(mark);
+    return scratch ? 0 : -1;
+}
+
+int irfft(const Complex* in, real_t* out, size_t n) {
+    if (n == 0) return 0;
+    FftTables* tables = get_real_tables(n);
+    ArenaMark mark = arena_mark();
+    void* scratch = arena_scratch(real_scratch_bytes(n, tables), n);
+    if (scratch) irfft_tables(in, out, n, tables, scratch);
+    arena_release(mark);
+    return scratch ? 0 : -1;
+}
+
+// --- Planos ---
+
+struct FftPlan {
+    size_t n;
+    int is_real;
+    FftTables* tables;        // Compartilhadas com o cache: nunca liberadas
+    void* scratch;            // Próprio do plano, alinhado em SCRATCH_ALIGNMENT
+};
+
+static FftPlan* create_plan(size_t n, int is_real) {
+    if (n == 0) {
+        fprintf(stderr, "Tamanho de FFT inválido: 0.\n");
+        return NULL;
+    }
+
+    FftPlan* plan = (FftPlan*)calloc(1, sizeof(FftPlan));
+    if (!plan) return NULL;
+    plan->n = n;
+    plan->is_real = is_real;
+    plan->tables = is_real ? get_real_tables(n) : get_tables(n);
+
+    size_t bytes = is_real ? real_scratch_bytes(n, plan->tables) : transform_scratch_bytes(plan->tables);
+    if (is_real && n % 2 == 0) {
+        get_real_twiddles(plan->tables);
+    }
+    if (posix_memalign(&plan->scratch, SCRATCH_ALIGNMENT, bytes ? bytes : SCRATCH_ALIGNMENT) != 0) {
+        fprintf(stderr, "Memória insuficiente para o plano de FFT de tamanho %zu.\n", n);
+        free(plan);
+        return NULL;
+    }
+    return plan;
 }
 
-void fft(Complex* data, size_t n) {
-    transform(data, n, 0);
+FftPlan* fft_plan_create(size_t n) {
+    return create_plan(n, 0);
 }
 
-void ifft(Complex* data, size_t n) {
-    transform(data, n, 1);
-}
\ No newline at end of file
+FftPlan* fft_plan_create_real(size_t n) {
+    return create_plan(n, 1);
+}
+
+size_t fft_plan_size(const FftPlan* plan) {
+    return plan->n;
+}
+
+void fft_execute(const FftPlan* plan, Complex* data, FftDirection direction) {
+    if (plan->is_real) {
+        fprintf(stderr, "fft_execute: plano de FFT real; use rfft_execute/irfft_execute.\n");
+        return;
+    }
+    transform_tables(data, plan->tables, direction == FFT_INVERSE, plan->scratch);
+}
+
+void rfft_execute(const FftPlan* plan, const real_t* in, Complex* out) {
+    if (!plan->is_real) {
+        fprintf(stderr, "rfft_execute: plano de FFT complexa; use fft_execute.\n");
+        return;
+    }
+    rfft_tables(in, out, plan->n, plan->tables, plan->scratch);
+}
+
+void irfft_execute(const FftPlan* plan, const Complex* in, real_t* out) {
+    if (!plan->is_real) {
+        fprintf(stderr, "irfft_execute: plano de FFT complexa; use fft_execute.\n");
+        return;
+    }
+    irfft_tables(in, out, plan->n, plan->tables, plan->scratch);
+}
+
+void fft_plan_destroy(FftPlan* plan) {
+    if (plan) {
+        free(plan->scratch);
+        free(plan);
+    }
+}
@@ -2,14 +2,70 @@
 #define PROJETO_AUDIO_FFT_H
 
 #include <stddef.h>
+#include "precision.h"
 
-// Estrutura para representar um número complexo
+// Estrutura para representar um número complexo (em real_t: ver precision.h)
 typedef struct {
-    double real;
-    double imag;
+    real_t real;
+    real_t imag;
 } Complex;
 
-void fft(Complex* data, size_t n);
-void ifft(Complex* data, size_t n);
+// Variante em precisão simples, para fftf/ifftf
+typedef struct {
+    float real;
+    float imag;
+} ComplexF;
+
+// Todas as transformadas avulsas retornam 0, ou -1 (com 'data' / 'out'
+// indefinidos) se faltar memória para os buffers temporários.
+int fft(Complex* data, size_t n);
+int ifft(Complex* data, size_t n);
+
+// Mesma transformada em float: metade da memória e o dobro de lanes por vetor
+// nos kernels SIMD. Potências de 2 rodam inteiramente em float. Na compilação
+// em precisão simples, ComplexF e Complex têm o mesmo layout e fftf == fft.
+int fftf(ComplexF* data, size_t n);
+int ifftf(ComplexF* data, size_t n);
+
+// Qualquer 'n' é aceito. Tamanhos com fatores 2, 3 e 5 usam kernels mistos;
+// outros primos caem no algoritmo de Bluestein, bem mais lento.
+
+// Menor tamanho par >= n cujos únicos fatores primos são 2, 3 e 5.
+size_t fft_next_fast_size(size_t n);
+
+// FFT de sinal real de tamanho 'n' (de preferência par): produz os n/2 + 1 bins
+// não redundantes em 'out'. 'in' pode ser o próprio 'out' visto como real_t*,
+// pois um buffer de n/2 + 1 Complex comporta as n amostras de entrada.
+int rfft(const real_t* in, Complex* out, size_t n);
+// Inversa de rfft: lê n/2 + 1 bins e escreve 'n' amostras reais (já normalizadas).
+// 'out' pode ser o próprio 'in' visto como real_t*.
+int irfft(const Complex* in, real_t* out, size_t n);
+
+// As funções acima usam buffers temporários da arena da thread (arena.h).
+
+// --- Planos ---
+// Um plano fixa o tamanho da transformada e guarda tudo o que ela usa: as
+// tabelas (twiddles e permutação bit-reversal, compartilhadas com o cache
+// interno de tabelas) e um scratch alinhado próprio. Executar um plano não
+// aloca nem consulta o cache. Um plano pode ser reexecutado à vontade, mas não
+// por duas threads ao mesmo tempo, pois o scratch é único.
+typedef struct FftPlan FftPlan;
+
+typedef enum {
+    FFT_FORWARD = 0,
+    FFT_INVERSE = 1
+} FftDirection;
+
+// Plano de FFT complexa de tamanho 'n', para fft_execute. NULL em erro.
+FftPlan* fft_plan_create(size_t n);
+// Plano de FFT real de tamanho 'n', para rfft_execute/irfft_execute. NULL em erro.
+FftPlan* fft_plan_create_real(size_t n);
+size_t fft_plan_size(const FftPlan* plan);
+// Equivale a fft/ifft, no lugar.
+void fft_execute(const FftPlan* plan, Complex* data, FftDirection direction);
+// Equivalem a rfft/irfft, com os mesmos buffers e o mesmo uso no lugar.
+void rfft_execute(const FftPlan* plan, const real_t* in, Complex* out);
+void irfft_execute(const FftPlan* plan, const Complex* in, real_t* out);
+void fft_plan_destroy(FftPlan* plan);
 
 #endif //PROJETO_AUDIO_FFT_H
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include "fft_simd.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FFT_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// --- Escalar (referência) ---
+// Mesmas contas do laço AoS original: v = b * w; a' = a + v; b' = a - v.
+
+static void radix2_span_scalar(double* ar, double* ai, double* br, double* bi,
+                               const double* wr, const double* wi, size_t count, double sign) {
+    for (size_t j = 0; j < count; j++) {
+        double w_re = wr[j];
+        double w_im = sign * wi[j];
+        double v_re = br[j] * w_re - bi[j] * w_im;
+        double v_im = br[j] * w_im + bi[j] * w_re;
+        double u_re = ar[j];
+        double u_im = ai[j];
+        ar[j] = u_re + v_re;
+        ai[j] = u_im + v_im;
+        br[j] = u_re - v_re;
+        bi[j] = u_im - v_im;
+    }
+}
+
+static void radix2_span_scalar_f32(float* ar, float* ai, float* br, float* bi,
+                                   const float* wr, const float* wi, size_t count, float sign) {
+    for (size_t j = 0; j < count; j++) {
+        float w_re = wr[j];
+        float w_im = sign * wi[j];
+        float v_re = br[j] * w_re - bi[j] * w_im;
+        float v_im = br[j] * w_im + bi[j] * w_re;
+        float u_re = ar[j];
+        float u_im = ai[j];
+        ar[j] = u_re + v_re;
+        ai[j] = u_im + v_im;
+        br[j] = u_re - v_re;
+        bi[j] = u_im - v_im;
+    }
+}
+
+#ifdef FFT_SIMD_X86
+
+// Nos kernels vetoriais, o que não completa um vetor inteiro (spans curtos
+// dos primeiros estágios ou a sobra no fim) fica com a versão escalar.
+
+// --- SSE2: 2 doubles / 4 floats ---
+
+__attribute__((target("sse2")))
+static void radix2_span_sse2(double* ar, double* ai, double* br, double* bi,
+                             const double* wr, const double* wi, size_t count, double sign) {
+    const __m128d s = _mm_set1_pd(sign);
+    size_t j = 0;
+    for (; j + 2 <= count; j += 2) {
+        __m128d w_re = _mm_loadu_pd(wr + j);
+        __m128d w_im = _mm_mul_pd(s, _mm_loadu_pd(wi + j));
+        __m128d b_re = _mm_loadu_pd(br + j);
+        __m128d b_im = _mm_loadu_pd(bi + j);
+        __m128d v_re = _mm_sub_pd(_mm_mul_pd(b_re, w_re), _mm_mul_pd(b_im, w_im));
+        __m128d v_im = _mm_add_pd(_mm_mul_pd(b_re, w_im), _mm_mul_pd(b_im, w_re));
+        __m128d u_re = _mm_loadu_pd(ar + j);
+        __m128d u_im = _mm_loadu_pd(ai + j);
+        _mm_storeu_pd(ar + j, _mm_add_pd(u_re, v_re));
+        _mm_storeu_pd(ai + j, _mm_add_pd(u_im, v_im));
+        _mm_storeu_pd(br + j, _mm_sub_pd(u_re, v_re));
+        _mm_storeu_pd(bi + j, _mm_sub_pd(u_im, v_im));
+    }
+    radix2_span_scalar(ar + j, ai + j, br + j, bi + j, wr + j, wi + j, count - j, sign);
+}
+
+__attribute__((target("sse2")))
+static void radix2_span_sse2_f32(float* ar, float* ai, float* br, float* bi,
+                                 const float* wr, const float* wi, size_t count, float sign) {
+    const __m128 s = _mm_set1_ps(sign);
+    size_t j = 0;
+    for (; j + 4 <= count; j += 4) {
+        __m128 w_re = _mm_loadu_ps(wr + j);
+        __m128 w_im = _mm_mul_ps(s, _mm_loadu_ps(wi + j));
+        __m128 b_re = _mm_loadu_ps(br + j);
+        __m128 b_im = _mm_loadu_ps(bi + j);
+        __m128 v_re = _mm_sub_ps(_mm_mul_ps(b_re, w_re), _mm_mul_ps(b_im, w_im));
+        __m128 v_im = _mm_add_ps(_mm_mul_ps(b_re, w_im), _mm_mul_ps(b_im, w_re));
+        __m128 u_re = _mm_loadu_ps(ar + j);
+        __m128 u_im = _mm_loadu_ps(ai + j);
+        _mm_storeu_ps(ar + j, _mm_add_ps(u_re, v_re));
+        _mm_storeu_ps(ai + j, _mm_add_ps(u_im, v_im));
+        _mm_storeu_ps(br + j, _mm_sub_ps(u_re, v_re));
+        _mm_storeu_ps(bi + j, _mm_sub_ps(u_im, v_im));
+    }
+    radix2_span_scalar_f32(ar + j, ai + j, br + j, bi + j, wr + j, wi + j, count - j, sign);
+}
+
+// --- AVX2: 4 doubles / 8 floats ---
+
+__attribute__((target("avx2")))
+static void radix2_span_avx2(double* ar, double* ai, double* br, double* bi,
+                             const double* wr, const double* wi, size_t count, double sign) {
+    const __m256d s = _mm256_set1_pd(sign);
+    size_t j = 0;
+    for (; j + 4 <= count; j += 4) {
+        __m256d w_re = _mm256_loadu_pd(wr + j);
+        __m256d w_im = _mm256_mul_pd(s, _mm256_loadu_pd(wi + j));
+        __m256d b_re = _mm256_loadu_pd(br + j);
+        __m256d b_im = _mm256_loadu_pd(bi + j);
+        __m256d v_re = _mm256_sub_pd(_mm256_mul_pd(b_re, w_re), _mm256_mul_pd(b_im, w_im));
+        __m256d v_im = _mm256_add_pd(_mm256_mul_pd(b_re, w_im), _mm256_mul_pd(b_im, w_re));
+        __m256d u_re = _mm256_loadu_pd(ar + j);
+        __m256d u_im = _mm256_loadu_pd(ai + j);
+        _mm256_storeu_pd(ar + j, _mm256_add_pd(u_re, v_re));
+        _mm256_storeu_pd(ai + j, _mm256_add_pd(u_im, v_im));
+        _mm256_storeu_pd(br + j, _mm256_sub_pd(u_re, v_re));
+        _mm256_storeu_pd(bi + j, _mm256_sub_pd(u_im, v_im));
+    }
+    radix2_span_scalar(ar + j, ai + j, br + j, bi + j, wr + j, wi + j, count - j, sign);
+}
+
+__attribute__((target("avx2")))
+static void radix2_span_avx2_f32(float* ar, float* ai, float* br, float* bi,
+                                 const float* wr, const float* wi, size_t count, float sign) {
+    const __m256 s = _mm256_set1_ps(sign);
+    size_t j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m256 w_re = _mm256_loadu_ps(wr + j);
+        __m256 w_im = _mm256_mul_ps(s, _mm256_loadu_ps(wi + j));
+        __m256 b_re = _mm256_loadu_ps(br + j);
+        __m256 b_im = _mm256_loadu_ps(bi + j);
+        __m256 v_re = _mm256_sub_ps(_mm256_mul_ps(b_re, w_re), _mm256_mul_ps(b_im, w_im));
+        __m256 v_im = _mm256_add_ps(_mm256_mul_ps(b_re, w_im), _mm256_mul_ps(b_im, w_re));
+        __m256 u_re = _mm256_loadu_ps(ar + j);
+        __m256 u_im = _mm256_loadu_ps(ai + j);
+        _mm256_storeu_ps(ar + j, _mm256_add_ps(u_re, v_re));
+        _mm256_storeu_ps(ai + j, _mm256_add_ps(u_im, v_im));
+        _mm256_storeu_ps(br + j, _mm256_sub_ps(u_re, v_re));
+        _mm256_storeu_ps(bi + j, _mm256_sub_ps(u_im, v_im));
+    }
+    radix2_span_scalar_f32(ar + j, ai + j, br + j, bi + j, wr + j, wi + j, count - j, sign);
+}
+
+// --- AVX-512: 8 doubles / 16 floats ---
+
+__attribute__((target("avx512f")))
+static void radix2_span_avx512(double* ar, double* ai, double* br, double* bi,
+                               const double* wr, const double* wi, size_t count, double sign) {
+    const __m512d s = _mm512_set1_pd(sign);
+    size_t j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m512d w_re = _mm512_loadu_pd(wr + j);
+        __m512d w_im = _mm512_mul_pd(s, _mm512_loadu_pd(wi + j));
+        __m512d b_re = _mm512_loadu_pd(br + j);
+        __m512d b_im = _mm512_loadu_pd(bi + j);
+        __m512d v_re = _mm512_sub_pd(_mm512_mul_pd(b_re, w_re), _mm512_mul_pd(b_im, w_im));
+        __m512d v_im = _mm512_add_pd(_mm512_mul_pd(b_re, w_im), _mm512_mul_pd(b_im, w_re));
+        __m512d u_re = _mm512_loadu_pd(ar + j);
+        __m512d u_im = _mm512_loadu_pd(ai + j);
+        _mm512_storeu_pd(ar + j, _mm512_add_pd(u_re, v_re));
+        _mm512_storeu_pd(ai + j, _mm512_add_pd(u_im, v_im));
+        _mm512_storeu_pd(br + j, _mm512_sub_pd(u_re, v_re));
+        _mm512_storeu_pd(bi + j, _mm512_sub_pd(u_im, v_im));
+    }
+    radix2_span_scalar(ar + j, ai + j, br + j, bi + j, wr + j, wi + j, count - j, sign);
+}
+
+__attribute__((target("avx512f")))
+static void radix2_span_avx512_f32(float* ar, float* ai, float* br, float* bi,
+                                   const float* wr, const float* wi, size_t count, float sign) {
+    const __m512 s = _mm512_set1_ps(sign);
+    size_t j = 0;
+    for (; j + 16 <= count; j += 16) {
+        __m512 w_re = _mm512_loadu_ps(wr + j);
+        __m512 w_im = _mm512_mul_ps(s, _mm512_loadu_ps(wi + j));
+        __m512 b_re = _mm512_loadu_ps(br + j);
+        __m512 b_im = _mm512_loadu_ps(bi + j);
+        __m512 v_re = _mm512_sub_ps(_mm512_mul_ps(b_re, w_re), _mm512_mul_ps(b_im, w_im));
+        __m512 v_im = _mm512_add_ps(_mm512_mul_ps(b_re, w_im), _mm512_mul_ps(b_im, w_re));
+        __m512 u_re = _mm512_loadu_ps(ar + j);
+        __m512 u_im = _mm512_loadu_ps(ai + j);
+        _mm512_storeu_ps(ar + j, _mm512_add_ps(u_re, v_re));
+        _mm512_storeu_ps(ai + j, _mm512_add_ps(u_im, v_im));
+        _mm512_storeu_ps(br + j, _mm512_sub_ps(u_re, v_re));
+        _mm512_storeu_ps(bi + j, _mm512_sub_ps(u_im, v_im));
+    }
+    radix2_span_scalar_f32(ar + j, ai + j, br + j, bi + j, wr + j, wi + j, count - j, sign);
+}
+
+#endif // FFT_SIMD_X86
+
+static const FftKernels scalar_kernels = { "scalar", radix2_span_scalar, radix2_span_scalar_f32 };
+#ifdef FFT_SIMD_X86
+static const FftKernels sse2_kernels = { "sse2", radix2_span_sse2, radix2_span_sse2_f32 };
+static const FftKernels avx2_kernels = { "avx2", radix2_span_avx2, radix2_span_avx2_f32 };
+static const FftKernels avx512_kernels = { "avx512", radix2_span_avx512, radix2_span_avx512_f32 };
+#endif
+
+int simd_level(void) {
+#ifdef FFT_SIMD_X86
+    // Nível máximo permitido: 3 = AVX-512, 2 = AVX2, 1 = SSE2, 0 = escalar.
+    int max_level = 3;
+    const char* forced = getenv("PROJETO_AUDIO_SIMD");
+    if (forced) {
+        if (strcmp(forced, "scalar") == 0) max_level = 0;
+        else if (strcmp(forced, "sse2") == 0) max_level = 1;
+        else if (strcmp(forced, "avx2") == 0) max_level = 2;
+    }
+
+    __builtin_cpu_init();
+    if (max_level >= 3 && __builtin_cpu_supports("avx512f")) return 3;
+    if (max_level >= 2 && __builtin_cpu_supports("avx2")) return 2;
+    if (max_level >= 1 && __builtin_cpu_supports("sse2")) return 1;
+#endif
+    return 0;
+}
+
+static const FftKernels* select_kernels(void) {
+#ifdef FFT_SIMD_X86
+    switch (simd_level()) {
+        case 3: return &avx512_kernels;
+        case 2: return &avx2_kernels;
+        case 1: return &sse2_kernels;
+    }
+#endif
+    return &scalar_kernels;
+}
+
+const FftKernels* fft_simd_kernels(void) {
+    static const FftKernels* selected = NULL;
+    if (!selected) {
+        selected = select_kernels();
+    }
+    return selected;
+}
@@ -0,0 +1,35 @@
+#ifndef PROJETO_AUDIO_FFT_SIMD_H
+#define PROJETO_AUDIO_FFT_SIMD_H
+
+#include <stddef.h>
+
+// Kernels de butterfly radix-2 sobre buffers separados real/imaginário (SoA).
+// Uso interno de fft.c: cada chamada executa 'count' butterflies consecutivas
+// de um mesmo grupo, a[j], b[j] <- a[j] + w[j] b[j], a[j] - w[j] b[j], com
+// os twiddles em 'wr'/'wi'. 'sign' é -1 na inversa, para usar os conjugados.
+// Assim fft.c pode dividir um estágio em pedaços arbitrários (entre threads).
+//
+// Todas as variantes fazem exatamente as mesmas operações na mesma ordem
+// (sem FMA), então produzem resultados idênticos bit a bit.
+
+typedef void (*Radix2SpanFn)(double* ar, double* ai, double* br, double* bi,
+                             const double* wr, const double* wi, size_t count, double sign);
+typedef void (*Radix2SpanF32Fn)(float* ar, float* ai, float* br, float* bi,
+                                const float* wr, const float* wi, size_t count, float sign);
+
+typedef struct {
+    const char* name;
+    Radix2SpanFn radix2_span;
+    Radix2SpanF32Fn radix2_span_f32;
+} FftKernels;
+
+// Escolhe, na primeira chamada, o melhor conjunto suportado pela CPU
+// (AVX-512, AVX2, SSE2 ou escalar). A variável de ambiente
+// PROJETO_AUDIO_SIMD=scalar|sse2|avx2|avx512 força uma escolha menor.
+const FftKernels* fft_simd_kernels(void);
+
+// Nível escolhido pela mesma regra: 3 = AVX-512, 2 = AVX2, 1 = SSE2, 0 = escalar.
+// Usado também pelos kernels de conversão de amostras (sample_convert.c).
+int simd_level(void);
+
+#endif //PROJETO_AUDIO_FFT_SIMD_H
@@ -0,0 +1,438 @@
+#include "filters.h"
+#include "convolution.h"
+#include "dsp_operations.h"
+#include "thread_pool.h"
+#include "arena.h"
+#include "trace.h"
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Maior partição da convolução por FFT (a latência interna do filtro).
+#define FIR_MAX_PARTITION 1024
+
+// Estados do IIR abaixo disto viram zero, para a cauda do filtro não cair em
+// números subnormais (muito lentos) durante o silêncio.
+#define IIR_DENORMAL_FLOOR 1e-30
+
+int filter_parse_spec(const char* response, const char* freqs, FilterSpec* spec) {
+    if (strcmp(response, "low") == 0) {
+        spec->response = FILTER_LOW_PASS;
+    } else if (strcmp(response, "high") == 0) {
+        spec->response = FILTER_HIGH_PASS;
+    } else if (strcmp(response, "band") == 0) {
+        spec->response = FILTER_BAND_PASS;
+    } else {
+        return -1;
+    }
+
+    char* end = NULL;
+    spec->low_hz = strtod(freqs, &end);
+    spec->high_hz = 0.0;
+    if (end == freqs) return -1;
+    if (spec->response == FILTER_BAND_PASS) {
+        if (*end != ':') return -1;
+        const char* second = end + 1;
+        spec->high_hz = strtod(second, &end);
+        if (end == second) return -1;
+    }
+    return (*end == '\0') ? 0 : -1;
+}
+
+static int validate_spec(const FilterSpec* spec, uint32_t sample_rate) {
+    double nyquist = sample_rate / 2.0;
+    if (spec->low_hz <= 0.0 || spec->low_hz >= nyquist) {
+        fprintf(stderr, "Frequência de corte fora do intervalo (0, %.1f) Hz: %.2f\n", nyquist, spec->low_hz);
+        return -1;
+    }
+    if (spec->response == FILTER_BAND_PASS && (spec->high_hz <= spec->low_hz || spec->high_hz >= nyquist)) {
+        fprintf(stderr, "Banda inválida: %.2f:%.2f Hz (esperado f1 < f2 < %.1f).\n", spec->low_hz, spec->high_hz, nyquist);
+        return -1;
+    }
+    return 0;
+}
+
+// --- Projeto do FIR ---
+
+// Janela simétrica (denominador N - 1), a forma usada no projeto de filtros.
+static double symmetric_window(size_t i, size_t n, WindowType type) {
+    if (n == 1) return 1.0;
+    double phase = 2.0 * M_PI * (double)i / (double)(n - 1);
+    switch (type) {
+        case WINDOW_HAMMING:
+            return 0.54 - 0.46 * cos(phase);
+        case WINDOW_BLACKMAN:
+            return 0.42 - 0.5 * cos(phase) + 0.08 * cos(2.0 * phase);
+        default:
+            return 0.5 - 0.5 * cos(phase);
+    }
+}
+
+// Passa-baixa em 'fc' (ciclos por amostra), normalizado para ganho 1 em DC.
+static void windowed_sinc(double* taps, size_t num_taps, double fc, WindowType window) {
+    double center = (double)(num_taps - 1) / 2.0;
+    double sum = 0.0;
+    for (size_t i = 0; i < num_taps; i++) {
+        double m = (double)i - center;
+        double sinc = (m == 0.0) ? 2.0 * fc : sin(2.0 * M_PI * fc * m) / (M_PI * m);
+        taps[i] = sinc * symmetric_window(i, num_taps, window);
+        sum += taps[i];
+    }
+    for (size_t i = 0; i < num_taps; i++) {
+        taps[i] /= sum;
+    }
+}
+
+double* fir_design(const FilterSpec* spec, uint32_t sample_rate, size_t num_taps, WindowType window) {
+    if (num_taps == 0 || num_taps % 2 == 0) {
+        fprintf(stderr, "O número de coeficientes do FIR deve ser ímpar: %zu\n", num_taps);
+        return NULL;
+    }
+    if (validate_spec(spec, sample_rate) != 0) return NULL;
+
+    double* taps = (double*)malloc(num_taps * sizeof(double));
+    if (!taps) return NULL;
+    size_t center = (num_taps - 1) / 2;
+    windowed_sinc(taps, num_taps, spec->low_hz / sample_rate, window);
+
+    if (spec->response == FILTER_HIGH_PASS) {
+        // Impulso menos o passa-baixa.
+        for (size_t i = 0; i < num_taps; i++) {
+            taps[i] = -taps[i];
+        }
+        taps[center] += 1.0;
+    } else if (spec->response == FILTER_BAND_PASS) {
+        // Diferença de dois passa-baixas: (0, f2) - (0, f1).
+        double* lower = (double*)malloc(num_taps * sizeof(double));
+        if (!lower) {
+            free(taps);
+            return NULL;
+        }
+        windowed_sinc(taps, num_taps, spec->high_hz / sample_rate, window);
+        windowed_sinc(lower, num_taps, spec->low_hz / sample_rate, window);
+        for (size_t i = 0; i < num_taps; i++) {
+            taps[i] -= lower[i];
+        }
+        free(lower);
+    }
+    return taps;
+}
+
+// --- Convolução do FIR em blocos ---
+
+// A convolução fica com convolution.h; o filtro só descarta as primeiras
+// (num_taps - 1) / 2 saídas (o atraso de grupo) e a cauda além da entrada.
+struct FirFilter {
+    Convolver* convolver;
+    size_t to_skip;        // Saídas ainda a descartar (atraso de grupo)
+    uint64_t pending;      // Amostras de entrada que ainda não geraram saída
+};
+
+FirFilter* fir_filter_create(const double* taps, size_t num_taps) {
+    if (num_taps == 0) return NULL;
+    FirFilter* filter = (FirFilter*)calloc(1, sizeof(FirFilter));
+    real_t* kernel = (real_t*)malloc(num_taps * sizeof(real_t));
+    if (!filter || !kernel) {
+        free(filter);
+        free(kernel);
+        return NULL;
+    }
+    for (size_t k = 0; k < num_taps; k++) {
+        kernel[k] = (real_t)taps[k];
+    }
+    filter->convolver = convolver_create(kernel, num_taps, FIR_MAX_PARTITION);
+    filter->to_skip = (num_taps - 1) / 2;
+    free(kernel);
+    if (!filter->convolver) {
+        free(filter);
+        return NULL;
+    }
+    return filter;
+}
+
+size_t fir_filter_block_size(const FirFilter* filter) {
+    return convolver_block_size(filter->convolver);
+}
+
+// Move para 'out' as saídas de 'y' que pertencem ao sinal filtrado.
+static size_t fir_filter_emit(FirFilter* filter, const real_t* y, size_t count, real_t* out) {
+    size_t skipped = (filter->to_skip < count) ? filter->to_skip : count;
+    filter->to_skip -= skipped;
+    count -= skipped;
+    if (count > filter->pending) count = (size_t)filter->pending;
+    memmove(out, y + skipped, count * sizeof(real_t));
+    filter->pending -= count;
+    return count;
+}
+
+size_t fir_filter_process(FirFilter* filter, const real_t* in, size_t n, real_t* out) {
+    filter->pending += n;
+    size_t produced = convolver_process(filter->convolver, in, n, out);
+    return fir_filter_emit(filter, out, produced, out);
+}
+
+size_t fir_filter_flush(FirFilter* filter, real_t* out) {
+    // A cauda completa não cabe, em geral, no espaço de 'out'.
+    ArenaMark mark = arena_mark();
+    real_t* tail = (real_t*)arena_alloc(convolver_block_size(filter->convolver) * sizeof(real_t));
+    if (!tail) {
+        fprintf(stderr, "Memória insuficiente para a cauda do filtro FIR.\n");
+        arena_release(mark);
+        return 0;
+    }
+    size_t produced = convolver_flush(filter->convolver, tail);
+    produced = fir_filter_emit(filter, tail, produced, out);
+    arena_release(mark);
+    return produced;
+}
+
+void fir_filter_destroy(FirFilter* filter) {
+    if (filter) {
+        convolver_destroy(filter->convolver);
+        free(filter);
+    }
+}
+
+// --- Butterworth em biquads ---
+
+// H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+typedef struct {
+    double b0, b1, b2;
+    double a1, a2;
+} Biquad;
+
+struct IirFilter {
+    size_t num_sections;
+    Biquad* sections;
+    double* state;        // Dois estados por seção (forma direta II transposta)
+};
+
+// |H(e^jw)| de uma seção.
+static double section_gain(const Biquad* s, double w) {
+    double complex z1 = cexp(-I * w);
+    double complex z2 = z1 * z1;
+    double complex num = s->b0 + s->b1 * z1 + s->b2 * z2;
+    double complex den = 1.0 + s->a1 * z1 + s->a2 * z2;
+    return cabs(num / den);
+}
+
+// Monta a seção com os zeros da resposta e ganho 1 na frequência 'w_ref'.
+static void make_section(Biquad* s, FilterResponse response, int first_order, double w_ref) {
+    if (response == FILTER_BAND_PASS) {
+        // Um zero em DC e outro em Nyquist.
+        s->b0 = 1.0; s->b1 = 0.0; s->b2 = -1.0;
+    } else {
+        double sign = (response == FILTER_LOW_PASS) ? 1.0 : -1.0;   // Zeros em Nyquist ou em DC
+        if (first_order) {
+            s->b0 = 1.0; s->b1 = sign; s->b2 = 0.0;
+        } else {
+            s->b0 = 1.0; s->b1 = 2.0 * sign; s->b2 = 1.0;
+        }
+    }
+    double gain = section_gain(s, w_ref);
+    s->b0 /= gain;
+    s->b1 /= gain;
+    s->b2 /= gain;
+}
+
+// Polos analógicos do protótipo passa-baixa de corte 1 rad/s, transformados
+// para a resposta pedida, mapeados para z e agrupados em seções. Retorna o
+// número de seções escritas em 'sections'.
+static size_t butterworth_sections(const FilterSpec* spec, uint32_t sample_rate, int order, Biquad* sections) {
+    const double fs2 = 2.0 * sample_rate;
+    double complex poles[2 * IIR_MAX_ORDER];
+    size_t num_poles = 0;
+
+    // Pré-distorção: a bilinear comprime o eixo de frequências.
+    double w_low = fs2 * tan(M_PI * spec->low_hz / sample_rate);
+    double w_high = (spec->response == FILTER_BAND_PASS) ? fs2 * tan(M_PI * spec->high_hz / sample_rate) : 0.0;
+
+    for (int k = 0; k < order; k++) {
+        double complex p = cexp(I * M_PI * (2.0 * k + order + 1) / (2.0 * order));
+        if (spec->response == FILTER_LOW_PASS) {
+            poles[num_poles++] = w_low * p;
+        } else if (spec->response == FILTER_HIGH_PASS) {
+            poles[num_poles++] = w_low / p;
+        } else {
+            // s -> (s^2 + w0^2) / (s * bw): cada polo vira dois.
+            double bw = w_high - w_low;
+            double w0_sq = w_low * w_high;
+            double complex half = p * bw / 2.0;
+            double complex root = csqrt(half * half - w0_sq);
+            poles[num_poles++] = half + root;
+            poles[num_poles++] = half - root;
+        }
+    }
+
+    // Frequência (rad/amostra) onde cada seção deve ter ganho 1.
+    double w_ref = 0.0;
+    if (spec->response == FILTER_HIGH_PASS) {
+        w_ref = M_PI;
+    } else if (spec->response == FILTER_BAND_PASS) {
+        w_ref = 2.0 * atan(sqrt(w_low * w_high) / fs2);
+    }
+
+    // Um polo de cada par conjugado vira uma seção; os reais são agrupados dois a dois.
+    size_t num_sections = 0;
+    double real_pole = 0.0;
+    int has_real = 0;
+    for (size_t i = 0; i < num_poles; i++) {
+        double complex z = (fs2 + poles[i]) / (fs2 - poles[i]);
+        double tolerance = 1e-9 * (1.0 + cabs(z));
+        Biquad* s = &sections[num_sections];
+        if (cimag(z) > tolerance) {
+            s->a1 = -2.0 * creal(z);
+            s->a2 = creal(z) * creal(z) + cimag(z) * cimag(z);
+        } else if (cimag(z) >= -tolerance) {
+            if (!has_real) {
+                real_pole = creal(z);
+                has_real = 1;
+                continue;
+            }
+            s->a1 = -(real_pole + creal(z));
+            s->a2 = real_pole * creal(z);
+            has_real = 0;
+        } else {
+            continue;
+        }
+        make_section(s, spec->response, 0, w_ref);
+        num_sections++;
+    }
+    if (has_real) {
+        Biquad* s = &sections[num_sections++];
+        s->a1 = -real_pole;
+        s->a2 = 0.0;
+        make_section(s, spec->response, 1, w_ref);
+    }
+    return num_sections;
+}
+
+IirFilter* iir_butterworth_create(const FilterSpec* spec, uint32_t sample_rate, int order) {
+    if (order < 1 || order > IIR_MAX_ORDER) {
+        fprintf(stderr, "Ordem do filtro IIR fora do intervalo [1, %d]: %d\n", IIR_MAX_ORDER, order);
+        return NULL;
+    }
+    if (validate_spec(spec, sample_rate) != 0) return NULL;
+
+    IirFilter* filter = (IirFilter*)calloc(1, sizeof(IirFilter));
+    if (!filter) return NULL;
+    filter->sections = (Biquad*)malloc(IIR_MAX_ORDER * sizeof(Biquad));
+    filter->state = (double*)calloc(2 * IIR_MAX_ORDER, sizeof(double));
+    if (!filter->sections || !filter->state) {
+        iir_filter_destroy(filter);
+        return NULL;
+    }
+    filter->num_sections = butterworth_sections(spec, sample_rate, order, filter->sections);
+    return filter;
+}
+
+size_t iir_filter_num_sections(const IirFilter* filter) {
+    return filter->num_sections;
+}
+
+size_t iir_filter_block_size(const IirFilter* filter) {
+    (void)filter;
+    return 0;
+}
+
+// Seção por seção sobre o bloco inteiro: coeficientes e estados ficam em
+// registradores durante todo o laço. 'in' pode ser o próprio 'out'.
+size_t iir_filter_process(IirFilter* filter, const real_t* in, size_t n, real_t* out) {
+    if (out != in) {
+        memcpy(out, in, n * sizeof(real_t));
+    }
+    for (size_t s = 0; s < filter->num_sections; s++) {
+        const Biquad c = filter->sections[s];
+        double z1 = filter->state[2 * s];
+        double z2 = filter->state[2 * s + 1];
+        for (size_t i = 0; i < n; i++) {
+            double x = out[i];
+            double y = c.b0 * x + z1;
+            z1 = c.b1 * x - c.a1 * y + z2;
+            z2 = c.b2 * x - c.a2 * y;
+            out[i] = y;
+        }
+        filter->state[2 * s] = (fabs(z1) < IIR_DENORMAL_FLOOR) ? 0.0 : z1;
+        filter->state[2 * s + 1] = (fabs(z2) < IIR_DENORMAL_FLOOR) ? 0.0 : z2;
+    }
+    return n;
+}
+
+size_t iir_filter_flush(IirFilter* filter, real_t* out) {
+    (void)filter;
+    (void)out;
+    return 0;
+}
+
+void iir_filter_destroy(IirFilter* filter) {
+    if (filter) {
+        free(filter->sections);
+        free(filter->state);
+        free(filter);
+    }
+}
+
+// --- Sinal inteiro ---
+
+typedef struct {
+    WavData* wav_data;
+    const double* taps;      // FIR
+    size_t num_taps;
+    const FilterSpec* spec;  // IIR
+    int order;
+    int failed;
+} FilterPass;
+
+// O filtro escreve cada saída só depois de ler a entrada correspondente, então
+// o canal pode ser filtrado no lugar; o flush completa as últimas amostras.
+static void fir_filter_channels(size_t begin, size_t end, void* ctx) {
+    FilterPass* pass = (FilterPass*)ctx;
+    for (size_t c = begin; c < end; c++) {
+        FirFilter* filter = fir_filter_create(pass->taps, pass->num_taps);
+        if (!filter) {
+            pass->failed = 1;
+            continue;
+        }
+        real_t* channel = wav_channel(pass->wav_data, (uint16_t)c);
+        size_t produced = fir_filter_process(filter, channel, pass->wav_data->num_samples, channel);
+        fir_filter_flush(filter, channel + produced);
+        fir_filter_destroy(filter);
+    }
+}
+
+static void iir_filter_channels(size_t begin, size_t end, void* ctx) {
+    FilterPass* pass = (FilterPass*)ctx;
+    for (size_t c = begin; c < end; c++) {
+        IirFilter* filter = iir_butterworth_create(pass->spec, pass->wav_data->sample_rate, pass->order);
+        if (!filter) {
+            pass->failed = 1;
+            continue;
+        }
+        real_t* channel = wav_channel(pass->wav_data, (uint16_t)c);
+        iir_filter_process(filter, channel, pass->wav_data->num_samples, channel);
+        iir_filter_destroy(filter);
+    }
+}
+
+int apply_fir_filter(WavData* wav_data, const double* taps, size_t num_taps) {
+    TRACE_BEGIN(span, "fir");
+    FilterPass pass = { wav_data, taps, num_taps, NULL, 0, 0 };
+    parallel_for(wav_data->num_channels, 1, fir_filter_channels, &pass);
+    TRACE_END(span, (size_t)wav_data->num_samples * wav_data->num_channels * sizeof(real_t));
+    return pass.failed ? -1 : 0;
+}
+
+int apply_iir_filter(WavData* wav_data, const FilterSpec* spec, int order) {
+    // Valida uma vez aqui, para não repetir a mensagem de erro em cada canal.
+    IirFilter* probe = iir_butterworth_create(spec, wav_data->sample_rate, order);
+    if (!probe) return -1;
+    iir_filter_destroy(probe);
+
+    TRACE_BEGIN(span, "iir");
+    FilterPass pass = { wav_data, NULL, 0, spec, order, 0 };
+    parallel_for(wav_data->num_channels, 1, iir_filter_channels, &pass);
+    TRACE_END(span, (size_t)wav_data->num_samples * wav_data->num_channels * sizeof(real_t));
+    return pass.failed ? -1 : 0;
+}
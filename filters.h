@@ -0,0 +1,72 @@
+#ifndef PROJETO_AUDIO_FILTERS_H
+#define PROJETO_AUDIO_FILTERS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "wav_handler.h"
+#include "stft.h"
+
+// Filtros de verdade, no lugar de zerar bins do espectro: FIR de fase linear
+// (sinc janelado) e IIR Butterworth em seções de segunda ordem (biquads).
+// Ambos processam o sinal de forma incremental e seguem o mesmo contrato dos
+// filtros em blocos de dsp_operations.h (*_process / *_flush / *_block_size).
+
+typedef enum {
+    FILTER_LOW_PASS,
+    FILTER_HIGH_PASS,
+    FILTER_BAND_PASS
+} FilterResponse;
+
+typedef struct {
+    FilterResponse response;
+    double low_hz;    // Corte do passa-baixa/alta, ou borda inferior do passa-banda
+    double high_hz;   // Borda superior do passa-banda (ignorada nos demais)
+} FilterSpec;
+
+// 'response' é "low", "high" ou "band"; 'freqs' é "f" ou, no passa-banda,
+// "f1:f2" (em Hz). Retorna -1 se algo não for reconhecido.
+int filter_parse_spec(const char* response, const char* freqs, FilterSpec* spec);
+
+// --- FIR ---
+
+// Projeta um FIR de 'num_taps' coeficientes (ímpar) pelo método do sinc janelado,
+// com ganho 1 na banda passante. Retorna um vetor alocado (liberar com free) ou NULL.
+double* fir_design(const FilterSpec* spec, uint32_t sample_rate, size_t num_taps, WindowType window);
+
+// Convolução em blocos com um FIR qualquer (Convolver, de convolution.h, com
+// partições de no máximo 1024 coeficientes): FIRs curtos são aplicados
+// diretamente; nos longos, a latência fica em um bloco pequeno qualquer que
+// seja o número de coeficientes. O atraso de grupo
+// (num_taps - 1) / 2 é compensado: a saída fica alinhada com a entrada.
+// Os coeficientes são projetados em double e convertidos para real_t aqui.
+typedef struct FirFilter FirFilter;
+FirFilter* fir_filter_create(const double* taps, size_t num_taps);
+size_t fir_filter_block_size(const FirFilter* filter);
+size_t fir_filter_process(FirFilter* filter, const real_t* in, size_t n, real_t* out);
+size_t fir_filter_flush(FirFilter* filter, real_t* out);
+void fir_filter_destroy(FirFilter* filter);
+
+// --- IIR ---
+
+// Maior ordem aceita (o passa-banda tem o dobro de polos).
+#define IIR_MAX_ORDER 16
+
+// Butterworth de ordem 'order' pela transformação bilinear (com pré-distorção
+// das frequências de corte), fatorado em biquads na forma direta II transposta.
+// Amostra a amostra e sem latência: *_process devolve sempre 'n' amostras e
+// *_flush não produz nada. Como todo IIR, a fase não é linear. Coeficientes e
+// estados ficam sempre em double, mesmo com real_t float. NULL em erro.
+typedef struct IirFilter IirFilter;
+IirFilter* iir_butterworth_create(const FilterSpec* spec, uint32_t sample_rate, int order);
+size_t iir_filter_num_sections(const IirFilter* filter);
+size_t iir_filter_block_size(const IirFilter* filter);
+size_t iir_filter_process(IirFilter* filter, const real_t* in, size_t n, real_t* out);
+size_t iir_filter_flush(IirFilter* filter, real_t* out);
+void iir_filter_destroy(IirFilter* filter);
+
+// --- Sinal inteiro em memória ---
+// Aplicam o filtro a cada canal (em paralelo), no lugar. Retornam 0 ou -1.
+int apply_fir_filter(WavData* wav_data, const double* taps, size_t num_taps);
+int apply_iir_filter(WavData* wav_data, const FilterSpec* spec, int order);
+
+#endif //PROJETO_AUDIO_FILTERS_H
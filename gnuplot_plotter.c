@@ -1,62 +1,348 @@
 #include "gnuplot_plotter.h"
 #include "fft.h"
+#include "trace.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <signal.h>
+#include <sys/wait.h>
 
-void plot_signal_to_file(const char* filename, const WavData* data) {
-    FILE* fp = fopen(filename, "w");
+// Tamanho do gráfico renderizado em arquivo. Os dados são reduzidos para
+// PLOT_WIDTH_PX colunas: mais pontos que isso não aparecem na imagem.
+#define PLOT_WIDTH_PX 1280
+#define PLOT_HEIGHT_PX 480
+
+// Escreve uma linha do arquivo binário: 1 + num_channels floats.
+static void write_row(FILE* fp, float* row, float x, const float* values, uint16_t num_channels) {
+    row[0] = x;
+    memcpy(row + 1, values, num_channels * sizeof(float));
+    fwrite(row, sizeof(float), (size_t)num_channels + 1, fp);
+}
+
+void plot_signal_to_file(const char* filename, const WavData* data, double zoom_duration_ms) {
+    FILE* fp = fopen(filename, "wb");
     if (!fp) {
         perror("Erro ao criar arquivo de dados para plotagem");
         return;
     }
-    for (uint32_t i = 0; i < data->num_samples; i++) {
-        fprintf(fp, "%f %f\n", (double)i / data->sample_rate, data->data_double[i]);
+    TRACE_BEGIN(span, "plot_data");
+
+    // Só o trecho visível é gravado.
+    size_t visible = data->num_samples;
+    if (zoom_duration_ms > 0) {
+        size_t zoom_samples = (size_t)(zoom_duration_ms / 1000.0 * data->sample_rate) + 1;
+        if (zoom_samples < visible) visible = zoom_samples;
+    }
+
+    uint16_t num_channels = data->num_channels;
+    float* row = (float*)malloc(((size_t)num_channels + 1) * sizeof(float));
+    float* lows = (float*)malloc((size_t)num_channels * 2 * sizeof(float));
+    float* highs = lows + num_channels;
+
+    if (visible <= 2 * PLOT_WIDTH_PX) {
+        // Poucos pontos: grava todas as amostras.
+        for (size_t i = 0; i < visible; i++) {
+            for (uint16_t c = 0; c < num_channels; c++) {
+                lows[c] = (float)wav_channel(data, c)[i];
+            }
+            write_row(fp, row, (float)((double)i / data->sample_rate), lows, num_channels);
+        }
+    } else {
+        // Decimação min/max: cada coluna de pixels vira dois pontos (mínimo e
+        // máximo do intervalo), o que preserva o envelope e os picos do sinal.
+        for (size_t b = 0; b < PLOT_WIDTH_PX; b++) {
+            size_t begin = b * visible / PLOT_WIDTH_PX;
+            size_t end = (b + 1) * visible / PLOT_WIDTH_PX;
+            for (uint16_t c = 0; c < num_channels; c++) {
+                const real_t* channel = wav_channel(data, c);
+                double lo = channel[begin], hi = channel[begin];
+                for (size_t i = begin + 1; i < end; i++) {
+                    if (channel[i] < lo) lo = channel[i];
+                    if (channel[i] > hi) hi = channel[i];
+                }
+                lows[c] = (float)lo;
+                highs[c] = (float)hi;
+            }
+            write_row(fp, row, (float)((double)begin / data->sample_rate), lows, num_channels);
+            write_row(fp, row, (float)((double)(begin + end) / 2 / data->sample_rate), highs, num_channels);
+        }
     }
+
+    free(lows);
+    free(row);
     fclose(fp);
+    TRACE_END(span, visible * num_channels * sizeof(real_t));
 }
 
-void plot_spectrum_to_file(const char* filename, const Complex* spectrum, size_t fft_size, uint32_t sample_rate) {
-    FILE* fp = fopen(filename, "w");
+int plot_signal_range_to_file(const char* filename, const PeakIndex* index, double start_s, double end_s) {
+    const WavData* info = peak_index_info(index);
+    double rate = info->sample_rate;
+    uint64_t first = (start_s > 0.0) ? (uint64_t)llround(start_s * rate) : 0;
+    uint64_t last = (end_s > 0.0) ? (uint64_t)llround(end_s * rate) : info->num_samples;
+    if (last > info->num_samples) last = info->num_samples;
+    if (first >= last) {
+        fprintf(stderr, "Trecho vazio: %.3f a %.3f s (o arquivo tem %.3f s).\n", start_s, end_s, info->num_samples / rate);
+        return -1;
+    }
+
+    FILE* fp = fopen(filename, "wb");
+    if (!fp) {
+        perror("Erro ao criar arquivo de dados para plotagem");
+        return -1;
+    }
+    TRACE_BEGIN(span, "plot_data");
+
+    // Como em plot_signal_to_file: todas as amostras se forem poucas; senão,
+    // mínimo e máximo de cada coluna de pixels.
+    uint64_t count = last - first;
+    int decimated = (count > 2 * PLOT_WIDTH_PX);
+    size_t num_columns = decimated ? PLOT_WIDTH_PX : (size_t)count;
+    uint16_t num_channels = info->num_channels;
+    PeakColumn* columns = (PeakColumn*)malloc(num_columns * num_channels * sizeof(PeakColumn));
+    float* row = (float*)malloc(((size_t)num_channels + 1) * sizeof(float));
+    float* lows = (float*)malloc((size_t)num_channels * 2 * sizeof(float));
+    if (!columns || !row || !lows) {
+        fprintf(stderr, "Memória insuficiente para os dados do gráfico.\n");
+        free(lows);
+        free(row);
+        free(columns);
+        fclose(fp);
+        return -1;
+    }
+    float* highs = lows + num_channels;
+
+    num_columns = peak_index_query(index, first, count, num_columns, columns);
+    for (size_t b = 0; b < num_columns; b++) {
+        uint64_t begin = first + b * count / num_columns;
+        uint64_t end = first + (b + 1) * count / num_columns;
+        for (uint16_t c = 0; c < num_channels; c++) {
+            lows[c] = columns[b * num_channels + c].min;
+            highs[c] = columns[b * num_channels + c].max;
+        }
+        write_row(fp, row, (float)(begin / rate), lows, num_channels);
+        if (decimated) write_row(fp, row, (float)((begin + end) / 2.0 / rate), highs, num_channels);
+    }
+
+    free(lows);
+    free(row);
+    free(columns);
+    fclose(fp);
+    TRACE_END(span, num_columns * num_channels * sizeof(PeakColumn));
+    return num_columns > 0 ? 0 : -1;
+}
+
+// Bins igualmente espaçados (freq_start + i * freq_step) de 'num_channels' espectros
+// de 'num_bins' valores cada. Com mais bins que pixels, cada coluna guarda a
+// maior magnitude do intervalo, para que nenhum pico desapareça do gráfico.
+// Retorna -1 se faltar memória.
+static int write_spectrum_columns(FILE* fp, const Complex* spectrum, size_t num_bins, double freq_start,
+                                   double freq_step, uint16_t num_channels) {
+    size_t num_columns = (num_bins > 2 * PLOT_WIDTH_PX) ? 2 * PLOT_WIDTH_PX : num_bins;
+    float* row = (float*)malloc(((size_t)num_channels + 1) * sizeof(float));
+    float* peaks = (float*)malloc((size_t)num_channels * sizeof(float));
+    if (!row || !peaks) {
+        fprintf(stderr, "Memória insuficiente para os dados do gráfico.\n");
+        free(peaks);
+        free(row);
+        return -1;
+    }
+
+    for (size_t b = 0; b < num_columns; b++) {
+        size_t begin = b * num_bins / num_columns;
+        size_t end = (b + 1) * num_bins / num_columns;
+        for (uint16_t c = 0; c < num_channels; c++) {
+            double peak = 0.0;
+            for (size_t i = begin; i < end; i++) {
+                const Complex* bin = &spectrum[c * num_bins + i];
+                double mag = sqrt(bin->real * bin->real + bin->imag * bin->imag);
+                if (mag > peak) peak = mag;
+            }
+            peaks[c] = (float)peak;
+        }
+        double freq = freq_start + (double)begin * freq_step;
+        write_row(fp, row, (float)freq, peaks, num_channels);
+    }
+
+    free(peaks);
+    free(row);
+    return 0;
+}
+
+void plot_spectrum_to_file(const char* filename, const Complex* spectrum, size_t fft_size, uint32_t sample_rate, uint16_t num_channels) {
+    FILE* fp = fopen(filename, "wb");
     if (!fp) {
         perror("Erro ao criar arquivo de dados do espectro");
         return;
     }
-    for (size_t i = 0; i <= fft_size / 2; i++) {
-        double mag = sqrt(spectrum[i].real * spectrum[i].real + spectrum[i].imag * spectrum[i].imag);
-        double freq = (double)i * sample_rate / fft_size;
-        fprintf(fp, "%f %f\n", freq, mag);
+    TRACE_BEGIN(span, "plot_data");
+    size_t num_bins = fft_size / 2 + 1;
+    write_spectrum_columns(fp, spectrum, num_bins, 0.0, (double)sample_rate / fft_size, num_channels);
+    fclose(fp);
+    TRACE_END(span, num_bins * num_channels * sizeof(Complex));
+}
+
+int plot_band_spectrum_to_file(const char* filename, const Complex* spectrum, size_t num_bins, double freq_start,
+                               double freq_step, uint16_t num_channels) {
+    FILE* fp = fopen(filename, "wb");
+    if (!fp) {
+        perror("Erro ao criar arquivo de dados do espectro");
+        return -1;
     }
+    TRACE_BEGIN(span, "plot_data");
+    int status = write_spectrum_columns(fp, spectrum, num_bins, freq_start, freq_step, num_channels);
     fclose(fp);
+    TRACE_END(span, num_bins * num_channels * sizeof(Complex));
+    return status;
 }
 
-// ATUALIZADO: Função modificada para aceitar e usar o parâmetro de zoom.
-void invoke_gnuplot(const char* data_filename, const char* title, const char* xlabel, const char* ylabel, int is_log_scale, double zoom_duration_ms) {
-    FILE* gnuplot_pipe = popen("gnuplot -persistent", "w");
-    if (gnuplot_pipe) {
-        // Estilos para deixar o gráfico mais bonito
-        fprintf(gnuplot_pipe, "set title '%s' font ',14'\n", title);
-        fprintf(gnuplot_pipe, "set xlabel '%s'\n", xlabel);
-        fprintf(gnuplot_pipe, "set ylabel '%s'\n", ylabel);
-        fprintf(gnuplot_pipe, "set grid\n"); // Adiciona um grid de fundo
-        fprintf(gnuplot_pipe, "set zeroaxis\n"); // Desenha uma linha no eixo zero
-
-        // LÓGICA DO ZOOM: Se um tempo de zoom foi dado...
-        if (zoom_duration_ms > 0) {
-            // ...converte de milissegundos para segundos e define o range do eixo X.
-            double zoom_seconds = zoom_duration_ms / 1000.0;
-            fprintf(gnuplot_pipe, "set xrange [0:%f]\n", zoom_seconds);
-        }
+// Comando "set terminal" para renderizar em arquivo, escolhido pela extensão.
+// Retorna NULL se a extensão não é suportada.
+static const char* output_terminal(const char* output_file) {
+    const char* ext = strrchr(output_file, '.');
+    if (ext && strcmp(ext, ".png") == 0) return "png";
+    if (ext && strcmp(ext, ".svg") == 0) return "svg";
+    return NULL;
+}
 
-        if (is_log_scale) {
-            fprintf(gnuplot_pipe, "set logscale y\n");
+// Abre o gnuplot já configurado para a saída pedida: janela interativa ou,
+// com 'output_file', renderização direta em arquivo. NULL em erro.
+static FILE* open_gnuplot(const char* output_file) {
+    const char* terminal = NULL;
+    if (output_file) {
+        terminal = output_terminal(output_file);
+        if (!terminal) {
+            fprintf(stderr, "Formato de gráfico não suportado: '%s' (use .png ou .svg).\n", output_file);
+            return NULL;
         }
+    }
+
+    // Se o gnuplot não existir, o shell do popen sai na hora e a primeira escrita
+    // no pipe mataria o programa com SIGPIPE; ignorado, o erro aparece no pclose.
+    signal(SIGPIPE, SIG_IGN);
+
+    // Sem janela, o gnuplot só renderiza o arquivo e termina.
+    FILE* gnuplot_pipe = popen(output_file ? "gnuplot" : "gnuplot -persistent", "w");
+    if (!gnuplot_pipe) {
+        fprintf(stderr, "Gnuplot não encontrado. Verifique se ele está instalado e no seu PATH.\n");
+        return NULL;
+    }
+    if (terminal) {
+        fprintf(gnuplot_pipe, "set terminal %s size %d,%d\n", terminal, PLOT_WIDTH_PX, PLOT_HEIGHT_PX);
+        fprintf(gnuplot_pipe, "set output '%s'\n", output_file);
+    }
+    return gnuplot_pipe;
+}
 
-        // PLOT MELHORADO: Linha mais grossa (lw 2) e cor azul (lc 'blue')
-        fprintf(gnuplot_pipe, "plot '%s' with lines lw 2 lc 'blue' title 'Sinal'\n", data_filename);
-        fflush(gnuplot_pipe);
-        pclose(gnuplot_pipe);
+// Espera o gnuplot terminar e informa o resultado. O trecho "gnuplot" mede
+// só a renderização: a espera pelo fechamento da janela interativa também entra.
+static void close_gnuplot(FILE* gnuplot_pipe, const char* output_file) {
+    TRACE_BEGIN(span, "gnuplot");
+    fflush(gnuplot_pipe);
+    int status = pclose(gnuplot_pipe);
+    TRACE_END(span, 0);
+    if (status == -1 || !WIFEXITED(status) || WEXITSTATUS(status) == 127) {
+        fprintf(stderr, "Gnuplot não encontrado. Verifique se ele está instalado e no seu PATH.\n");
+    } else if (output_file) {
+        printf("Gráfico salvo em '%s'.\n", output_file);
+    } else {
         printf("Gráfico gerado. Feche a janela do gráfico para continuar...\n");
+    }
+}
+
+// ATUALIZADO: Função modificada para aceitar e usar o parâmetro de zoom.
+void invoke_gnuplot(const char* data_filename, const char* title, const char* xlabel, const char* ylabel, int is_log_scale, double zoom_duration_ms, int num_series, const char* output_file) {
+    FILE* gnuplot_pipe = open_gnuplot(output_file);
+    if (!gnuplot_pipe) return;
+
+    // Estilos para deixar o gráfico mais bonito
+    fprintf(gnuplot_pipe, "set title '%s' font ',14'\n", title);
+    fprintf(gnuplot_pipe, "set xlabel '%s'\n", xlabel);
+    fprintf(gnuplot_pipe, "set ylabel '%s'\n", ylabel);
+    fprintf(gnuplot_pipe, "set grid\n"); // Adiciona um grid de fundo
+    fprintf(gnuplot_pipe, "set zeroaxis\n"); // Desenha uma linha no eixo zero
+
+    // LÓGICA DO ZOOM: Se um tempo de zoom foi dado...
+    if (zoom_duration_ms > 0) {
+        // ...converte de milissegundos para segundos e define o range do eixo X.
+        double zoom_seconds = zoom_duration_ms / 1000.0;
+        fprintf(gnuplot_pipe, "set xrange [0:%f]\n", zoom_seconds);
+    }
+
+    if (is_log_scale) {
+        fprintf(gnuplot_pipe, "set logscale y\n");
+    }
+
+    // Os dados são binários: uma linha = 1 + num_series floats de 32 bits.
+    int columns = (num_series < 1 ? 1 : num_series) + 1;
+    char* format = (char*)malloc((size_t)columns * 6 + 1);
+    format[0] = '\0';
+    for (int c = 0; c < columns; c++) {
+        strcat(format, "%float");
+    }
+
+    // PLOT MELHORADO: Linha mais grossa (lw 2) e cor azul (lc 'blue') no primeiro canal
+    if (num_series <= 1) {
+        fprintf(gnuplot_pipe, "plot '%s' binary format='%s' using 1:2 with lines lw 2 lc 'blue' title 'Sinal'\n",
+                data_filename, format);
     } else {
-        fprintf(stderr, "Gnuplot não encontrado. Verifique se ele está instalado e no seu PATH.\n");
+        // Uma curva por canal (colunas 2, 3, ...)
+        fprintf(gnuplot_pipe, "plot '%s' binary format='%s' using 1:2 with lines lw 2 lc 'blue' title 'Canal 1'",
+                data_filename, format);
+        for (int c = 1; c < num_series; c++) {
+            fprintf(gnuplot_pipe, ", '' binary format='%s' using 1:%d with lines lw 2 title 'Canal %d'", format, c + 2, c + 1);
+        }
+        fprintf(gnuplot_pipe, "\n");
+    }
+    free(format);
+    close_gnuplot(gnuplot_pipe, output_file);
+}
+
+void plot_spectrogram_to_file(const char* filename, const Spectrogram* spectrogram) {
+    FILE* fp = fopen(filename, "wb");
+    if (!fp) {
+        perror("Erro ao criar arquivo do espectrograma");
+        return;
     }
-}
\ No newline at end of file
+    TRACE_BEGIN(span, "plot_data");
+
+    // Formato "binary matrix" do gnuplot, em float32: a primeira linha traz o
+    // número de bins e a frequência de cada um; cada linha seguinte, o instante
+    // (centro do quadro) e os valores em dB daquele quadro.
+    size_t num_bins = spectrogram->num_bins;
+    double rate = spectrogram->sample_rate;
+    float* row = (float*)malloc((num_bins + 1) * sizeof(float));
+    row[0] = (float)num_bins;
+    for (size_t k = 0; k < num_bins; k++) {
+        row[k + 1] = (float)(k * rate / spectrogram->frame_size);
+    }
+    fwrite(row, sizeof(float), num_bins + 1, fp);
+
+    for (size_t f = 0; f < spectrogram->num_frames; f++) {
+        double center = (double)(f * spectrogram->hop_size) + spectrogram->frame_size / 2.0;
+        row[0] = (float)(center / rate);
+        fwrite(row, sizeof(float), 1, fp);
+        fwrite(spectrogram->magnitudes_db + f * num_bins, sizeof(float), num_bins, fp);
+    }
+
+    free(row);
+    fclose(fp);
+    TRACE_END(span, spectrogram->num_frames * num_bins * sizeof(float));
+}
+
+void invoke_gnuplot_heatmap(const char* data_filename, const char* title, const char* output_file) {
+    FILE* gnuplot_pipe = open_gnuplot(output_file);
+    if (!gnuplot_pipe) return;
+
+    fprintf(gnuplot_pipe, "set title '%s' font ',14'\n", title);
+    fprintf(gnuplot_pipe, "set xlabel 'Tempo (s)'\n");
+    fprintf(gnuplot_pipe, "set ylabel 'Frequência (Hz)'\n");
+    fprintf(gnuplot_pipe, "set cblabel 'Magnitude (dB)'\n");
+    // Faixa dinâmica de 120 dB abaixo do fundo de escala.
+    fprintf(gnuplot_pipe, "set cbrange [-120:0]\n");
+    fprintf(gnuplot_pipe, "set palette rgbformulae 33,13,10\n");
+    fprintf(gnuplot_pipe, "set autoscale xfix\n");
+    fprintf(gnuplot_pipe, "set autoscale yfix\n");
+    fprintf(gnuplot_pipe, "plot '%s' binary matrix with image notitle\n", data_filename);
+    close_gnuplot(gnuplot_pipe, output_file);
+}
@@ -3,12 +3,39 @@
 
 #include "wav_handler.h"
 #include "fft.h"
+#include "stft.h"
+#include "peak_index.h"
 
-void plot_signal_to_file(const char* filename, const WavData* data);
-void plot_spectrum_to_file(const char* filename, const Complex* spectrum, size_t fft_size, uint32_t sample_rate);
+// Os arquivos de dados são binários (float32 nativo), uma linha por ponto:
+// a coluna do eixo X seguida de uma coluna por canal. Os dados já vêm reduzidos
+// à resolução do gráfico, então o tamanho não depende da duração do sinal.
+
+// Grava só o trecho visível (os primeiros 'zoom_duration_ms'; 0 = o sinal
+// inteiro), com decimação min/max quando há mais amostras que pixels.
+void plot_signal_to_file(const char* filename, const WavData* data, double zoom_duration_ms);
+// Trecho [start_s, end_s) do WAV do índice (end_s <= 0: até o fim), lido pelo
+// índice de picos: o custo depende da largura do gráfico, não da duração do
+// trecho. O eixo X traz o tempo desde o início do arquivo. Retorna 0 ou -1.
+int plot_signal_range_to_file(const char* filename, const PeakIndex* index, double start_s, double end_s);
+// 'spectrum' no layout de get_spectrum: fft_size / 2 + 1 bins por canal.
+void plot_spectrum_to_file(const char* filename, const Complex* spectrum, size_t fft_size, uint32_t sample_rate, uint16_t num_channels);
+// Espectro de uma faixa (band_spectrum.h): 'num_bins' bins por canal, o bin i
+// em freq_start + i * freq_step Hz. Retorna 0 ou -1.
+int plot_band_spectrum_to_file(const char* filename, const Complex* spectrum, size_t num_bins, double freq_start,
+                               double freq_step, uint16_t num_channels);
 
 // ATUALIZADO: Adicionado parâmetro 'zoom_duration_ms' para controlar o zoom.
 // Se for 0, mostra o sinal completo. Se for > 0, dá zoom nesse tempo em milissegundos.
-void invoke_gnuplot(const char* data_filename, const char* title, const char* xlabel, const char* ylabel, int is_log_scale, double zoom_duration_ms);
+// 'num_series' é o número de colunas de dados (canais) a desenhar.
+// Se 'output_file' não for NULL, renderiza direto para PNG ou SVG (conforme a
+// extensão), sem abrir janela; senão, abre a janela interativa do gnuplot.
+void invoke_gnuplot(const char* data_filename, const char* title, const char* xlabel, const char* ylabel, int is_log_scale, double zoom_duration_ms, int num_series, const char* output_file);
+
+// Espectrograma no formato "binary matrix" do gnuplot (float32): primeira linha
+// com o número de bins e as frequências; depois uma linha por quadro, com o
+// instante e os valores em dB.
+void plot_spectrogram_to_file(const char* filename, const Spectrogram* spectrogram);
+// Desenha o espectrograma como mapa de calor (tempo x frequência x dB).
+void invoke_gnuplot_heatmap(const char* data_filename, const char* title, const char* output_file);
 
 #endif //PROJETO_AUDIO_GNUPLOT_PLOTTER_H
\ No newline at end of file
@@ -1,22 +1,132 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
 
 #include "wav_handler.h"
 #include "fft.h"
 #include "dsp_operations.h"
 #include "gnuplot_plotter.h"
+#include "stream_processing.h"
+#include "thread_pool.h"
+#include "batch.h"
+#include "stft.h"
+#include "filters.h"
+#include "trace.h"
+#include "mixer.h"
+#include "convolution.h"
+#include "peak_index.h"
+#include "band_spectrum.h"
+#include "signal_gen.h"
 
 void print_usage(const char* prog_name) {
     fprintf(stderr, "Uso:\n");
     fprintf(stderr, "  %s mix <in1.wav> <in2.wav> <out.wav>\n", prog_name);
+    fprintf(stderr, "  %s mix <in.wav[:ganho_db[:atraso_s]]>... -o <out.wav> [--rate HZ] [--no-normalize]\n", prog_name);
     fprintf(stderr, "  %s filter-fft <low|high> <freq_corte_hz> <in.wav> <out.wav>\n", prog_name);
     fprintf(stderr, "  %s filter-sma <tamanho_janela> <in.wav> <out.wav>\n", prog_name);
-    fprintf(stderr, "  %s plot-spectrum <in.wav>\n", prog_name);
-    fprintf(stderr, "  %s plot-signal <in.wav>\n", prog_name);
+    fprintf(stderr, "  %s filter-fir <low|high|band> <freq_hz|f1:f2> <coeficientes> <in.wav> <out.wav> [--window W]\n", prog_name);
+    fprintf(stderr, "  %s filter-iir <low|high|band> <freq_hz|f1:f2> <ordem> <in.wav> <out.wav>\n", prog_name);
+    fprintf(stderr, "  %s resample <taxa_hz> <in.wav> <out.wav>\n", prog_name);
+    fprintf(stderr, "  %s meter <janela_ms> <in.wav> <niveis.csv>\n", prog_name);
+    fprintf(stderr, "  %s convolve <in.wav> <resposta_impulso.wav> <out.wav>\n", prog_name);
+    fprintf(stderr, "  %s xcorr <referencia.wav> <outro.wav> [--max-lag S]\n", prog_name);
+    fprintf(stderr, "  %s plot-spectrum <in.wav> [--band F1:F2 [--bins K]]\n", prog_name);
+    fprintf(stderr, "  %s plot-signal <in.wav> [--range INICIO:FIM]\n", prog_name);
+    fprintf(stderr, "  %s spectrogram <in.wav> <out.bin> [--frame N] [--hop N] [--window hann|hamming|blackman]\n", prog_name);
+    fprintf(stderr, "  %s compare <referencia.wav> <teste.wav>\n", prog_name);
+    fprintf(stderr, "  %s generate <sine|chirp|white|pink> <segundos> <out.wav> [--rate HZ]\n", prog_name);
+    fprintf(stderr, "  %s batch <manifesto.txt>\n", prog_name);
+    fprintf(stderr, "\nOpções:\n");
+    fprintf(stderr, "  --stream      Processa os comandos filter-*, resample e convolve em blocos, com memória constante\n");
+    fprintf(stderr, "                (a leitura e a gravação rodam em threads próprias, em paralelo ao processamento)\n");
+    fprintf(stderr, "  --threads N   Usa N threads na FFT, no filtro e na conversão de amostras (0 = todos os núcleos;\n");
+    fprintf(stderr, "                padrão 1, ou todos os núcleos no modo batch)\n");
+    fprintf(stderr, "  --plot-out F  Salva o gráfico em F (.png ou .svg), sem abrir janela\n");
+    fprintf(stderr, "  --frame N     spectrogram: amostras por quadro (padrão 2048)\n");
+    fprintf(stderr, "  --hop N       spectrogram: avanço entre quadros (padrão 512)\n");
+    fprintf(stderr, "  --window W    spectrogram/filter-fir: janela hann, hamming ou blackman\n");
+    fprintf(stderr, "                (padrão hann no spectrogram e blackman no filter-fir)\n");
+    fprintf(stderr, "  --bits B      Formato dos WAV gravados: 16, 24, 32 (PCM) ou float (padrão: o da entrada)\n");
+    fprintf(stderr, "  --dither      Soma dither TPDF ao quantizar a saída para inteiros\n");
+    fprintf(stderr, "  --plot        No modo batch, gera os gráficos em PNG ao final (desligados por padrão)\n");
+    fprintf(stderr, "  -o F          mix: arquivo de saída (aceita qualquer número de entradas)\n");
+    fprintf(stderr, "  --rate HZ     mix: taxa da saída (padrão: a da primeira entrada); as outras são convertidas\n");
+    fprintf(stderr, "                generate: taxa do sinal (padrão 48000)\n");
+    fprintf(stderr, "  --no-normalize mix: não reduz o ganho quando a soma passa de 1.0 (satura)\n");
+    fprintf(stderr, "  --max-lag S   xcorr: maior atraso procurado, em segundos, para cada lado (padrão 10)\n");
+    fprintf(stderr, "  --range A:B   plot-signal: trecho de A a B segundos (B vazio = até o fim), pelo índice\n");
+    fprintf(stderr, "                de picos '<in.wav>.peaks' (padrão: os primeiros 20 ms)\n");
+    fprintf(stderr, "  --band F1:F2  plot-spectrum: só a faixa de F1 a F2 Hz, em K bins (chirp-z), sem a FFT do\n");
+    fprintf(stderr, "                arquivo inteiro; com até %d bins (ex.: F1:F1 --bins 1), mostra o nível de cada\n", BAND_GOERTZEL_MAX_BINS);
+    fprintf(stderr, "                frequência (Goertzel) em vez do gráfico\n");
+    fprintf(stderr, "  --bins K      plot-spectrum --band: número de frequências da faixa (padrão %d)\n", BAND_DEFAULT_BINS);
+    fprintf(stderr, "  --profile     Ao final, mostra tempo, vazão e alocações de cada etapa\n");
+    fprintf(stderr, "  --trace F     Grava as etapas em F (JSON do Chrome: chrome://tracing ou Perfetto)\n");
+    fprintf(stderr, "\nAmostras processadas em %s (ver PROJETO_AUDIO_SINGLE_PRECISION no CMake).\n", REAL_T_NAME);
+}
+
+// Remove 'flag' de argv (se presente), ajustando argc. Retorna 1 se a encontrou.
+static int take_flag(int* argc, char* argv[], const char* flag) {
+    for (int i = 1; i < *argc; i++) {
+        if (strcmp(argv[i], flag) == 0) {
+            for (int j = i; j < *argc - 1; j++) {
+                argv[j] = argv[j + 1];
+            }
+            (*argc)--;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Como take_flag, mas para opções com valor ("--threads 4"). Retorna NULL se ausente.
+static const char* take_option(int* argc, char* argv[], const char* option) {
+    for (int i = 1; i < *argc - 1; i++) {
+        if (strcmp(argv[i], option) == 0) {
+            const char* value = argv[i + 1];
+            for (int j = i; j < *argc - 2; j++) {
+                argv[j] = argv[j + 2];
+            }
+            *argc -= 2;
+            return value;
+        }
+    }
+    return NULL;
+}
+
+// Relatórios de --profile e --trace. Rodam no atexit porque vários comandos
+// terminam com return antecipado.
+static int profile_mode = 0;
+static const char* trace_output = NULL;
+
+static void report_trace(void) {
+    if (profile_mode) trace_print_summary(stderr);
+    if (trace_output && trace_write_chrome(trace_output) == 0) {
+        fprintf(stderr, "Trace salvo em '%s'.\n", trace_output);
+    }
 }
 
 int main(int argc, char* argv[]) {
+    int stream_mode = take_flag(&argc, argv, "--stream");
+    int plot_mode = take_flag(&argc, argv, "--plot");
+    const char* threads_option = take_option(&argc, argv, "--threads");
+    const char* plot_output = take_option(&argc, argv, "--plot-out");
+    const char* frame_option = take_option(&argc, argv, "--frame");
+    const char* hop_option = take_option(&argc, argv, "--hop");
+    const char* window_option = take_option(&argc, argv, "--window");
+    const char* bits_option = take_option(&argc, argv, "--bits");
+    int dither_mode = take_flag(&argc, argv, "--dither");
+    profile_mode = take_flag(&argc, argv, "--profile");
+    trace_output = take_option(&argc, argv, "--trace");
+    const char* mix_output = take_option(&argc, argv, "-o");
+    const char* rate_option = take_option(&argc, argv, "--rate");
+    int no_normalize = take_flag(&argc, argv, "--no-normalize");
+    const char* max_lag_option = take_option(&argc, argv, "--max-lag");
+    const char* range_option = take_option(&argc, argv, "--range");
+    const char* band_option = take_option(&argc, argv, "--band");
+    const char* bins_option = take_option(&argc, argv, "--bins");
+
     if (argc < 3) {
         print_usage(argv[0]);
         return 1;
@@ -24,59 +134,347 @@ int main(int argc, char* argv[]) {
 
     const char* command = argv[1];
 
-    if (strcmp(command, "mix") == 0) {
-        if (argc != 5) { print_usage(argv[0]); return 1; }
-        WavData* wav1 = read_wav_file(argv[2]);
-        WavData* wav2 = read_wav_file(argv[3]);
-        if (!wav1 || !wav2) return 1;
+    if (profile_mode || trace_output) {
+        if (trace_enable() != 0) return 1;
+        atexit(report_trace);
+    }
 
-        printf("Mixando '%s' e '%s'...\n", argv[2], argv[3]);
-        WavData* mixed_wav = mix_audio(wav1, wav2);
-        write_wav_file(argv[4], mixed_wav);
-        printf("Arquivo mixado salvo em '%s'.\n", argv[4]);
+    if (bits_option || dither_mode) {
+        WavOutputOptions output = { 0, 0, dither_mode };
+        if (bits_option && strcmp(bits_option, "float") == 0) {
+            output.format = WAV_FORMAT_IEEE_FLOAT;
+            output.bits_per_sample = 32;
+        } else if (bits_option) {
+            output.format = WAV_FORMAT_PCM;
+            output.bits_per_sample = (uint16_t)atoi(bits_option);
+        }
+        if (wav_set_output_options(&output) != 0) return 1;
+    }
 
-        plot_signal_to_file("plot_data.dat", mixed_wav);
-        // ATUALIZADO: Adicionado '20.0' para dar zoom de 20ms
-        invoke_gnuplot("plot_data.dat", "Sinal Mixado", "Tempo (s)", "Amplitude", 0, 20.0);
+    if (threads_option) {
+        thread_pool_init(atoi(threads_option));
+    } else if (strcmp(command, "batch") == 0) {
+        thread_pool_init(0);
+    }
 
-        free_wav_data(wav1);
-        free_wav_data(wav2);
-        free_wav_data(mixed_wav);
+    if (strcmp(command, "batch") == 0) {
+        if (argc != 3) { print_usage(argv[0]); return 1; }
+        BatchOptions options = { stream_mode, plot_mode };
+        int status = run_batch(argv[2], &options);
+        thread_pool_shutdown();
+        return status == 0 ? 0 : 1;
+
+    } else if (strcmp(command, "mix") == 0) {
+        // "mix a b out" (forma original) ou "mix a b c ... -o out".
+        const char* out_path = mix_output;
+        int num_inputs = argc - 2;
+        if (!out_path) {
+            if (argc != 5) { print_usage(argv[0]); return 1; }
+            out_path = argv[4];
+            num_inputs = 2;
+        }
+
+        MixInput* inputs = (MixInput*)malloc((size_t)num_inputs * sizeof(MixInput));
+        for (int i = 0; i < num_inputs; i++) {
+            if (mix_parse_input(argv[2 + i], &inputs[i]) != 0) {
+                fprintf(stderr, "Entrada inválida para a mixagem: '%s'.\n", argv[2 + i]);
+                free(inputs);
+                return 1;
+            }
+        }
+        MixOptions options = { rate_option ? (uint32_t)atoi(rate_option) : 0, !no_normalize };
+
+        printf("Mixando %d arquivos...\n", num_inputs);
+        int status = mix_files(inputs, (size_t)num_inputs, out_path, &options);
+        free(inputs);
+        if (status != 0) return 1;
+        printf("Arquivo mixado salvo em '%s'.\n", out_path);
+
+        // Para o gráfico (zoom de 20 ms), basta o início da saída.
+        WavMap* map = wav_map_open(out_path);
+        if (!map) return 1;
+        WavData* head = wav_map_load(map, 0, (size_t)(wav_map_info(map)->sample_rate * 20.0 / 1000.0) + 1);
+        wav_map_close(map);
+        if (!head) return 1;
+        plot_signal_to_file("plot_data.dat", head, 20.0);
+        invoke_gnuplot("plot_data.dat", "Sinal Mixado", "Tempo (s)", "Amplitude", 0, 20.0, head->num_channels, plot_output);
+        free_wav_data(head);
 
     } else if (strcmp(command, "filter-fft") == 0) {
         if (argc != 6) { print_usage(argv[0]); return 1; }
         int is_high_pass = (strcmp(argv[2], "high") == 0);
         double cutoff = atof(argv[3]);
+
+        if (stream_mode) {
+            printf("Aplicando filtro FFT %s-pass com corte em %.2f Hz (streaming)...\n", is_high_pass ? "high" : "low", cutoff);
+            if (stream_fft_filter_file(argv[4], argv[5], cutoff, is_high_pass) != 0) return 1;
+            printf("Arquivo filtrado salvo em '%s'.\n", argv[5]);
+            return 0;
+        }
+
         WavData* wav = read_wav_file(argv[4]);
         if (!wav) return 1;
 
         printf("Aplicando filtro FFT %s-pass com corte em %.2f Hz...\n", is_high_pass ? "high" : "low", cutoff);
-        apply_fft_filter(wav, cutoff, is_high_pass);
-        write_wav_file(argv[5], wav);
+        if (apply_fft_filter(wav, cutoff, is_high_pass) != 0 || write_wav_file(argv[5], wav) != 0) {
+            free_wav_data(wav);
+            return 1;
+        }
         printf("Arquivo filtrado salvo em '%s'.\n", argv[5]);
 
-        plot_signal_to_file("plot_data.dat", wav);
+        plot_signal_to_file("plot_data.dat", wav, 20.0);
         // ATUALIZADO: Adicionado '20.0' para dar zoom de 20ms
-        invoke_gnuplot("plot_data.dat", "Sinal Filtrado (FFT)", "Tempo (s)", "Amplitude", 0, 20.0);
+        invoke_gnuplot("plot_data.dat", "Sinal Filtrado (FFT)", "Tempo (s)", "Amplitude", 0, 20.0, wav->num_channels, plot_output);
 
         free_wav_data(wav);
 
     } else if (strcmp(command, "filter-sma") == 0) {
         if (argc != 5) { print_usage(argv[0]); return 1; }
         int window_size = atoi(argv[2]);
+
+        if (stream_mode) {
+            printf("Aplicando filtro de Média Móvel com janela de %d amostras (streaming)...\n", window_size);
+            if (stream_sma_filter_file(argv[3], argv[4], window_size) != 0) return 1;
+            printf("Arquivo filtrado salvo em '%s'.\n", argv[4]);
+            return 0;
+        }
+
         WavData* wav = read_wav_file(argv[3]);
         if (!wav) return 1;
 
         printf("Aplicando filtro de Média Móvel com janela de %d amostras...\n", window_size);
         apply_sma_filter(wav, window_size);
-        write_wav_file(argv[4], wav);
+        if (write_wav_file(argv[4], wav) != 0) {
+            free_wav_data(wav);
+            return 1;
+        }
         printf("Arquivo filtrado salvo em '%s'.\n", argv[4]);
 
-        plot_signal_to_file("plot_data.dat", wav);
+        plot_signal_to_file("plot_data.dat", wav, 20.0);
         // ATUALIZADO: Adicionado '20.0' para dar zoom de 20ms
-        invoke_gnuplot("plot_data.dat", "Sinal Filtrado (Média Móvel)", "Tempo (s)", "Amplitude", 0, 20.0);
+        invoke_gnuplot("plot_data.dat", "Sinal Filtrado (Média Móvel)", "Tempo (s)", "Amplitude", 0, 20.0, wav->num_channels, plot_output);
+
+        free_wav_data(wav);
+
+    } else if (strcmp(command, "meter") == 0) {
+        if (argc != 5) { print_usage(argv[0]); return 1; }
+        double window_ms = atof(argv[2]);
+        printf("Medindo níveis de '%s' em janelas de %.1f ms...\n", argv[3], window_ms);
+        if (stream_level_meter_file(argv[3], argv[4], window_ms) != 0) return 1;
+        printf("Níveis salvos em '%s'.\n", argv[4]);
+
+    } else if (strcmp(command, "convolve") == 0) {
+        if (argc != 5) { print_usage(argv[0]); return 1; }
+
+        if (stream_mode) {
+            printf("Convoluindo '%s' com '%s' (streaming)...\n", argv[2], argv[3]);
+            if (stream_convolve_file(argv[2], argv[3], argv[4]) != 0) return 1;
+            printf("Arquivo convoluído salvo em '%s'.\n", argv[4]);
+            return 0;
+        }
+
+        WavData* wav = read_wav_file(argv[2]);
+        if (!wav) return 1;
+        WavData* impulse = read_wav_file(argv[3]);
+        if (!impulse) {
+            free_wav_data(wav);
+            return 1;
+        }
+
+        printf("Convoluindo '%s' com '%s' (%u amostras)...\n", argv[2], argv[3], impulse->num_samples);
+        WavData* convolved = convolve_audio(wav, impulse);
+        free_wav_data(wav);
+        free_wav_data(impulse);
+        if (!convolved) return 1;
+        if (write_wav_file(argv[4], convolved) != 0) {
+            free_wav_data(convolved);
+            return 1;
+        }
+        printf("Arquivo convoluído salvo em '%s'.\n", argv[4]);
+
+        plot_signal_to_file("plot_data.dat", convolved, 20.0);
+        invoke_gnuplot("plot_data.dat", "Sinal Convoluído", "Tempo (s)", "Amplitude", 0, 20.0, convolved->num_channels, plot_output);
+
+        free_wav_data(convolved);
+
+    } else if (strcmp(command, "xcorr") == 0) {
+        if (argc != 4) { print_usage(argv[0]); return 1; }
+        double max_lag_s = max_lag_option ? atof(max_lag_option) : 10.0;
+        if (max_lag_s <= 0.0) {
+            fprintf(stderr, "Atraso máximo inválido: '%s'.\n", max_lag_option);
+            return 1;
+        }
+        WavData* reference = read_wav_file(argv[2]);
+        if (!reference) return 1;
+        WavData* other = read_wav_file(argv[3]);
+        if (!other) {
+            free_wav_data(reference);
+            return 1;
+        }
+
+        printf("Correlacionando '%s' com '%s' (atrasos de até %g s)...\n", argv[3], argv[2], max_lag_s);
+        CorrelationPeak peak;
+        int status = find_alignment(reference, other, max_lag_s, &peak);
+        uint32_t sample_rate = reference->sample_rate;
+        free_wav_data(reference);
+        free_wav_data(other);
+        if (status != 0) return 1;
+        double lag_s = (double)peak.lag / sample_rate;
+
+        printf("  Atraso do pico: %lld amostras (%.6f s)\n", (long long)peak.lag, lag_s);
+        printf("  Correlação normalizada: %.4f%s\n", peak.coefficient, peak.value < 0.0 ? " (polaridade invertida)" : "");
+        printf("Para alinhar: %s mix %s %s:0:%.6f -o <out.wav>\n", argv[0], argv[2], argv[3], lag_s);
+
+    } else if (strcmp(command, "resample") == 0) {
+        if (argc != 5) { print_usage(argv[0]); return 1; }
+        int sample_rate = atoi(argv[2]);
+        if (sample_rate <= 0) {
+            fprintf(stderr, "Taxa de amostragem inválida: '%s'.\n", argv[2]);
+            return 1;
+        }
 
+        if (stream_mode) {
+            printf("Convertendo para %d Hz (streaming)...\n", sample_rate);
+            if (stream_resample_file(argv[3], argv[4], (uint32_t)sample_rate) != 0) return 1;
+            printf("Arquivo convertido salvo em '%s'.\n", argv[4]);
+            return 0;
+        }
+
+        WavData* wav = read_wav_file(argv[3]);
+        if (!wav) return 1;
+
+        printf("Convertendo de %u Hz para %d Hz...\n", wav->sample_rate, sample_rate);
+        WavData* resampled = resample_audio(wav, (uint32_t)sample_rate);
         free_wav_data(wav);
+        if (!resampled) return 1;
+        if (write_wav_file(argv[4], resampled) != 0) {
+            free_wav_data(resampled);
+            return 1;
+        }
+        printf("Arquivo convertido salvo em '%s'.\n", argv[4]);
+
+        plot_signal_to_file("plot_data.dat", resampled, 20.0);
+        invoke_gnuplot("plot_data.dat", "Sinal Convertido", "Tempo (s)", "Amplitude", 0, 20.0, resampled->num_channels, plot_output);
+
+        free_wav_data(resampled);
+
+    } else if (strcmp(command, "filter-fir") == 0 || strcmp(command, "filter-iir") == 0) {
+        if (argc != 7) { print_usage(argv[0]); return 1; }
+        int is_fir = (strcmp(command, "filter-fir") == 0);
+        FilterSpec spec;
+        if (filter_parse_spec(argv[2], argv[3], &spec) != 0) {
+            fprintf(stderr, "Filtro inválido: %s %s\n", argv[2], argv[3]);
+            return 1;
+        }
+        WindowType window = WINDOW_BLACKMAN;
+        if (window_option && stft_parse_window(window_option, &window) != 0) {
+            fprintf(stderr, "Janela desconhecida: %s\n", window_option);
+            return 1;
+        }
+        // Número de coeficientes (FIR) ou ordem (IIR).
+        int size = atoi(argv[4]);
+        if (size <= 0) {
+            fprintf(stderr, "%s inválido: %s\n", is_fir ? "Número de coeficientes" : "Ordem", argv[4]);
+            return 1;
+        }
+
+        if (stream_mode) {
+            printf("Aplicando filtro %s %s (%s %d) em %s Hz (streaming)...\n", is_fir ? "FIR" : "IIR Butterworth",
+                   argv[2], is_fir ? "coeficientes" : "ordem", size, argv[3]);
+            int status = is_fir ? stream_fir_filter_file(argv[5], argv[6], &spec, (size_t)size, window)
+                                : stream_iir_filter_file(argv[5], argv[6], &spec, size);
+            if (status != 0) return 1;
+            printf("Arquivo filtrado salvo em '%s'.\n", argv[6]);
+            return 0;
+        }
+
+        WavData* wav = read_wav_file(argv[5]);
+        if (!wav) return 1;
+
+        printf("Aplicando filtro %s %s (%s %d) em %s Hz...\n", is_fir ? "FIR" : "IIR Butterworth",
+               argv[2], is_fir ? "coeficientes" : "ordem", size, argv[3]);
+        int status;
+        if (is_fir) {
+            double* taps = fir_design(&spec, wav->sample_rate, (size_t)size, window);
+            status = taps ? apply_fir_filter(wav, taps, (size_t)size) : -1;
+            free(taps);
+        } else {
+            status = apply_iir_filter(wav, &spec, size);
+        }
+        if (status != 0) {
+            free_wav_data(wav);
+            return 1;
+        }
+        if (write_wav_file(argv[6], wav) != 0) {
+            free_wav_data(wav);
+            return 1;
+        }
+        printf("Arquivo filtrado salvo em '%s'.\n", argv[6]);
+
+        plot_signal_to_file("plot_data.dat", wav, 20.0);
+        invoke_gnuplot("plot_data.dat", is_fir ? "Sinal Filtrado (FIR)" : "Sinal Filtrado (IIR)", "Tempo (s)", "Amplitude",
+                       0, 20.0, wav->num_channels, plot_output);
+
+        free_wav_data(wav);
+
+    } else if (strcmp(command, "plot-spectrum") == 0 && band_option) {
+        if (argc != 3) { print_usage(argv[0]); return 1; }
+        char* end = NULL;
+        double f_start = strtod(band_option, &end);
+        double f_end = (end != band_option && *end == ':') ? atof(end + 1) : -1.0;
+        long num_bins = bins_option ? atol(bins_option) : BAND_DEFAULT_BINS;
+        if (f_end < 0.0 || num_bins < 1) {
+            fprintf(stderr, "Faixa inválida: '%s' (esperado F1:F2, em Hz) com %ld bins.\n", band_option, num_bins);
+            return 1;
+        }
+
+        // Só o arquivo mapeado: o custo depende de K, não da duração.
+        WavMap* map = wav_map_open(argv[2]);
+        if (!map) return 1;
+        const WavData* info = wav_map_info(map);
+        Complex* spectrum = band_spectrum(map, f_start, f_end, (size_t)num_bins);
+        if (!spectrum) {
+            wav_map_close(map);
+            return 1;
+        }
+        double step = (num_bins > 1) ? (f_end - f_start) / (double)(num_bins - 1) : 0.0;
+
+        if (num_bins <= BAND_GOERTZEL_MAX_BINS) {
+            printf("Nível de '%s' em %ld frequências:\n", argv[2], num_bins);
+            for (long k = 0; k < num_bins; k++) {
+                double freq = f_start + (double)k * step;
+                printf("  %10.3f Hz:", freq);
+                for (uint16_t c = 0; c < info->num_channels; c++) {
+                    double amplitude = band_tone_amplitude(spectrum[c * num_bins + k], freq, info->sample_rate, info->num_samples);
+                    printf("  canal %u %7.2f dBFS", c + 1, amplitude > 0.0 ? 20.0 * log10(amplitude) : -INFINITY);
+                }
+                printf("\n");
+            }
+        } else {
+            printf("Calculando e plotando o espectro de '%s' de %.3f a %.3f Hz (%ld bins)...\n",
+                   argv[2], f_start, f_end, num_bins);
+            for (uint16_t c = 0; c < info->num_channels; c++) {
+                size_t peak_bin = 0;
+                double peak = -1.0;
+                for (long k = 0; k < num_bins; k++) {
+                    const Complex* bin = &spectrum[c * num_bins + k];
+                    double mag = bin->real * bin->real + bin->imag * bin->imag;
+                    if (mag > peak) {
+                        peak = mag;
+                        peak_bin = (size_t)k;
+                    }
+                }
+                double freq = f_start + (double)peak_bin * step;
+                double amplitude = band_tone_amplitude(spectrum[c * num_bins + peak_bin], freq, info->sample_rate, info->num_samples);
+                printf("  canal %u: pico em %.3f Hz, %.2f dBFS\n", c + 1, freq, amplitude > 0.0 ? 20.0 * log10(amplitude) : -INFINITY);
+            }
+            if (plot_band_spectrum_to_file("spectrum_data.dat", spectrum, (size_t)num_bins, f_start, step, info->num_channels) == 0) {
+                invoke_gnuplot("spectrum_data.dat", "Espectro da Faixa", "Frequência (Hz)", "Magnitude", 1, 0, info->num_channels, plot_output);
+            }
+        }
+
+        free(spectrum);
+        wav_map_close(map);
 
     } else if (strcmp(command, "plot-spectrum") == 0) {
         if (argc != 3) { print_usage(argv[0]); return 1; }
@@ -86,33 +484,159 @@ int main(int argc, char* argv[]) {
         printf("Calculando e plotando espectro de '%s'...\n", argv[2]);
         size_t fft_size;
         Complex* spectrum = get_spectrum(wav, &fft_size);
-        plot_spectrum_to_file("spectrum_data.dat", spectrum, fft_size, wav->sample_rate);
+        if (!spectrum) {
+            free_wav_data(wav);
+            return 1;
+        }
+        plot_spectrum_to_file("spectrum_data.dat", spectrum, fft_size, wav->sample_rate, wav->num_channels);
         // ATUALIZADO: Adicionado '0' para NÃO dar zoom no espectro
-        invoke_gnuplot("spectrum_data.dat", "Espectro de Frequência", "Frequência (Hz)", "Magnitude", 1, 0);
+        invoke_gnuplot("spectrum_data.dat", "Espectro de Frequência", "Frequência (Hz)", "Magnitude", 1, 0, wav->num_channels, plot_output);
 
         free(spectrum);
         free_wav_data(wav);
 
+    } else if (strcmp(command, "plot-signal") == 0 && range_option) {
+        if (argc != 3) { print_usage(argv[0]); return 1; }
+        char* end = NULL;
+        double start_s = strtod(range_option, &end);
+        double end_s = 0.0;
+        if (end == range_option || *end != ':' || start_s < 0.0) {
+            fprintf(stderr, "Trecho inválido: '%s' (esperado INICIO:FIM, em segundos).\n", range_option);
+            return 1;
+        }
+        if (end[1] != '\0') end_s = atof(end + 1);
+
+        // O índice de picos é construído na primeira vez e reaproveitado depois:
+        // qualquer trecho, de qualquer tamanho, custa só a largura do gráfico.
+        PeakIndex* index = peak_index_open(argv[2]);
+        if (!index) return 1;
+        printf("Plotando o sinal de '%s' de %.3f s a %.3f s...\n", argv[2], start_s,
+               end_s > 0.0 ? end_s : (double)peak_index_info(index)->num_samples / peak_index_info(index)->sample_rate);
+        if (plot_signal_range_to_file("plot_data.dat", index, start_s, end_s) != 0) {
+            peak_index_close(index);
+            return 1;
+        }
+
+        // Pico e RMS do trecho: uma única coluna.
+        const WavData* info = peak_index_info(index);
+        uint64_t first = (uint64_t)llround(start_s * info->sample_rate);
+        uint64_t last = end_s > 0.0 ? (uint64_t)llround(end_s * info->sample_rate) : info->num_samples;
+        PeakColumn* summary = (PeakColumn*)malloc(info->num_channels * sizeof(PeakColumn));
+        if (!summary) {
+            fprintf(stderr, "Memória insuficiente para o resumo do trecho.\n");
+            peak_index_close(index);
+            return 1;
+        }
+        if (last > first && peak_index_query(index, first, last - first, 1, summary) == 1) {
+            for (uint16_t c = 0; c < info->num_channels; c++) {
+                double peak = fmax(fabs(summary[c].min), fabs(summary[c].max));
+                printf("  canal %u: pico %.2f dBFS, RMS %.2f dBFS\n", c + 1, 20.0 * log10(peak), 20.0 * log10(summary[c].rms));
+            }
+        }
+        free(summary);
+
+        char plot_title[256];
+        snprintf(plot_title, sizeof(plot_title), "Sinal de %s", argv[2]);
+        invoke_gnuplot("plot_data.dat", plot_title, "Tempo (s)", "Amplitude", 0, 0, info->num_channels, plot_output);
+        peak_index_close(index);
+
     } else if (strcmp(command, "plot-signal") == 0) {
         if (argc != 3) { print_usage(argv[0]); return 1; }
-        WavData* wav = read_wav_file(argv[2]);
+        WavMap* map = wav_map_open(argv[2]);
+        if (!map) return 1;
+
+        // O gráfico mostra só os primeiros 20 ms: converte apenas esse trecho,
+        // sem ler o resto do arquivo.
+        double zoom_ms = 20.0;
+        size_t zoom_samples = (size_t)(zoom_ms / 1000.0 * wav_map_info(map)->sample_rate) + 1;
+        WavData* wav = wav_map_load(map, 0, zoom_samples);
+        wav_map_close(map);
         if (!wav) return 1;
 
         printf("Plotando o sinal de '%s' no domínio do tempo...\n", argv[2]);
-        plot_signal_to_file("plot_data.dat", wav);
+        plot_signal_to_file("plot_data.dat", wav, zoom_ms);
 
         char plot_title[256];
         snprintf(plot_title, sizeof(plot_title), "Sinal de %s", argv[2]);
         // ATUALIZADO: Adicionado '20.0' para dar zoom de 20ms
-        invoke_gnuplot("plot_data.dat", plot_title, "Tempo (s)", "Amplitude", 0, 20.0);
+        invoke_gnuplot("plot_data.dat", plot_title, "Tempo (s)", "Amplitude", 0, zoom_ms, wav->num_channels, plot_output);
+
+        free_wav_data(wav);
+    }
+    else if (strcmp(command, "compare") == 0) {
+        if (argc != 4) { print_usage(argv[0]); return 1; }
+        WavData* reference = read_wav_file(argv[2]);
+        WavData* test = read_wav_file(argv[3]);
+        if (!reference || !test) return 1;
+
+        if (reference->num_samples != test->num_samples || reference->num_channels != test->num_channels) {
+            printf("Aviso: os arquivos têm tamanhos diferentes; só o trecho em comum é comparado.\n");
+        }
+        SignalComparison result;
+        compare_signals(reference, test, &result);
+        printf("Comparadas %u amostras x %u canais de '%s' com '%s':\n",
+               result.num_samples, result.num_channels, argv[3], argv[2]);
+        printf("  Erro máximo: %.3g (%.1f dBFS)\n", result.max_abs_error, 20.0 * log10(result.max_abs_error));
+        printf("  Erro RMS:    %.3g (%.1f dBFS)\n", result.rms_error, 20.0 * log10(result.rms_error));
+        printf("  SNR:         %.1f dB\n", result.snr_db);
+
+        free_wav_data(reference);
+        free_wav_data(test);
+    }
+    else if (strcmp(command, "generate") == 0) {
+        // Sinal sintético determinístico (signal_gen.h), mono, com a semente 1:
+        // entrada reprodutível para testes, como a do benchmark.
+        if (argc != 5) { print_usage(argv[0]); return 1; }
+        SignalType type;
+        if (signal_parse_type(argv[2], &type) != 0) {
+            fprintf(stderr, "Sinal desconhecido: %s\n", argv[2]);
+            return 1;
+        }
+        uint32_t sample_rate = rate_option ? (uint32_t)atoi(rate_option) : 48000;
+        double seconds = atof(argv[3]);
+        if (sample_rate == 0 || !(seconds > 0.0)) {
+            fprintf(stderr, "Duração ou taxa inválida.\n");
+            return 1;
+        }
 
+        WavData* wav = signal_generate(type, sample_rate, 1, (size_t)llround(seconds * sample_rate), 1);
+        if (!wav) return 1;
+        if (write_wav_file(argv[4], wav) != 0) { free_wav_data(wav); return 1; }
+        printf("Sinal '%s' de %.3f s salvo em '%s'.\n", signal_type_name(type), seconds, argv[4]);
         free_wav_data(wav);
     }
+    else if (strcmp(command, "spectrogram") == 0) {
+        if (argc != 4) { print_usage(argv[0]); return 1; }
+        StftConfig config;
+        stft_default_config(&config);
+        if (frame_option) config.frame_size = (size_t)atol(frame_option);
+        if (hop_option) config.hop_size = (size_t)atol(hop_option);
+        if (window_option && stft_parse_window(window_option, &config.window) != 0) {
+            fprintf(stderr, "Janela desconhecida: %s\n", window_option);
+            return 1;
+        }
+
+        WavData* wav = read_wav_file(argv[2]);
+        if (!wav) return 1;
+
+        printf("Calculando espectrograma de '%s' (quadro %zu, avanço %zu)...\n", argv[2], config.frame_size, config.hop_size);
+        Spectrogram* spectrogram = stft_spectrogram(wav, &config);
+        free_wav_data(wav);
+        if (!spectrogram) return 1;
+
+        plot_spectrogram_to_file(argv[3], spectrogram);
+        printf("Espectrograma (%zu quadros x %zu bins) salvo em '%s'.\n",
+               spectrogram->num_frames, spectrogram->num_bins, argv[3]);
+        invoke_gnuplot_heatmap(argv[3], "Espectrograma", plot_output);
+
+        free_spectrogram(spectrogram);
+    }
     else {
         fprintf(stderr, "Comando desconhecido: %s\n", argv[1]);
         print_usage(argv[0]);
         return 1;
     }
 
+    thread_pool_shutdown();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,309 @@
+#include "mixer.h"
+#include "wav_handler.h"
+#include "pipeline.h"
+#include "resampler.h"
+#include "thread_pool.h"
+#include "trace.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Amostras por canal lidas de cada entrada, e geradas na saída, por iteração.
+// Uma só thread lê todas as entradas à frente, em rodízio (PipelineReaderSet),
+// com PIPELINE_DEPTH blocos por entrada: com 64 entradas estéreo, ~32 MB.
+#define MIX_READ_BLOCK 8192
+#define MIX_BLOCK 8192
+
+// Uma entrada aberta: leitor, conversores de taxa e as amostras já prontas
+// (na taxa de saída) que ainda não entraram na mixagem.
+typedef struct {
+    WavReader* reader;
+    PipelineReaderSet* inputs;  // Compartilhado por todas as entradas
+    size_t index;               // Desta entrada em 'inputs'
+    uint16_t num_channels;
+    double gain;
+    Resampler** resamplers;   // Um por canal; NULL se a taxa já é a da saída
+    const real_t* in_block;   // Bloco atual da entrada: num_channels x MIX_READ_BLOCK
+    real_t* resampled;        // Saída dos conversores (canal c em + c * ready_stride)
+    const real_t* ready;      // Canal c em ready + c * ready_stride (= in_block sem conversão)
+    size_t ready_stride;
+    size_t ready_pos;
+    size_t ready_len;
+    uint64_t lead;            // Silêncio ainda a emitir antes da entrada
+    uint64_t skip;            // Amostras (na taxa de saída) ainda a descartar
+    int finished;             // Leitor e conversores esgotados
+    int failed;               // Um conversor perdeu amostras por falta de memória
+} MixSource;
+
+int mix_parse_input(char* arg, MixInput* input) {
+    // Até dois campos numéricos no fim; o que não for número faz parte do caminho.
+    double fields[2];
+    int num_fields = 0;
+    while (num_fields < 2) {
+        char* colon = strrchr(arg, ':');
+        if (!colon || colon[1] == '\0') break;
+        char* end = NULL;
+        double value = strtod(colon + 1, &end);
+        if (*end != '\0' || !isfinite(value)) break;
+        fields[num_fields++] = value;
+        *colon = '\0';
+    }
+
+    input->path = arg;
+    input->gain = 1.0;
+    input->offset_seconds = 0.0;
+    // Lidos da direita para a esquerda: com dois campos, o último é o atraso.
+    if (num_fields == 2) {
+        input->gain = pow(10.0, fields[1] / 20.0);
+        input->offset_seconds = fields[0];
+    } else if (num_fields == 1) {
+        input->gain = pow(10.0, fields[0] / 20.0);
+    }
+    return arg[0] != '\0' ? 0 : -1;
+}
+
+static void close_source(MixSource* src) {
+    if (src->resamplers) {
+        for (uint16_t c = 0; c < src->num_channels; c++) {
+            resampler_destroy(src->resamplers[c]);
+        }
+        free(src->resamplers);
+    }
+    free(src->resampled);
+    wav_reader_close(src->reader);
+    memset(src, 0, sizeof(MixSource));
+}
+
+static int open_source(MixSource* src, const MixInput* input, uint32_t out_rate) {
+    memset(src, 0, sizeof(MixSource));
+    src->reader = wav_reader_open(input->path);
+    if (!src->reader) return -1;
+
+    const WavData* info = wav_reader_info(src->reader);
+    src->num_channels = info->num_channels;
+    src->gain = input->gain;
+    int64_t offset = (int64_t)llround(input->offset_seconds * out_rate);
+    if (offset > 0) src->lead = (uint64_t)offset;
+    else src->skip = (uint64_t)(-offset);
+
+    src->ready_stride = MIX_READ_BLOCK;
+
+    if (info->sample_rate != out_rate) {
+        src->resamplers = (Resampler**)calloc(src->num_channels, sizeof(Resampler*));
+        if (!src->resamplers) {
+            fprintf(stderr, "Memória insuficiente para a mixagem.\n");
+            close_source(src);
+            return -1;
+        }
+        for (uint16_t c = 0; c < src->num_channels; c++) {
+            src->resamplers[c] = resampler_create(info->sample_rate, out_rate);
+            if (!src->resamplers[c]) {
+                close_source(src);
+                return -1;
+            }
+        }
+        src->ready_stride = resampler_max_output(src->resamplers[0], MIX_READ_BLOCK);
+        src->resampled = (real_t*)malloc((size_t)src->num_channels * src->ready_stride * sizeof(real_t));
+        if (!src->resampled) {
+            fprintf(stderr, "Memória insuficiente para a mixagem.\n");
+            close_source(src);
+            return -1;
+        }
+        TRACE_ALLOC((size_t)src->num_channels * src->ready_stride * sizeof(real_t));
+    }
+    return 0;
+}
+
+// Conversão de taxa de um bloco lido; cada canal pode rodar numa thread.
+typedef struct {
+    MixSource* src;
+    size_t n;                 // 0 = flush
+    size_t produced;          // Igual em todos os canais; só o canal 0 grava
+} ResamplePass;
+
+static void resample_channels(size_t begin, size_t end, void* ctx) {
+    ResamplePass* pass = (ResamplePass*)ctx;
+    MixSource* src = pass->src;
+    for (size_t c = begin; c < end; c++) {
+        real_t* out = src->resampled + c * src->ready_stride;
+        size_t produced;
+        if (pass->n > 0) {
+            produced = resampler_process(src->resamplers[c], src->in_block + c * MIX_READ_BLOCK, pass->n, out);
+        } else {
+            produced = resampler_flush(src->resamplers[c], out);
+        }
+        if (c == 0) pass->produced = produced;
+    }
+}
+
+// Lê (e converte) o próximo bloco da entrada para 'ready'.
+static void refill_source(MixSource* src) {
+    size_t n = pipeline_reader_set_next(src->inputs, src->index, &src->in_block);
+    src->ready_pos = 0;
+    if (src->resamplers) {
+        ResamplePass pass = { src, n, 0 };
+        parallel_for(src->num_channels, 1, resample_channels, &pass);
+        src->ready = src->resampled;
+        src->ready_len = pass.produced;
+        for (uint16_t c = 0; c < src->num_channels; c++) {
+            if (resampler_failed(src->resamplers[c])) src->failed = 1;
+        }
+    } else {
+        src->ready = src->in_block;
+        src->ready_len = n;
+    }
+    if (n == 0) src->finished = 1;
+}
+
+// Soma até 'n' amostras da entrada, com o ganho, aos canais de 'mix' (canal c
+// em mix + c * MIX_BLOCK). Retorna quantas posições do bloco a entrada ocupou
+// (silêncio inicial incluído); menos que 'n' só quando ela termina.
+static size_t accumulate_source(MixSource* src, real_t* mix, uint16_t out_channels, size_t n) {
+    size_t pos = 0;
+    if (src->lead > 0) {
+        pos = (src->lead < n) ? (size_t)src->lead : n;
+        src->lead -= pos;
+    }
+
+    while (pos < n) {
+        if (src->ready_pos == src->ready_len) {
+            if (src->finished) break;
+            refill_source(src);
+            continue;
+        }
+        size_t available = src->ready_len - src->ready_pos;
+        if (src->skip > 0) {
+            size_t dropped = (src->skip < available) ? (size_t)src->skip : available;
+            src->ready_pos += dropped;
+            src->skip -= dropped;
+            continue;
+        }
+
+        size_t count = (available < n - pos) ? available : n - pos;
+        for (uint16_t c = 0; c < out_channels; c++) {
+            const real_t* in = src->ready + (size_t)(c % src->num_channels) * src->ready_stride + src->ready_pos;
+            real_t* out = mix + (size_t)c * MIX_BLOCK + pos;
+            real_t gain = (real_t)src->gain;
+            for (size_t i = 0; i < count; i++) {
+                out[i] += gain * in[i];
+            }
+        }
+        src->ready_pos += count;
+        pos += count;
+    }
+    return pos;
+}
+
+// Uma passada completa: abre as entradas, mixa com o ganho global 'scale' e
+// grava. O pico (depois de 'scale') é medido no mesmo laço, bloco a bloco.
+static int run_mix(const MixInput* inputs, size_t num_inputs, const char* out_path,
+                   uint32_t out_rate, double scale, double* peak_out) {
+    MixSource* sources = (MixSource*)calloc(num_inputs, sizeof(MixSource));
+    WavReader** readers = (WavReader**)calloc(num_inputs, sizeof(WavReader*));
+    if (!sources || !readers) {
+        fprintf(stderr, "Memória insuficiente para a mixagem.\n");
+        free(readers);
+        free(sources);
+        return -1;
+    }
+    uint16_t out_channels = 0;
+    size_t opened = 0;
+    for (; opened < num_inputs; opened++) {
+        if (open_source(&sources[opened], &inputs[opened], out_rate) != 0) break;
+        readers[opened] = sources[opened].reader;
+        if (sources[opened].num_channels > out_channels) out_channels = sources[opened].num_channels;
+    }
+
+    int status = -1;
+    PipelineReaderSet* reader_set = NULL;
+    WavWriter* writer = NULL;
+    PipelineWriter* output = NULL;
+    if (opened == num_inputs) {
+        reader_set = pipeline_reader_set_open(readers, num_inputs, MIX_READ_BLOCK);
+        for (size_t s = 0; reader_set && s < num_inputs; s++) {
+            sources[s].inputs = reader_set;
+            sources[s].index = s;
+        }
+    }
+    if (reader_set) {
+        const WavData* first = wav_reader_info(sources[0].reader);
+        writer = wav_writer_open(out_path, out_rate, out_channels, first->format, first->bits_per_sample);
+        if (writer) output = pipeline_writer_open(writer, out_channels, MIX_BLOCK);
+    }
+
+    // A soma roda nesta thread; a leitura de todas as entradas, na do
+    // PipelineReaderSet, e a conversão e a gravação de cada bloco, na do
+    // PipelineWriter, enquanto o bloco seguinte é somado.
+    if (output) {
+        status = 0;
+        double peak = 0.0;
+        for (;;) {
+            real_t* mix = pipeline_writer_buffer(output);
+            if (!mix) {
+                status = -1;
+                break;
+            }
+            TRACE_BEGIN(sum_span, "mix_sum");
+            memset(mix, 0, (size_t)out_channels * MIX_BLOCK * sizeof(real_t));
+            size_t block_len = 0;
+            for (size_t s = 0; s < num_inputs; s++) {
+                size_t len = accumulate_source(&sources[s], mix, out_channels, MIX_BLOCK);
+                if (len > block_len) block_len = len;
+                if (sources[s].failed) status = -1;
+            }
+            for (uint16_t c = 0; c < out_channels; c++) {
+                real_t* out = mix + (size_t)c * MIX_BLOCK;
+                for (size_t i = 0; i < block_len; i++) {
+                    if (scale != 1.0) out[i] *= scale;
+                    double v = fabs(out[i]);
+                    if (v > peak) peak = v;
+                }
+            }
+            TRACE_END(sum_span, block_len * out_channels * sizeof(real_t));
+            if (block_len == 0 || status != 0) break;
+
+            if (pipeline_writer_submit(output, block_len) != 0) {
+                status = -1;
+                break;
+            }
+        }
+        *peak_out = peak;
+    }
+
+    if (output && pipeline_writer_finish(output) != 0) status = -1;
+    if (writer) wav_writer_close(writer);
+    pipeline_reader_set_close(reader_set);
+    for (size_t s = 0; s < opened; s++) {
+        close_source(&sources[s]);
+    }
+    free(readers);
+    free(sources);
+    return status;
+}
+
+int mix_files(const MixInput* inputs, size_t num_inputs, const char* out_path, const MixOptions* options) {
+    if (num_inputs == 0) {
+        fprintf(stderr, "Nenhuma entrada para mixar.\n");
+        return -1;
+    }
+
+    uint32_t out_rate = options->sample_rate;
+    if (out_rate == 0) {
+        WavReader* reader = wav_reader_open(inputs[0].path);
+        if (!reader) return -1;
+        out_rate = wav_reader_info(reader)->sample_rate;
+        wav_reader_close(reader);
+    }
+
+    double peak = 0.0;
+    if (run_mix(inputs, num_inputs, out_path, out_rate, 1.0, &peak) != 0) return -1;
+    if (options->normalize && peak > 1.0) {
+        // A primeira passada já gravou o arquivo (saturado); a segunda o
+        // substitui, com todas as entradas escaladas pelo mesmo fator.
+        printf("Pico de %.3f na soma: gravando de novo com ganho %.2f dB...\n", peak, -20.0 * log10(peak));
+        double normalized_peak;
+        if (run_mix(inputs, num_inputs, out_path, out_rate, 1.0 / peak, &normalized_peak) != 0) return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,36 @@
+#ifndef PROJETO_AUDIO_MIXER_H
+#define PROJETO_AUDIO_MIXER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Mixagem de N arquivos em blocos, com memória constante qualquer que seja a
+// duração ou o número de entradas. Cada entrada tem ganho e deslocamento
+// próprios e é convertida on-the-fly para a taxa da saída (resampler.h) se
+// necessário. Como em mix_audio, a saída tem o maior número de canais entre as
+// entradas (as com menos canais têm os seus repetidos) e o formato da primeira.
+
+typedef struct {
+    const char* path;
+    double gain;              // Fator linear (1.0 = sem alteração)
+    double offset_seconds;    // Início da entrada na mixagem; negativo descarta o começo dela
+} MixInput;
+
+typedef struct {
+    uint32_t sample_rate;     // Taxa da saída; 0 = a da primeira entrada
+    int normalize;            // 1: se o pico passar de 1.0, refaz a mixagem com ganho 1 / pico
+} MixOptions;
+
+// Interpreta "arquivo.wav[:ganho_db[:atraso_s]]" (ex.: "voz.wav:-6:1.5").
+// Os campos numéricos são removidos de 'arg', que passa a conter só o caminho,
+// apontado por input->path. Retorna -1 se um campo não for um número válido.
+int mix_parse_input(char* arg, MixInput* input);
+
+// O pico é medido durante a soma, enquanto a primeira passada grava a saída.
+// A normalização não cabe nessa passada: só quando o pico passa de 1.0 (e
+// options->normalize) é feita uma segunda passada completa, que lê todas as
+// entradas de novo e regrava a saída com ganho 1 / pico. Retorna 0 em sucesso
+// e -1 em erro.
+int mix_files(const MixInput* inputs, size_t num_inputs, const char* out_path, const MixOptions* options);
+
+#endif //PROJETO_AUDIO_MIXER_H
@@ -0,0 +1,213 @@
+#include "moving_stats.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Soma de x (ou de x^2) de uma janela inteira, em 8 somas parciais: a
+// reancoragem não fica limitada pela latência de uma única cadeia de adições.
+static double window_sum(const real_t* x, size_t n, int squares) {
+    double lanes[8] = { 0.0 };
+    size_t j = 0;
+    for (; j + 8 <= n; j += 8) {
+        for (size_t l = 0; l < 8; l++) {
+            double v = x[j + l];
+            lanes[l] += squares ? v * v : v;
+        }
+    }
+    double sum = ((lanes[0] + lanes[4]) + (lanes[2] + lanes[6])) + ((lanes[1] + lanes[5]) + (lanes[3] + lanes[7]));
+    for (; j < n; j++) {
+        double v = x[j];
+        sum += squares ? v * v : v;
+    }
+    return sum;
+}
+
+// Fila monotônica em anel (capacidade = janela): índices e valores dos
+// candidatos a mínimo/máximo, do mais antigo para o mais novo.
+typedef struct {
+    uint64_t* index;
+    real_t* value;
+    size_t head;
+    size_t len;
+    size_t capacity;
+} MonotonicQueue;
+
+struct MovingStats {
+    unsigned stats;
+    size_t window;
+    real_t* ring;             // Últimas 'window' entradas (média e RMS)
+    size_t pos;               // Posição mais antiga no anel
+    size_t count;             // Amostras na janela (< window só no início)
+    double sum;
+    double sum_squares;
+    MonotonicQueue min_queue;
+    MonotonicQueue max_queue;
+    uint64_t next_index;      // Índice absoluto da próxima entrada
+    double envelope;
+    double attack_coef;
+    double release_coef;
+};
+
+static int queue_init(MonotonicQueue* q, size_t capacity) {
+    q->index = (uint64_t*)malloc(capacity * sizeof(uint64_t));
+    q->value = (real_t*)malloc(capacity * sizeof(real_t));
+    q->head = 0;
+    q->len = 0;
+    q->capacity = capacity;
+    return (q->index && q->value) ? 0 : -1;
+}
+
+static void queue_free(MonotonicQueue* q) {
+    free(q->index);
+    free(q->value);
+}
+
+// Insere 'x' (índice i) e retorna o máximo (is_max) ou o mínimo da janela
+// que termina em i. Quem é superado por x nunca mais será o extremo: sai da fila.
+static inline real_t queue_push(MonotonicQueue* q, uint64_t i, real_t x, size_t window, int is_max) {
+    if (q->len > 0 && q->index[q->head] + window <= i) {
+        q->head = (q->head + 1 == q->capacity) ? 0 : q->head + 1;
+        q->len--;
+    }
+    while (q->len > 0) {
+        size_t back = q->head + q->len - 1;
+        if (back >= q->capacity) back -= q->capacity;
+        int dominated = is_max ? (q->value[back] <= x) : (q->value[back] >= x);
+        if (!dominated) break;
+        q->len--;
+    }
+    size_t slot = q->head + q->len;
+    if (slot >= q->capacity) slot -= q->capacity;
+    q->index[slot] = i;
+    q->value[slot] = x;
+    q->len++;
+    return q->value[q->head];
+}
+
+// Coeficiente do filtro de um polo com constante de tempo 'seconds'.
+static double time_constant_coef(double seconds, uint32_t sample_rate) {
+    if (seconds <= 0.0 || sample_rate == 0) return 0.0;
+    return exp(-1.0 / (seconds * sample_rate));
+}
+
+MovingStats* moving_stats_create(const MovingStatsConfig* config) {
+    if (config->window_size < 1) {
+        fprintf(stderr, "Janela inválida: deve ter ao menos 1 amostra.\n");
+        return NULL;
+    }
+
+    MovingStats* stats = (MovingStats*)calloc(1, sizeof(MovingStats));
+    stats->stats = config->stats;
+    stats->window = config->window_size;
+    int failed = 0;
+    if (stats->stats & (MOVING_MEAN | MOVING_RMS)) {
+        stats->ring = (real_t*)calloc(stats->window, sizeof(real_t));
+        failed |= !stats->ring;
+    }
+    if (stats->stats & MOVING_MIN) failed |= queue_init(&stats->min_queue, stats->window);
+    if (stats->stats & MOVING_MAX) failed |= queue_init(&stats->max_queue, stats->window);
+    stats->attack_coef = time_constant_coef(config->attack_s, config->sample_rate);
+    stats->release_coef = time_constant_coef(config->release_s, config->sample_rate);
+
+    if (failed) {
+        fprintf(stderr, "Memória insuficiente para a janela de %zu amostras.\n", stats->window);
+        moving_stats_destroy(stats);
+        return NULL;
+    }
+    return stats;
+}
+
+// Ao completar uma volta do anel, as somas correntes são recalculadas a partir
+// da própria janela: o erro de 'soma += novo - antigo' nunca se acumula por
+// mais de uma janela, e o custo continua O(1) amortizado por amostra.
+static void reanchor(MovingStats* stats) {
+    stats->sum = window_sum(stats->ring, stats->window, 0);
+    if (stats->stats & MOVING_RMS) stats->sum_squares = window_sum(stats->ring, stats->window, 1);
+}
+
+// Só a média, com a janela cheia, até o fim do anel (n <= window - pos).
+static void mean_run(MovingStats* stats, const real_t* in, size_t n, real_t* out) {
+    real_t* ring = stats->ring + stats->pos;
+    double sum = stats->sum;
+    double window = (double)stats->window;
+    for (size_t i = 0; i < n; i++) {
+        real_t x = in[i];
+        sum += (double)x - ring[i];
+        ring[i] = x;
+        if (out) out[i] = (real_t)(sum / window);
+    }
+    stats->sum = sum;
+}
+
+void moving_stats_process(MovingStats* stats, const real_t* in, size_t n, const MovingStatsOutput* out) {
+    unsigned wanted = stats->stats;
+    size_t window = stats->window;
+
+    size_t i = 0;
+    while (i < n) {
+        if (wanted == MOVING_MEAN && stats->count == window) {
+            size_t run = window - stats->pos;
+            if (run > n - i) run = n - i;
+            mean_run(stats, in + i, run, out->mean ? out->mean + i : NULL);
+            stats->next_index += run;
+            stats->pos += run;
+            if (stats->pos == window) {
+                stats->pos = 0;
+                reanchor(stats);
+            }
+            i += run;
+            continue;
+        }
+
+        // Lida antes de qualquer escrita: 'out' pode apontar para 'in'.
+        real_t x = in[i];
+        uint64_t index = stats->next_index++;
+
+        if (wanted & (MOVING_MEAN | MOVING_RMS)) {
+            if (stats->count == window) {
+                real_t old = stats->ring[stats->pos];
+                stats->sum -= old;
+                if (wanted & MOVING_RMS) stats->sum_squares -= (double)old * old;
+            } else {
+                stats->count++;
+            }
+            stats->ring[stats->pos] = x;
+            stats->sum += x;
+            if (wanted & MOVING_RMS) stats->sum_squares += (double)x * x;
+            if (++stats->pos == window) {
+                stats->pos = 0;
+                reanchor(stats);
+            }
+
+            if (out->mean) out->mean[i] = (real_t)(stats->sum / stats->count);
+            if (out->rms) {
+                double mean_square = stats->sum_squares / stats->count;
+                out->rms[i] = (real_t)sqrt(mean_square > 0.0 ? mean_square : 0.0);
+            }
+        }
+        if (wanted & MOVING_MIN) {
+            real_t lo = queue_push(&stats->min_queue, index, x, window, 0);
+            if (out->min) out->min[i] = lo;
+        }
+        if (wanted & MOVING_MAX) {
+            real_t hi = queue_push(&stats->max_queue, index, x, window, 1);
+            if (out->max) out->max[i] = hi;
+        }
+        if (wanted & MOVING_ENVELOPE) {
+            double level = fabs((double)x);
+            double coef = (level > stats->envelope) ? stats->attack_coef : stats->release_coef;
+            stats->envelope = coef * stats->envelope + (1.0 - coef) * level;
+            if (out->envelope) out->envelope[i] = (real_t)stats->envelope;
+        }
+        i++;
+    }
+}
+
+void moving_stats_destroy(MovingStats* stats) {
+    if (stats) {
+        free(stats->ring);
+        queue_free(&stats->min_queue);
+        queue_free(&stats->max_queue);
+        free(stats);
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef PROJETO_AUDIO_MOVING_STATS_H
+#define PROJETO_AUDIO_MOVING_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "precision.h"
+
+// Estatísticas de janela deslizante, numa única passada e com memória O(janela):
+// média, RMS, mínimo, máximo e um seguidor de envelope. É o motor da média
+// móvel (apply_sma_filter, SmaStream) e da medição de nível.
+//
+// A janela é causal: a saída i resume as amostras (i - janela, i]. No início,
+// antes de a janela encher, usa só as amostras já vistas (a média de i + 1
+// amostras, não a soma dividida pela janela inteira). Não há latência: cada
+// chamada produz exatamente uma saída por entrada.
+//
+// As somas correntes (de x e de x^2) são recalculadas da janela a cada volta
+// do anel: o erro não cresce com a duração, mesmo em gravações de 24 horas.
+// Mínimo e máximo usam filas monotônicas. Tudo com custo amortizado O(1) por
+// amostra.
+
+// Estatísticas mantidas (combináveis com |). Só estas podem ter destino em
+// MovingStatsOutput; as demais não custam nada.
+#define MOVING_MEAN 0x01
+#define MOVING_RMS 0x02
+#define MOVING_MIN 0x04
+#define MOVING_MAX 0x08
+#define MOVING_ENVELOPE 0x10
+
+typedef struct {
+    unsigned stats;           // MOVING_* combinados
+    size_t window_size;       // Em amostras (>= 1)
+    double attack_s;          // Envelope: constantes de tempo de subida e descida,
+    double release_s;         // em segundos (0 = segue |x| instantaneamente)
+    uint32_t sample_rate;     // Necessária só para o envelope
+} MovingStatsConfig;
+
+// Destinos de uma chamada: NULL nos que não interessam. Qualquer um pode ser o
+// próprio buffer de entrada (processamento in-place).
+typedef struct {
+    real_t* mean;
+    real_t* rms;
+    real_t* min;
+    real_t* max;
+    real_t* envelope;         // Pico de |x| com subida/descida exponenciais
+} MovingStatsOutput;
+
+typedef struct MovingStats MovingStats;
+
+// Um canal. NULL em erro.
+MovingStats* moving_stats_create(const MovingStatsConfig* config);
+void moving_stats_process(MovingStats* stats, const real_t* in, size_t n, const MovingStatsOutput* out);
+void moving_stats_destroy(MovingStats* stats);
+
+#endif //PROJETO_AUDIO_MOVING_STATS_H
@@ -0,0 +1,401 @@
+#include "peak_index.h"
+#include "thread_pool.h"
+#include "trace.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Nível mais fino: 2^8 amostras por entrada. Um arquivo de 1 hora em estéreo a
+// 48 kHz tem um índice de ~32 MB (metade no nível mais fino).
+#define PEAK_INDEX_BASE_LOG2 8
+#define PEAK_INDEX_VERSION 1
+#define PEAK_INDEX_MAX_LEVELS 56
+// Amostras por canal convertidas de cada vez na construção (múltiplo da entrada mais fina).
+#define PEAK_BUILD_BLOCK 65536
+
+static const char peak_index_magic[8] = { 'P', 'A', 'P', 'E', 'A', 'K', 'S', '\0' };
+
+// Cabeçalho do arquivo .peaks; em seguida vêm os níveis, do mais fino ao mais
+// grosso, cada um com suas entradas e, em cada entrada, um PeakEntry por canal.
+typedef struct __attribute__((packed)) {
+    char magic[8];
+    uint32_t version;
+    uint32_t base_log2;
+    uint64_t source_size;       // Tamanho e data de modificação do WAV indexado
+    int64_t source_mtime_s;
+    int64_t source_mtime_ns;
+    uint64_t num_samples;
+    uint32_t sample_rate;
+    uint16_t num_channels;
+    uint16_t num_levels;
+} PeakIndexHeader;
+
+// O quadrado médio (e não o RMS) é o que se combina entre entradas.
+typedef struct {
+    float min;
+    float max;
+    float mean_square;
+} PeakEntry;
+
+struct PeakIndex {
+    WavMap* map;
+    void* data;                 // Cabeçalho seguido dos níveis
+    size_t length;
+    int mapped;                 // 'data' veio do mmap do .peaks (senão, de malloc)
+    unsigned num_levels;
+    const PeakEntry* levels[PEAK_INDEX_MAX_LEVELS];
+};
+
+// Entradas do nível 'level': cada uma resume 2^(base + level) amostras.
+static uint64_t entries_at(uint64_t num_samples, unsigned level) {
+    unsigned shift = PEAK_INDEX_BASE_LOG2 + level;
+    return (num_samples + ((uint64_t)1 << shift) - 1) >> shift;
+}
+
+// Níveis até o que tem uma única entrada.
+static unsigned count_levels(uint64_t num_samples) {
+    unsigned levels = 0;
+    while (num_samples > 0 && levels < PEAK_INDEX_MAX_LEVELS) {
+        levels++;
+        if (entries_at(num_samples, levels - 1) == 1) break;
+    }
+    return levels;
+}
+
+// Tamanho total do índice e posição de cada nível.
+static size_t index_layout(uint64_t num_samples, uint16_t num_channels, unsigned num_levels, size_t* offsets) {
+    size_t length = sizeof(PeakIndexHeader);
+    for (unsigned k = 0; k < num_levels; k++) {
+        offsets[k] = length;
+        length += (size_t)entries_at(num_samples, k) * num_channels * sizeof(PeakEntry);
+    }
+    return length;
+}
+
+static void attach_levels(PeakIndex* index) {
+    const PeakIndexHeader* header = (const PeakIndexHeader*)index->data;
+    size_t offsets[PEAK_INDEX_MAX_LEVELS];
+    index->num_levels = header->num_levels;
+    index_layout(header->num_samples, header->num_channels, header->num_levels, offsets);
+    for (unsigned k = 0; k < index->num_levels; k++) {
+        index->levels[k] = (const PeakEntry*)((const uint8_t*)index->data + offsets[k]);
+    }
+}
+
+// O .peaks existente serve se for desta versão e do WAV no estado atual.
+static int index_is_current(const void* data, size_t length, const struct stat* source, const WavData* info) {
+    if (length < sizeof(PeakIndexHeader)) return 0;
+    const PeakIndexHeader* header = (const PeakIndexHeader*)data;
+    if (memcmp(header->magic, peak_index_magic, sizeof(peak_index_magic)) != 0 ||
+        header->version != PEAK_INDEX_VERSION || header->base_log2 != PEAK_INDEX_BASE_LOG2) return 0;
+    if (header->source_size != (uint64_t)source->st_size || header->source_mtime_s != (int64_t)source->st_mtim.tv_sec ||
+        header->source_mtime_ns != (int64_t)source->st_mtim.tv_nsec) return 0;
+    if (header->num_samples != info->num_samples || header->num_channels != info->num_channels ||
+        header->sample_rate != info->sample_rate || header->num_levels != count_levels(info->num_samples)) return 0;
+    size_t offsets[PEAK_INDEX_MAX_LEVELS];
+    return index_layout(header->num_samples, header->num_channels, header->num_levels, offsets) == length;
+}
+
+static void* map_existing_index(const char* index_path, const struct stat* source, const WavData* info, size_t* length) {
+    int fd = open(index_path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+    if (!index_is_current(data, (size_t)st.st_size, source, info)) {
+        munmap(data, (size_t)st.st_size);
+        return NULL;
+    }
+    *length = (size_t)st.st_size;
+    return data;
+}
+
+// --- Construção ---
+
+typedef struct {
+    const WavMap* map;
+    PeakEntry* level0;
+    uint16_t num_channels;
+    int failed;
+} BuildPass;
+
+// Blocos [begin, end) de PEAK_BUILD_BLOCK amostras: cada um vira as entradas
+// do nível mais fino que cobre.
+static void summarize_blocks(size_t begin, size_t end, void* ctx) {
+    BuildPass* pass = (BuildPass*)ctx;
+    const size_t entry_size = (size_t)1 << PEAK_INDEX_BASE_LOG2;
+    for (size_t blk = begin; blk < end; blk++) {
+        WavData* block = wav_map_load(pass->map, blk * PEAK_BUILD_BLOCK, PEAK_BUILD_BLOCK);
+        if (!block) {
+            pass->failed = 1;
+            continue;
+        }
+        size_t first_entry = blk * (PEAK_BUILD_BLOCK / entry_size);
+        for (uint16_t c = 0; c < pass->num_channels; c++) {
+            const real_t* channel = wav_channel(block, c);
+            for (size_t start = 0; start < block->num_samples; start += entry_size) {
+                size_t stop = (start + entry_size < block->num_samples) ? start + entry_size : block->num_samples;
+                double lo = channel[start], hi = channel[start], sum_squares = 0.0;
+                for (size_t i = start; i < stop; i++) {
+                    double v = channel[i];
+                    if (v < lo) lo = v;
+                    if (v > hi) hi = v;
+                    sum_squares += v * v;
+                }
+                PeakEntry* entry = &pass->level0[(first_entry + start / entry_size) * pass->num_channels + c];
+                entry->min = (float)lo;
+                entry->max = (float)hi;
+                entry->mean_square = (float)(sum_squares / (double)(stop - start));
+            }
+        }
+        free_wav_data(block);
+    }
+}
+
+// Amostras cobertas pela entrada 'e' de um nível de 'entry_size' amostras por entrada.
+static uint64_t entry_samples(uint64_t num_samples, uint64_t entry_size, uint64_t e) {
+    uint64_t start = e * entry_size;
+    return (num_samples - start < entry_size) ? num_samples - start : entry_size;
+}
+
+static void* build_index(const WavMap* map, const struct stat* source, size_t* length) {
+    const WavData* info = wav_map_info(map);
+    uint64_t num_samples = info->num_samples;
+    uint16_t num_channels = info->num_channels;
+    unsigned num_levels = count_levels(num_samples);
+    size_t offsets[PEAK_INDEX_MAX_LEVELS];
+    *length = index_layout(num_samples, num_channels, num_levels, offsets);
+
+    uint8_t* data = (uint8_t*)calloc(1, *length);
+    if (!data) {
+        fprintf(stderr, "Memória insuficiente para o índice de picos.\n");
+        return NULL;
+    }
+    TRACE_ALLOC(*length);
+    PeakIndexHeader* header = (PeakIndexHeader*)data;
+    memcpy(header->magic, peak_index_magic, sizeof(peak_index_magic));
+    header->version = PEAK_INDEX_VERSION;
+    header->base_log2 = PEAK_INDEX_BASE_LOG2;
+    header->source_size = (uint64_t)source->st_size;
+    header->source_mtime_s = (int64_t)source->st_mtim.tv_sec;
+    header->source_mtime_ns = (int64_t)source->st_mtim.tv_nsec;
+    header->num_samples = num_samples;
+    header->sample_rate = info->sample_rate;
+    header->num_channels = num_channels;
+    header->num_levels = (uint16_t)num_levels;
+    if (num_levels == 0) return data;
+
+    wav_map_advise_sequential(map);
+    BuildPass pass = { map, (PeakEntry*)(data + offsets[0]), num_channels, 0 };
+    size_t num_blocks = (size_t)((num_samples + PEAK_BUILD_BLOCK - 1) / PEAK_BUILD_BLOCK);
+    parallel_for(num_blocks, 1, summarize_blocks, &pass);
+    if (pass.failed) {
+        free(data);
+        return NULL;
+    }
+
+    // Cada nível junta pares de entradas do anterior.
+    for (unsigned k = 1; k < num_levels; k++) {
+        const PeakEntry* child = (const PeakEntry*)(data + offsets[k - 1]);
+        PeakEntry* parent = (PeakEntry*)(data + offsets[k]);
+        uint64_t child_size = (uint64_t)1 << (PEAK_INDEX_BASE_LOG2 + k - 1);
+        uint64_t child_entries = entries_at(num_samples, k - 1);
+        for (uint64_t e = 0; e < entries_at(num_samples, k); e++) {
+            for (uint16_t c = 0; c < num_channels; c++) {
+                const PeakEntry* left = &child[2 * e * num_channels + c];
+                PeakEntry* out = &parent[e * num_channels + c];
+                *out = *left;
+                if (2 * e + 1 < child_entries) {
+                    const PeakEntry* right = &child[(2 * e + 1) * num_channels + c];
+                    double left_weight = (double)entry_samples(num_samples, child_size, 2 * e);
+                    double right_weight = (double)entry_samples(num_samples, child_size, 2 * e + 1);
+                    if (right->min < out->min) out->min = right->min;
+                    if (right->max > out->max) out->max = right->max;
+                    out->mean_square = (float)((left->mean_square * left_weight + right->mean_square * right_weight) /
+                                               (left_weight + right_weight));
+                }
+            }
+        }
+    }
+    return data;
+}
+
+// Grava num temporário e renomeia: quem abre o índice ao mesmo tempo nunca vê
+// um arquivo pela metade.
+static int save_index(const char* index_path, const void* data, size_t length) {
+    size_t path_len = strlen(index_path);
+    char* tmp_path = (char*)malloc(path_len + 5);
+    if (!tmp_path) return -1;
+    memcpy(tmp_path, index_path, path_len);
+    memcpy(tmp_path + path_len, ".tmp", 5);
+
+    int status = -1;
+    FILE* fp = fopen(tmp_path, "wb");
+    if (fp) {
+        size_t written = fwrite(data, 1, length, fp);
+        if (fclose(fp) == 0 && written == length && rename(tmp_path, index_path) == 0) status = 0;
+        if (status != 0) unlink(tmp_path);
+    }
+    free(tmp_path);
+    return status;
+}
+
+// --- Abertura e consulta ---
+
+PeakIndex* peak_index_open(const char* wav_path) {
+    struct stat source;
+    if (stat(wav_path, &source) != 0) {
+        perror("Erro ao abrir arquivo de entrada");
+        return NULL;
+    }
+    WavMap* map = wav_map_open(wav_path);
+    if (!map) return NULL;
+
+    PeakIndex* index = (PeakIndex*)calloc(1, sizeof(PeakIndex));
+    if (!index) {
+        fprintf(stderr, "Memória insuficiente para o índice de picos.\n");
+        wav_map_close(map);
+        return NULL;
+    }
+    index->map = map;
+    size_t path_len = strlen(wav_path);
+    char* index_path = (char*)malloc(path_len + 7);
+    if (!index_path) {
+        fprintf(stderr, "Memória insuficiente para o índice de picos.\n");
+        peak_index_close(index);
+        return NULL;
+    }
+    memcpy(index_path, wav_path, path_len);
+    memcpy(index_path + path_len, ".peaks", 7);
+
+    index->data = map_existing_index(index_path, &source, wav_map_info(map), &index->length);
+    index->mapped = (index->data != NULL);
+    if (!index->data) {
+        TRACE_BEGIN(span, "peak_index");
+        printf("Construindo o índice de picos '%s'...\n", index_path);
+        index->data = build_index(map, &source, &index->length);
+        TRACE_END(span, (size_t)wav_map_info(map)->num_samples * wav_map_info(map)->num_channels * sizeof(real_t));
+        if (index->data && save_index(index_path, index->data, index->length) != 0) {
+            fprintf(stderr, "Aviso: não foi possível gravar '%s'; o índice fica só em memória.\n", index_path);
+        }
+    }
+    free(index_path);
+    if (!index->data) {
+        peak_index_close(index);
+        return NULL;
+    }
+    attach_levels(index);
+    return index;
+}
+
+const WavData* peak_index_info(const PeakIndex* index) {
+    return wav_map_info(index->map);
+}
+
+// Colunas com menos amostras que o nível mais fino: lidas do WAV.
+static size_t query_samples(const PeakIndex* index, uint64_t first, uint64_t count, size_t num_columns, PeakColumn* out) {
+    WavData* samples = wav_map_load(index->map, (size_t)first, (size_t)count);
+    if (!samples) return 0;
+    uint16_t num_channels = samples->num_channels;
+    for (size_t b = 0; b < num_columns; b++) {
+        size_t begin = (size_t)(b * count / num_columns);
+        size_t end = (size_t)((b + 1) * count / num_columns);
+        for (uint16_t c = 0; c < num_channels; c++) {
+            const real_t* channel = wav_channel(samples, c);
+            double lo = channel[begin], hi = channel[begin], sum_squares = 0.0;
+            for (size_t i = begin; i < end; i++) {
+                double v = channel[i];
+                if (v < lo) lo = v;
+                if (v > hi) hi = v;
+                sum_squares += v * v;
+            }
+            PeakColumn* column = &out[b * num_channels + c];
+            column->min = (float)lo;
+            column->max = (float)hi;
+            column->rms = (float)sqrt(sum_squares / (double)(end - begin));
+        }
+    }
+    free_wav_data(samples);
+    return num_columns;
+}
+
+// Mínimo, máximo e soma de quadrados de um trecho, acumulados entrada a entrada.
+typedef struct {
+    double min;
+    double max;
+    double sum_squares;
+    double samples;
+} PeakAccum;
+
+static void accumulate_entry(const PeakIndex* index, unsigned level, uint64_t e, uint16_t c, PeakAccum* acc) {
+    uint16_t num_channels = wav_map_info(index->map)->num_channels;
+    const PeakEntry* entry = &index->levels[level][e * num_channels + c];
+    double samples = (double)entry_samples(wav_map_info(index->map)->num_samples,
+                                           (uint64_t)1 << (PEAK_INDEX_BASE_LOG2 + level), e);
+    if (entry->min < acc->min) acc->min = entry->min;
+    if (entry->max > acc->max) acc->max = entry->max;
+    acc->sum_squares += entry->mean_square * samples;
+    acc->samples += samples;
+}
+
+// Decompõe [begin, end) como numa árvore de segmentos: sobe um nível a cada
+// passo, pegando só as entradas das pontas que não formam par. São no máximo
+// duas entradas por nível, O(log) por coluna qualquer que seja a largura dela.
+static void accumulate_range(const PeakIndex* index, uint64_t begin, uint64_t end, uint16_t c, PeakAccum* acc) {
+    uint64_t lo = begin >> PEAK_INDEX_BASE_LOG2;
+    uint64_t hi = (end + ((uint64_t)1 << PEAK_INDEX_BASE_LOG2) - 1) >> PEAK_INDEX_BASE_LOG2;
+    for (unsigned level = 0; lo < hi && level < index->num_levels; level++) {
+        if (lo & 1) accumulate_entry(index, level, lo++, c, acc);
+        if (hi & 1) accumulate_entry(index, level, --hi, c, acc);
+        lo >>= 1;
+        hi >>= 1;
+    }
+}
+
+size_t peak_index_query(const PeakIndex* index, uint64_t first, uint64_t count, size_t num_columns, PeakColumn* out) {
+    const WavData* info = wav_map_info(index->map);
+    uint64_t num_samples = info->num_samples;
+    uint16_t num_channels = info->num_channels;
+    if (first > num_samples) first = num_samples;
+    if (count > num_samples - first) count = num_samples - first;
+    if (num_columns > count) num_columns = (size_t)count;
+    if (num_columns == 0) return 0;
+
+    if (count / num_columns < ((uint64_t)1 << PEAK_INDEX_BASE_LOG2)) {
+        return query_samples(index, first, count, num_columns, out);
+    }
+    for (size_t b = 0; b < num_columns; b++) {
+        uint64_t begin = first + b * count / num_columns;
+        uint64_t end = first + (b + 1) * count / num_columns;
+        for (uint16_t c = 0; c < num_channels; c++) {
+            PeakAccum acc = { INFINITY, -INFINITY, 0.0, 0.0 };
+            accumulate_range(index, begin, end, c, &acc);
+            PeakColumn* column = &out[b * num_channels + c];
+            column->min = (float)acc.min;
+            column->max = (float)acc.max;
+            column->rms = (float)sqrt(acc.sum_squares / acc.samples);
+        }
+    }
+    return num_columns;
+}
+
+void peak_index_close(PeakIndex* index) {
+    if (index) {
+        if (index->mapped) {
+            munmap(index->data, index->length);
+        } else {
+            free(index->data);
+        }
+        wav_map_close(index->map);
+        free(index);
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef PROJETO_AUDIO_PEAK_INDEX_H
+#define PROJETO_AUDIO_PEAK_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "wav_handler.h"
+
+// Índice de picos de um WAV, para desenhar qualquer trecho em qualquer zoom sem
+// ler as amostras: uma pirâmide de resumos (mínimo, máximo e RMS por canal) em
+// níveis de 2^8, 2^9, 2^10, ... amostras por entrada, até uma entrada só.
+//
+// O índice é construído numa única passada pelo arquivo (em paralelo, sobre o
+// mapeamento de wav_map_open) e guardado ao lado dele, em "<arquivo>.peaks".
+// Ele guarda o tamanho e a data de modificação do WAV: se algum dos dois mudar,
+// é reconstruído na próxima abertura. Sem permissão de escrita no diretório, o
+// índice é construído só em memória.
+
+// Resumo de uma coluna do gráfico, para um canal.
+typedef struct {
+    float min;
+    float max;
+    float rms;
+} PeakColumn;
+
+typedef struct PeakIndex PeakIndex;
+
+// Abre o WAV e o seu índice, construindo-o se ausente ou desatualizado. NULL em erro.
+PeakIndex* peak_index_open(const char* wav_path);
+// Metadados do WAV ('samples' é sempre NULL).
+const WavData* peak_index_info(const PeakIndex* index);
+
+// Resume as amostras [first, first + count) em 'num_columns' colunas iguais:
+// out[col * num_channels + c]. Cada coluna combina no máximo duas entradas por
+// nível, então o custo depende só de 'num_columns' (e do log da duração); as
+// bordas das colunas são arredondadas para fora, até a entrada mais fina (2^8
+// amostras). Trechos em que uma coluna tem menos amostras que isso são lidos
+// do próprio WAV, com exatidão.
+// O intervalo é limitado ao fim do arquivo, e nunca há mais colunas que
+// amostras. Retorna o número de colunas escritas.
+size_t peak_index_query(const PeakIndex* index, uint64_t first, uint64_t count, size_t num_columns, PeakColumn* out);
+
+void peak_index_close(PeakIndex* index);
+
+#endif //PROJETO_AUDIO_PEAK_INDEX_H
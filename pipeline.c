@@ -0,0 +1,447 @@
+#include "pipeline.h"
+#include "trace.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Verificações do anel antes de dormir: os blocos levam milissegundos, então
+// esperar mais que isso girando só gastaria um núcleo.
+#define RING_SPIN 64
+
+struct SpscRing {
+    void** items;
+    size_t mask;              // Capacidade - 1
+    size_t head;              // Próxima posição a retirar (só o consumidor escreve)
+    size_t tail;              // Próxima posição a preencher (só o produtor escreve)
+    int closed;
+    int sleepers;             // Threads esperando em 'changed'
+    pthread_mutex_t lock;     // Só para dormir e acordar
+    pthread_cond_t changed;
+};
+
+SpscRing* spsc_ring_create(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+
+    SpscRing* ring = (SpscRing*)calloc(1, sizeof(SpscRing));
+    if (!ring) return NULL;
+    ring->items = (void**)malloc(size * sizeof(void*));
+    if (!ring->items) {
+        free(ring);
+        return NULL;
+    }
+    ring->mask = size - 1;
+    pthread_mutex_init(&ring->lock, NULL);
+    pthread_cond_init(&ring->changed, NULL);
+    return ring;
+}
+
+static int ring_closed(const SpscRing* ring) {
+    return __atomic_load_n(&ring->closed, __ATOMIC_SEQ_CST);
+}
+
+static int ring_has_items(const SpscRing* ring) {
+    return __atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST) != __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST);
+}
+
+static int ring_has_space(const SpscRing* ring) {
+    return __atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST) - __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) <= ring->mask;
+}
+
+// Espera até 'ready' valer ou o anel ser fechado. Quem dorme se anuncia em
+// 'sleepers' antes de testar de novo; quem publica testa 'sleepers' depois de
+// publicar (tudo seq_cst), então um dos dois sempre vê o outro.
+static void ring_wait(SpscRing* ring, int (*ready)(const SpscRing*)) {
+    for (int i = 0; i < RING_SPIN; i++) {
+        if (ready(ring) || ring_closed(ring)) return;
+    }
+    pthread_mutex_lock(&ring->lock);
+    __atomic_add_fetch(&ring->sleepers, 1, __ATOMIC_SEQ_CST);
+    while (!ready(ring) && !ring_closed(ring)) {
+        pthread_cond_wait(&ring->changed, &ring->lock);
+    }
+    __atomic_sub_fetch(&ring->sleepers, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+static void ring_wake(SpscRing* ring) {
+    if (__atomic_load_n(&ring->sleepers, __ATOMIC_SEQ_CST) == 0) return;
+    pthread_mutex_lock(&ring->lock);
+    pthread_cond_broadcast(&ring->changed);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+int spsc_ring_push(SpscRing* ring, void* item) {
+    while (!ring_has_space(ring)) {
+        if (ring_closed(ring)) return -1;
+        ring_wait(ring, ring_has_space);
+    }
+    if (ring_closed(ring)) return -1;
+
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    ring->items[tail & ring->mask] = item;
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_SEQ_CST);
+    ring_wake(ring);
+    return 0;
+}
+
+void* spsc_ring_pop(SpscRing* ring) {
+    while (!ring_has_items(ring)) {
+        if (ring_closed(ring)) return NULL;
+        ring_wait(ring, ring_has_items);
+    }
+
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    void* item = ring->items[head & ring->mask];
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_SEQ_CST);
+    ring_wake(ring);
+    return item;
+}
+
+void spsc_ring_close(SpscRing* ring) {
+    __atomic_store_n(&ring->closed, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&ring->lock);
+    pthread_cond_broadcast(&ring->changed);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+void spsc_ring_destroy(SpscRing* ring) {
+    if (!ring) return;
+    pthread_mutex_destroy(&ring->lock);
+    pthread_cond_destroy(&ring->changed);
+    free(ring->items);
+    free(ring);
+}
+
+// --- Blocos e estágios ---
+
+typedef struct {
+    real_t* samples;
+    size_t n;
+} PipelineBlock;
+
+// Os blocos vão e voltam entre dois anéis: 'ready' leva os cheios adiante e
+// 'free' traz de volta os já consumidos.
+typedef struct {
+    PipelineBlock blocks[PIPELINE_DEPTH];
+    SpscRing* free;
+    SpscRing* ready;
+    PipelineBlock* current;   // Bloco em uso pela thread que processa
+    pthread_t thread;
+    int threaded;             // 0 se a thread não pôde ser criada: tudo roda na que chama
+} BlockQueue;
+
+static int block_queue_init(BlockQueue* queue, size_t block_values) {
+    queue->free = spsc_ring_create(PIPELINE_DEPTH);
+    queue->ready = spsc_ring_create(PIPELINE_DEPTH);
+    if (!queue->free || !queue->ready) return -1;
+    for (int i = 0; i < PIPELINE_DEPTH; i++) {
+        queue->blocks[i].samples = (real_t*)malloc(block_values * sizeof(real_t));
+        if (!queue->blocks[i].samples) {
+            fprintf(stderr, "Memória insuficiente para os blocos do pipeline.\n");
+            return -1;
+        }
+        spsc_ring_push(queue->free, &queue->blocks[i]);
+    }
+    TRACE_ALLOC(PIPELINE_DEPTH * block_values * sizeof(real_t));
+    return 0;
+}
+
+static void block_queue_start(BlockQueue* queue, void* (*thread_main)(void*), void* arg) {
+    queue->threaded = (pthread_create(&queue->thread, NULL, thread_main, arg) == 0);
+}
+
+// Fecha os anéis (a thread sai assim que vê) e espera por ela.
+static void block_queue_stop(BlockQueue* queue) {
+    if (queue->free) spsc_ring_close(queue->free);
+    if (queue->ready) spsc_ring_close(queue->ready);
+    if (queue->threaded) pthread_join(queue->thread, NULL);
+    queue->threaded = 0;
+}
+
+static void block_queue_free(BlockQueue* queue) {
+    for (int i = 0; i < PIPELINE_DEPTH; i++) {
+        free(queue->blocks[i].samples);
+    }
+    spsc_ring_destroy(queue->free);
+    spsc_ring_destroy(queue->ready);
+}
+
+// --- Leitura antecipada ---
+
+struct PipelineReader {
+    WavReader* reader;
+    size_t block_samples;
+    size_t frame_bytes;       // Só para o trace
+    int finished;
+    BlockQueue queue;
+};
+
+static void* reader_main(void* arg) {
+    PipelineReader* pipe = (PipelineReader*)arg;
+    PipelineBlock* block;
+    while ((block = (PipelineBlock*)spsc_ring_pop(pipe->queue.free)) != NULL) {
+        TRACE_BEGIN(span, "pipeline_read");
+        block->n = wav_reader_read(pipe->reader, block->samples, pipe->block_samples);
+        TRACE_END(span, block->n * pipe->frame_bytes);
+        // O bloco vazio também segue: é ele que marca o fim para o consumidor.
+        if (spsc_ring_push(pipe->queue.ready, block) != 0 || block->n == 0) break;
+    }
+    return NULL;
+}
+
+PipelineReader* pipeline_reader_open(WavReader* reader, size_t block_samples) {
+    PipelineReader* pipe = (PipelineReader*)calloc(1, sizeof(PipelineReader));
+    if (!pipe) return NULL;
+    pipe->reader = reader;
+    pipe->block_samples = block_samples;
+    pipe->frame_bytes = wav_reader_info(reader)->num_channels * sizeof(real_t);
+    if (block_queue_init(&pipe->queue, block_samples * wav_reader_info(reader)->num_channels) != 0) {
+        pipeline_reader_close(pipe);
+        return NULL;
+    }
+    block_queue_start(&pipe->queue, reader_main, pipe);
+    return pipe;
+}
+
+size_t pipeline_reader_next(PipelineReader* pipe, const real_t** block) {
+    if (pipe->finished) return 0;
+
+    PipelineBlock* next;
+    if (pipe->queue.threaded) {
+        if (pipe->queue.current) spsc_ring_push(pipe->queue.free, pipe->queue.current);
+        next = (PipelineBlock*)spsc_ring_pop(pipe->queue.ready);
+    } else {
+        next = &pipe->queue.blocks[0];
+        next->n = wav_reader_read(pipe->reader, next->samples, pipe->block_samples);
+    }
+    pipe->queue.current = next;
+    if (!next || next->n == 0) {
+        pipe->finished = 1;
+        return 0;
+    }
+    *block = next->samples;
+    return next->n;
+}
+
+void pipeline_reader_close(PipelineReader* pipe) {
+    if (!pipe) return;
+    block_queue_stop(&pipe->queue);
+    block_queue_free(&pipe->queue);
+    free(pipe);
+}
+
+// --- Leitura antecipada de várias entradas ---
+
+struct PipelineReaderSet {
+    WavReader* const* readers;
+    BlockQueue* queues;       // Um por entrada; a thread deles não é usada
+    size_t count;
+    size_t block_samples;
+    int* exhausted;           // Só a thread escreve: o bloco vazio já foi entregue
+    int* finished;            // Só quem consome escreve
+    pthread_t thread;
+    int threaded;
+    int closed;
+    int pending;              // Algum bloco voltou livre desde a última volta
+    pthread_mutex_t lock;
+    pthread_cond_t returned;
+};
+
+// Uma volta lê no máximo um bloco de cada entrada com bloco livre; sem nenhum,
+// a thread dorme até quem consome devolver um.
+static void* reader_set_main(void* arg) {
+    PipelineReaderSet* set = (PipelineReaderSet*)arg;
+    for (;;) {
+        int active = 0;
+        int progress = 0;
+        for (size_t i = 0; i < set->count; i++) {
+            if (set->exhausted[i]) continue;
+            active = 1;
+            BlockQueue* queue = &set->queues[i];
+            if (!ring_has_items(queue->free)) continue;
+            PipelineBlock* block = (PipelineBlock*)spsc_ring_pop(queue->free);
+            if (!block) return NULL;
+            TRACE_BEGIN(span, "pipeline_read");
+            block->n = wav_reader_read(set->readers[i], block->samples, set->block_samples);
+            TRACE_END(span, block->n * wav_reader_info(set->readers[i])->num_channels * sizeof(real_t));
+            if (spsc_ring_push(queue->ready, block) != 0) return NULL;
+            if (block->n == 0) set->exhausted[i] = 1;
+            progress = 1;
+        }
+        if (!active) break;
+        if (!progress) {
+            pthread_mutex_lock(&set->lock);
+            while (!set->pending && !set->closed) {
+                pthread_cond_wait(&set->returned, &set->lock);
+            }
+            int closed = set->closed;
+            set->pending = 0;
+            pthread_mutex_unlock(&set->lock);
+            if (closed) break;
+        }
+    }
+    return NULL;
+}
+
+PipelineReaderSet* pipeline_reader_set_open(WavReader* const* readers, size_t count, size_t block_samples) {
+    PipelineReaderSet* set = (PipelineReaderSet*)calloc(1, sizeof(PipelineReaderSet));
+    if (!set) return NULL;
+    set->readers = readers;
+    set->count = count;
+    set->block_samples = block_samples;
+    pthread_mutex_init(&set->lock, NULL);
+    pthread_cond_init(&set->returned, NULL);
+    set->queues = (BlockQueue*)calloc(count, sizeof(BlockQueue));
+    set->exhausted = (int*)calloc(count, sizeof(int));
+    set->finished = (int*)calloc(count, sizeof(int));
+    if (!set->queues || !set->exhausted || !set->finished) {
+        fprintf(stderr, "Memória insuficiente para os blocos do pipeline.\n");
+        pipeline_reader_set_close(set);
+        return NULL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (block_queue_init(&set->queues[i], block_samples * wav_reader_info(readers[i])->num_channels) != 0) {
+            pipeline_reader_set_close(set);
+            return NULL;
+        }
+    }
+    set->threaded = (pthread_create(&set->thread, NULL, reader_set_main, set) == 0);
+    return set;
+}
+
+size_t pipeline_reader_set_next(PipelineReaderSet* set, size_t index, const real_t** block) {
+    if (set->finished[index]) return 0;
+
+    BlockQueue* queue = &set->queues[index];
+    PipelineBlock* next;
+    if (set->threaded) {
+        if (queue->current) {
+            spsc_ring_push(queue->free, queue->current);
+            pthread_mutex_lock(&set->lock);
+            set->pending = 1;
+            pthread_cond_signal(&set->returned);
+            pthread_mutex_unlock(&set->lock);
+        }
+        next = (PipelineBlock*)spsc_ring_pop(queue->ready);
+    } else {
+        next = &queue->blocks[0];
+        next->n = wav_reader_read(set->readers[index], next->samples, set->block_samples);
+    }
+    queue->current = next;
+    if (!next || next->n == 0) {
+        set->finished[index] = 1;
+        return 0;
+    }
+    *block = next->samples;
+    return next->n;
+}
+
+void pipeline_reader_set_close(PipelineReaderSet* set) {
+    if (!set) return;
+    if (set->threaded) {
+        pthread_mutex_lock(&set->lock);
+        set->closed = 1;
+        pthread_cond_signal(&set->returned);
+        pthread_mutex_unlock(&set->lock);
+        // A thread pode estar bloqueada num anel: fechá-los a libera.
+        for (size_t i = 0; i < set->count; i++) {
+            block_queue_stop(&set->queues[i]);
+        }
+        pthread_join(set->thread, NULL);
+    }
+    if (set->queues) {
+        for (size_t i = 0; i < set->count; i++) {
+            block_queue_free(&set->queues[i]);
+        }
+    }
+    free(set->queues);
+    free(set->exhausted);
+    free(set->finished);
+    pthread_mutex_destroy(&set->lock);
+    pthread_cond_destroy(&set->returned);
+    free(set);
+}
+
+// --- Escrita em segundo plano ---
+
+struct PipelineWriter {
+    WavWriter* writer;
+    size_t stride;
+    size_t frame_bytes;       // Só para o trace
+    int failed;               // Atômico: escrita com erro
+    BlockQueue queue;
+};
+
+static void* writer_main(void* arg) {
+    PipelineWriter* pipe = (PipelineWriter*)arg;
+    PipelineBlock* block;
+    while ((block = (PipelineBlock*)spsc_ring_pop(pipe->queue.ready)) != NULL) {
+        if (!__atomic_load_n(&pipe->failed, __ATOMIC_ACQUIRE)) {
+            TRACE_BEGIN(span, "pipeline_write");
+            int written = wav_writer_write(pipe->writer, block->samples, pipe->stride, block->n);
+            TRACE_END(span, block->n * pipe->frame_bytes);
+            if (written != 0) {
+                // Quem produz para de receber blocos livres e vê o erro no próximo submit.
+                __atomic_store_n(&pipe->failed, 1, __ATOMIC_RELEASE);
+                spsc_ring_close(pipe->queue.free);
+            }
+        }
+        spsc_ring_push(pipe->queue.free, block);
+    }
+    return NULL;
+}
+
+PipelineWriter* pipeline_writer_open(WavWriter* writer, uint16_t num_channels, size_t stride) {
+    PipelineWriter* pipe = (PipelineWriter*)calloc(1, sizeof(PipelineWriter));
+    if (!pipe) return NULL;
+    pipe->writer = writer;
+    pipe->stride = stride;
+    pipe->frame_bytes = num_channels * sizeof(real_t);
+    if (block_queue_init(&pipe->queue, stride * num_channels) != 0) {
+        block_queue_free(&pipe->queue);
+        free(pipe);
+        return NULL;
+    }
+    block_queue_start(&pipe->queue, writer_main, pipe);
+    return pipe;
+}
+
+real_t* pipeline_writer_buffer(PipelineWriter* pipe) {
+    if (pipe->queue.current) return pipe->queue.current->samples;
+    if (pipe->queue.threaded) {
+        pipe->queue.current = (PipelineBlock*)spsc_ring_pop(pipe->queue.free);
+    } else {
+        pipe->queue.current = pipe->failed ? NULL : &pipe->queue.blocks[0];
+    }
+    return pipe->queue.current ? pipe->queue.current->samples : NULL;
+}
+
+int pipeline_writer_submit(PipelineWriter* pipe, size_t num_samples) {
+    PipelineBlock* block = pipe->queue.current;
+    pipe->queue.current = NULL;
+    if (!block) return -1;
+
+    block->n = num_samples;
+    if (!pipe->queue.threaded) {
+        if (wav_writer_write(pipe->writer, block->samples, pipe->stride, num_samples) != 0) pipe->failed = 1;
+    } else if (spsc_ring_push(pipe->queue.ready, block) != 0) {
+        return -1;
+    }
+    return __atomic_load_n(&pipe->failed, __ATOMIC_ACQUIRE) ? -1 : 0;
+}
+
+int pipeline_writer_finish(PipelineWriter* pipe) {
+    if (!pipe) return -1;
+    // Fechar 'ready' não descarta nada: a thread grava o que restou e então sai.
+    if (pipe->queue.threaded) {
+        spsc_ring_close(pipe->queue.ready);
+        pthread_join(pipe->queue.thread, NULL);
+        pipe->queue.threaded = 0;
+    }
+    int status = pipe->failed ? -1 : 0;
+    block_queue_stop(&pipe->queue);
+    block_queue_free(&pipe->queue);
+    free(pipe);
+    return status;
+}
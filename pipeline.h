@@ -0,0 +1,78 @@
+#ifndef PROJETO_AUDIO_PIPELINE_H
+#define PROJETO_AUDIO_PIPELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "wav_handler.h"
+
+// Leitura e escrita em segundo plano para o processamento em blocos: uma thread
+// lê os blocos seguintes enquanto o atual é processado, e outra converte e grava
+// os já prontos. Entre elas e a thread que processa (que continua usando o pool
+// de thread_pool.h) circulam blocos pré-alocados por anéis SPSC sem trava, de
+// capacidade fixa: a memória continua constante, e o tempo total se aproxima do
+// maior entre E/S e processamento, em vez da soma dos dois.
+//
+// O pedido de um bloco só dorme (mutex + variável de condição) quando o anel
+// está vazio ou cheio; no caminho comum, é um par de operações atômicas.
+
+// Blocos em trânsito por anel; com um no estágio de cada lado, há sempre um
+// sendo lido, um processado e um gravado.
+#define PIPELINE_DEPTH 4
+
+// --- Anel SPSC (um produtor, um consumidor) de ponteiros ---
+typedef struct SpscRing SpscRing;
+
+// 'capacity' é arredondada para potência de 2. NULL em erro.
+SpscRing* spsc_ring_create(size_t capacity);
+// Bloqueia enquanto o anel estiver cheio. Retorna -1 se ele foi fechado.
+int spsc_ring_push(SpscRing* ring, void* item);
+// Bloqueia enquanto o anel estiver vazio; NULL quando fechado e esvaziado.
+void* spsc_ring_pop(SpscRing* ring);
+// Acorda os dois lados: push passa a falhar e pop devolve o que restou.
+void spsc_ring_close(SpscRing* ring);
+void spsc_ring_destroy(SpscRing* ring);
+
+// --- Leitura antecipada ---
+typedef struct PipelineReader PipelineReader;
+
+// Lê 'reader' em blocos de 'block_samples' amostras por canal. O WavReader
+// continua sendo do chamador, que o fecha depois de pipeline_reader_close.
+PipelineReader* pipeline_reader_open(WavReader* reader, size_t block_samples);
+// Próximo bloco, em layout planar (canal c em *block + c * block_samples),
+// válido até a chamada seguinte. Retorna o número de amostras por canal; 0 no fim.
+size_t pipeline_reader_next(PipelineReader* pipe, const real_t** block);
+void pipeline_reader_close(PipelineReader* pipe);
+
+// --- Leitura antecipada de várias entradas ---
+// Para quem consome muitos arquivos ao mesmo tempo (mixer.c): uma única thread
+// lê todas as entradas em rodízio, um bloco de cada por volta, em vez de uma
+// thread por entrada. Cada entrada continua com seus PIPELINE_DEPTH blocos.
+typedef struct PipelineReaderSet PipelineReaderSet;
+
+// Os 'count' WavReaders continuam sendo do chamador, fechados depois de
+// pipeline_reader_set_close. NULL em erro.
+PipelineReaderSet* pipeline_reader_set_open(WavReader* const* readers, size_t count, size_t block_samples);
+// Como pipeline_reader_next, para a entrada 'index'. Cada entrada deve ser
+// consumida por uma só thread.
+size_t pipeline_reader_set_next(PipelineReaderSet* set, size_t index, const real_t** block);
+void pipeline_reader_set_close(PipelineReaderSet* set);
+
+// --- Escrita em segundo plano ---
+typedef struct PipelineWriter PipelineWriter;
+
+// Grava em 'writer' blocos planares de 'num_channels' canais, com até 'stride'
+// amostras cada. O WavWriter continua sendo do chamador, fechado depois de
+// pipeline_writer_finish.
+PipelineWriter* pipeline_writer_open(WavWriter* writer, uint16_t num_channels, size_t stride);
+// Bloco livre para preencher (canal c em buffer + c * stride); NULL se a
+// escrita já falhou. Até o bloco ser entregue a pipeline_writer_submit, novos
+// pedidos devolvem o mesmo.
+real_t* pipeline_writer_buffer(PipelineWriter* pipe);
+// Entrega o último bloco pedido, com 'num_samples' amostras por canal. Retorna -1
+// se alguma escrita anterior falhou.
+int pipeline_writer_submit(PipelineWriter* pipe, size_t num_samples);
+// Espera os blocos pendentes serem gravados e libera o estágio. Retorna 0 se
+// todas as escritas deram certo.
+int pipeline_writer_finish(PipelineWriter* pipe);
+
+#endif //PROJETO_AUDIO_PIPELINE_H
@@ -0,0 +1,19 @@
+#ifndef PROJETO_AUDIO_PRECISION_H
+#define PROJETO_AUDIO_PRECISION_H
+
+// Tipo das amostras em todo o processamento: sinais em memória, buffers dos
+// filtros e a FFT. O padrão é double; compilado com PROJETO_AUDIO_SINGLE_PRECISION
+// (opção de mesmo nome no CMake), passa a ser float: metade da memória e do
+// tráfego, e o dobro de lanes por vetor nos kernels SIMD.
+//
+// Acumuladores sensíveis (somas longas, estados de IIR, potências) continuam
+// em double nos dois modos.
+#ifdef PROJETO_AUDIO_SINGLE_PRECISION
+typedef float real_t;
+#define REAL_T_NAME "float"
+#else
+typedef double real_t;
+#define REAL_T_NAME "double"
+#endif
+
+#endif //PROJETO_AUDIO_PRECISION_H
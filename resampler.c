@@ -0,0 +1,395 @@
+#include "resampler.h"
+#include "fft_simd.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RESAMPLER_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// Metade do número de coeficientes por fase, na taxa menor das duas. Com a
+// janela de Kaiser abaixo, 80 coeficientes dão ~100 dB de rejeição com a
+// transição entre 0.42 e 0.5 da taxa menor.
+#define RESAMPLER_HALF_TAPS 40
+#define RESAMPLER_KAISER_BETA 10.06
+// Corte em fração da frequência de Nyquist da taxa menor: o centro da transição.
+#define RESAMPLER_BANDWIDTH 0.92
+// Acima disso (ex.: 44100 -> 44101, L = 44101) a tabela exata ficaria grande
+// demais: usa RESAMPLER_TABLE_PHASES + 1 fases e interpola entre elas.
+#define RESAMPLER_MAX_EXACT_PHASES 1024
+#define RESAMPLER_TABLE_PHASES 512
+
+#define RESAMPLER_CACHE_SIZE 8
+// Os coeficientes de cada fase são completados com zeros até um múltiplo disto:
+// o produto interno roda sempre em RESAMPLER_LANES somas parciais.
+#define RESAMPLER_LANES 8
+
+// Banco de fases de uma razão L / M. Depende só da razão: é calculado uma vez
+// por processo e compartilhado (somente leitura) por todos os canais e
+// conversores com a mesma razão, como 44.1k <-> 48k, 2x ou 4x.
+typedef struct {
+    uint32_t up;                // L: razão reduzida out_rate / in_rate = L / M
+    uint32_t down;              // M
+    size_t half;                // Metade do suporte do filtro, em amostras de entrada
+    size_t num_taps;            // 2 * half arredondado para RESAMPLER_LANES
+    size_t num_rows;            // Linhas de 'table'
+    int interpolated;           // 1: 'table' tem resolução fixa, não L fases
+    real_t* table;              // num_rows x num_taps
+} PhaseTable;
+
+struct Resampler {
+    const PhaseTable* phases;
+    PhaseTable* owned;          // Tabela própria, quando o cache está cheio
+
+    // Entrada ainda necessária. O índice 0 é precedido por half - 1 zeros, de
+    // modo que a saída k usa history[next_index - history_base ...].
+    real_t* history;
+    size_t history_len;
+    size_t history_capacity;
+    uint64_t history_base;      // Posição (com os zeros iniciais) de history[0]
+    uint64_t next_index;        // Primeira posição usada pela próxima saída
+    uint32_t next_phase;        // Fase (0..L-1) da próxima saída
+    uint64_t consumed;          // Amostras reais de entrada recebidas
+    uint64_t produced;
+    int failed;                 // Faltou memória para o histórico: a saída está incompleta
+};
+
+static uint32_t gcd_u32(uint32_t a, uint32_t b) {
+    while (b != 0) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Função de Bessel modificada de ordem 0, pela série de potências.
+static double bessel_i0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 64; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-17) break;
+    }
+    return sum;
+}
+
+// Preenche uma fase: coeficientes para uma saída 'frac' amostras de entrada
+// após a posição do coeficiente central. Normalizados para ganho DC exato.
+static void fill_phase(real_t* row, size_t num_taps, size_t half, double frac, double cutoff) {
+    double norm = bessel_i0(RESAMPLER_KAISER_BETA);
+    double* taps = (double*)malloc(num_taps * sizeof(double));
+    double sum = 0.0;
+    for (size_t j = 0; j < num_taps; j++) {
+        double x = frac + (double)half - 1.0 - (double)j;
+        double u = x / (double)half;
+        double window = (u > -1.0 && u < 1.0) ? bessel_i0(RESAMPLER_KAISER_BETA * sqrt(1.0 - u * u)) / norm : 0.0;
+        double sinc = (x == 0.0) ? 2.0 * cutoff : sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+        taps[j] = sinc * window;
+        sum += taps[j];
+    }
+    for (size_t j = 0; j < num_taps; j++) {
+        row[j] = (real_t)(taps[j] / sum);
+    }
+    free(taps);
+}
+
+static PhaseTable* build_table(uint32_t up, uint32_t down) {
+    PhaseTable* t = (PhaseTable*)calloc(1, sizeof(PhaseTable));
+    t->up = up;
+    t->down = down;
+
+    // Na redução de taxa o corte desce para a nova Nyquist e o filtro cresce na
+    // mesma proporção, mantendo a transição igual em Hz de saída.
+    double ratio = (up < down) ? (double)up / down : 1.0;
+    double cutoff = 0.5 * RESAMPLER_BANDWIDTH * ratio;
+    // Com a mesma taxa, half = 1 deixa um único coeficiente 1: cópia exata.
+    t->half = (up == down) ? 1 : (size_t)ceil(RESAMPLER_HALF_TAPS / ratio);
+    t->num_taps = (2 * t->half + RESAMPLER_LANES - 1) / RESAMPLER_LANES * RESAMPLER_LANES;
+
+    t->interpolated = (up > RESAMPLER_MAX_EXACT_PHASES);
+    t->num_rows = t->interpolated ? RESAMPLER_TABLE_PHASES + 1 : up;
+    t->table = (real_t*)malloc(t->num_rows * t->num_taps * sizeof(real_t));
+    if (!t->table) {
+        free(t);
+        return NULL;
+    }
+
+    double row_step = t->interpolated ? 1.0 / RESAMPLER_TABLE_PHASES : 1.0 / up;
+    for (size_t p = 0; p < t->num_rows; p++) {
+        fill_phase(t->table + p * t->num_taps, t->num_taps, t->half, (double)p * row_step, cutoff);
+    }
+    return t;
+}
+
+static void free_table(PhaseTable* table) {
+    if (table) {
+        free(table->table);
+        free(table);
+    }
+}
+
+// Tabelas já calculadas, por razão. Nunca liberadas: são poucas e pequenas
+// (44.1k -> 48k: 160 fases x 80 coeficientes).
+static PhaseTable* table_cache[RESAMPLER_CACHE_SIZE];
+static size_t table_cache_len = 0;
+static pthread_mutex_t table_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Tabela compartilhada da razão L / M; se o cache estiver cheio, uma nova em *owned.
+static const PhaseTable* acquire_table(uint32_t up, uint32_t down, PhaseTable** owned) {
+    *owned = NULL;
+    pthread_mutex_lock(&table_cache_lock);
+    for (size_t i = 0; i < table_cache_len; i++) {
+        if (table_cache[i]->up == up && table_cache[i]->down == down) {
+            pthread_mutex_unlock(&table_cache_lock);
+            return table_cache[i];
+        }
+    }
+    PhaseTable* table = build_table(up, down);
+    if (table && table_cache_len < RESAMPLER_CACHE_SIZE) {
+        table_cache[table_cache_len++] = table;
+    } else {
+        *owned = table;
+    }
+    pthread_mutex_unlock(&table_cache_lock);
+    return table;
+}
+
+// --- Produto interno (o laço quente) ---
+// Todas as variantes somam em RESAMPLER_LANES parciais (a parcial l recebe os
+// termos j com j % RESAMPLER_LANES == l) e as reduzem na mesma ordem, sem
+// FMA: o resultado é idêntico bit a bit em qualquer nível de SIMD.
+
+typedef real_t (*DotFn)(const real_t* x, const real_t* h, size_t n);
+
+static real_t reduce_lanes(const real_t* lanes) {
+    return ((lanes[0] + lanes[4]) + (lanes[2] + lanes[6])) + ((lanes[1] + lanes[5]) + (lanes[3] + lanes[7]));
+}
+
+static real_t dot_scalar(const real_t* x, const real_t* h, size_t n) {
+    real_t lanes[RESAMPLER_LANES] = { 0 };
+    for (size_t j = 0; j < n; j += RESAMPLER_LANES) {
+        for (size_t l = 0; l < RESAMPLER_LANES; l++) {
+            lanes[l] += x[j + l] * h[j + l];
+        }
+    }
+    return reduce_lanes(lanes);
+}
+
+#ifdef RESAMPLER_SIMD_X86
+#ifdef PROJETO_AUDIO_SINGLE_PRECISION
+
+// --- float: 2 x 4 (SSE2) ou 1 x 8 (AVX2, também usado com AVX-512) ---
+
+__attribute__((target("sse2")))
+static real_t dot_sse2(const real_t* x, const real_t* h, size_t n) {
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    for (size_t j = 0; j < n; j += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(x + j), _mm_loadu_ps(h + j)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(x + j + 4), _mm_loadu_ps(h + j + 4)));
+    }
+    real_t lanes[RESAMPLER_LANES];
+    _mm_storeu_ps(lanes, acc0);
+    _mm_storeu_ps(lanes + 4, acc1);
+    return reduce_lanes(lanes);
+}
+
+__attribute__((target("avx2")))
+static real_t dot_avx2(const real_t* x, const real_t* h, size_t n) {
+    __m256 acc = _mm256_setzero_ps();
+    for (size_t j = 0; j < n; j += 8) {
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(x + j), _mm256_loadu_ps(h + j)));
+    }
+    real_t lanes[RESAMPLER_LANES];
+    _mm256_storeu_ps(lanes, acc);
+    return reduce_lanes(lanes);
+}
+
+#define dot_avx512 dot_avx2
+
+#else
+
+// --- double: 4 x 2 (SSE2), 2 x 4 (AVX2) ou 1 x 8 (AVX-512) ---
+
+__attribute__((target("sse2")))
+static real_t dot_sse2(const real_t* x, const real_t* h, size_t n) {
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    __m128d acc2 = _mm_setzero_pd(), acc3 = _mm_setzero_pd();
+    for (size_t j = 0; j < n; j += 8) {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(x + j), _mm_loadu_pd(h + j)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(x + j + 2), _mm_loadu_pd(h + j + 2)));
+        acc2 = _mm_add_pd(acc2, _mm_mul_pd(_mm_loadu_pd(x + j + 4), _mm_loadu_pd(h + j + 4)));
+        acc3 = _mm_add_pd(acc3, _mm_mul_pd(_mm_loadu_pd(x + j + 6), _mm_loadu_pd(h + j + 6)));
+    }
+    real_t lanes[RESAMPLER_LANES];
+    _mm_storeu_pd(lanes, acc0);
+    _mm_storeu_pd(lanes + 2, acc1);
+    _mm_storeu_pd(lanes + 4, acc2);
+    _mm_storeu_pd(lanes + 6, acc3);
+    return reduce_lanes(lanes);
+}
+
+__attribute__((target("avx2")))
+static real_t dot_avx2(const real_t* x, const real_t* h, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    for (size_t j = 0; j < n; j += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(x + j), _mm256_loadu_pd(h + j)));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(x + j + 4), _mm256_loadu_pd(h + j + 4)));
+    }
+    real_t lanes[RESAMPLER_LANES];
+    _mm256_storeu_pd(lanes, acc0);
+    _mm256_storeu_pd(lanes + 4, acc1);
+    return reduce_lanes(lanes);
+}
+
+__attribute__((target("avx512f")))
+static real_t dot_avx512(const real_t* x, const real_t* h, size_t n) {
+    __m512d acc = _mm512_setzero_pd();
+    for (size_t j = 0; j < n; j += 8) {
+        acc = _mm512_add_pd(acc, _mm512_mul_pd(_mm512_loadu_pd(x + j), _mm512_loadu_pd(h + j)));
+    }
+    real_t lanes[RESAMPLER_LANES];
+    _mm512_storeu_pd(lanes, acc);
+    return reduce_lanes(lanes);
+}
+
+#endif
+#endif
+
+static DotFn dot_kernel(void) {
+    static DotFn selected = NULL;
+    if (!selected) {
+        selected = dot_scalar;
+#ifdef RESAMPLER_SIMD_X86
+        switch (simd_level()) {
+            case 3: selected = dot_avx512; break;
+            case 2: selected = dot_avx2; break;
+            case 1: selected = dot_sse2; break;
+        }
+#endif
+    }
+    return selected;
+}
+
+Resampler* resampler_create(uint32_t in_rate, uint32_t out_rate) {
+    if (in_rate == 0 || out_rate == 0) {
+        fprintf(stderr, "Taxas de amostragem inválidas para a conversão.\n");
+        return NULL;
+    }
+
+    Resampler* r = (Resampler*)calloc(1, sizeof(Resampler));
+    uint32_t g = gcd_u32(in_rate, out_rate);
+    r->phases = acquire_table(out_rate / g, in_rate / g, &r->owned);
+    if (r->phases) {
+        r->history_capacity = 4 * r->phases->num_taps;
+        r->history = (real_t*)calloc(r->history_capacity, sizeof(real_t));
+    }
+    if (!r->phases || !r->history) {
+        fprintf(stderr, "Memória insuficiente para o conversor de taxa.\n");
+        resampler_destroy(r);
+        return NULL;
+    }
+    r->history_len = r->phases->half - 1;
+    return r;
+}
+
+size_t resampler_max_output(const Resampler* resampler, size_t n) {
+    const PhaseTable* t = resampler->phases;
+    return (size_t)(((uint64_t)n + t->num_taps) * t->up / t->down) + 2;
+}
+
+size_t resampler_output_length(uint32_t in_rate, uint32_t out_rate, size_t n) {
+    return (size_t)(((uint64_t)n * out_rate + in_rate - 1) / in_rate);
+}
+
+// Descarta a entrada que nenhuma saída futura usa e garante espaço para 'n' novas amostras.
+static int make_room(Resampler* r, size_t n) {
+    size_t drop = (size_t)(r->next_index - r->history_base);
+    if (drop > r->history_len) drop = r->history_len;
+    memmove(r->history, r->history + drop, (r->history_len - drop) * sizeof(real_t));
+    r->history_len -= drop;
+    r->history_base += drop;
+
+    if (r->history_len + n > r->history_capacity) {
+        size_t capacity = r->history_len + n + r->phases->num_taps;
+        real_t* grown = (real_t*)realloc(r->history, capacity * sizeof(real_t));
+        if (!grown) {
+            if (!r->failed) fprintf(stderr, "Memória insuficiente para a conversão de taxa.\n");
+            r->failed = 1;
+            return -1;
+        }
+        r->history = grown;
+        r->history_capacity = capacity;
+    }
+    return 0;
+}
+
+// Gera saídas enquanto houver entrada suficiente, até no máximo 'limit' no total.
+static size_t produce(Resampler* r, real_t* out, uint64_t limit) {
+    const PhaseTable* t = r->phases;
+    DotFn dot = dot_kernel();
+    size_t taps = t->num_taps;
+    uint64_t end = r->history_base + r->history_len;
+    uint32_t step_index = t->down / t->up;
+    uint32_t step_phase = t->down % t->up;
+    size_t count = 0;
+
+    while (r->next_index + taps <= end && r->produced < limit) {
+        const real_t* x = r->history + (r->next_index - r->history_base);
+        if (!t->interpolated) {
+            out[count++] = dot(x, t->table + (size_t)r->next_phase * taps, taps);
+        } else {
+            // O filtro interpolado entre duas fases é a interpolação das duas saídas.
+            double pos = (double)r->next_phase * RESAMPLER_TABLE_PHASES / t->up;
+            size_t row = (size_t)pos;
+            double a = pos - (double)row;
+            const real_t* h0 = t->table + row * taps;
+            out[count++] = (real_t)((1.0 - a) * dot(x, h0, taps) + a * dot(x, h0 + taps, taps));
+        }
+        r->produced++;
+
+        r->next_index += step_index;
+        r->next_phase += step_phase;
+        if (r->next_phase >= t->up) {
+            r->next_phase -= t->up;
+            r->next_index++;
+        }
+    }
+    return count;
+}
+
+size_t resampler_process(Resampler* resampler, const real_t* in, size_t n, real_t* out) {
+    if (make_room(resampler, n) != 0) return 0;
+    memcpy(resampler->history + resampler->history_len, in, n * sizeof(real_t));
+    resampler->history_len += n;
+    resampler->consumed += n;
+    return produce(resampler, out, UINT64_MAX);
+}
+
+size_t resampler_flush(Resampler* resampler, real_t* out) {
+    // Zeros depois do fim: bastam para as saídas até o instante da última entrada.
+    const PhaseTable* t = resampler->phases;
+    size_t pad = t->num_taps;
+    if (make_room(resampler, pad) != 0) return 0;
+    memset(resampler->history + resampler->history_len, 0, pad * sizeof(real_t));
+    resampler->history_len += pad;
+
+    uint64_t total = (resampler->consumed * t->up + t->down - 1) / t->down;
+    return produce(resampler, out, total);
+}
+
+int resampler_failed(const Resampler* resampler) {
+    return resampler->failed;
+}
+
+void resampler_destroy(Resampler* resampler) {
+    if (resampler) {
+        free_table(resampler->owned);
+        free(resampler->history);
+        free(resampler);
+    }
+}
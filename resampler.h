@@ -0,0 +1,34 @@
+#ifndef PROJETO_AUDIO_RESAMPLER_H
+#define PROJETO_AUDIO_RESAMPLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "precision.h"
+
+// Conversão de taxa de amostragem por um banco polifásico de sinc janelado
+// (Kaiser). A razão out_rate / in_rate é reduzida a L / M e cada uma das L
+// fases tem os seus coeficientes tabelados; razões com L muito grande usam uma
+// tabela de resolução fixa, interpolada entre fases vizinhas.
+//
+// Segue o contrato dos filtros em blocos (dsp_operations.h), exceto que o número
+// de amostras produzidas difere do de consumidas: para um sinal de n amostras
+// saem, no total, resampler_output_length(in_rate, out_rate, n), alinhadas com a
+// entrada (a amostra de saída k corresponde ao instante k / out_rate).
+
+typedef struct Resampler Resampler;
+
+// Um canal. NULL se alguma das taxas for 0.
+Resampler* resampler_create(uint32_t in_rate, uint32_t out_rate);
+// Espaço necessário em 'out' para uma chamada com 'n' amostras de entrada (n = 0: flush).
+size_t resampler_max_output(const Resampler* resampler, size_t n);
+size_t resampler_process(Resampler* resampler, const real_t* in, size_t n, real_t* out);
+size_t resampler_flush(Resampler* resampler, real_t* out);
+// 1 se alguma chamada não conseguiu memória para a entrada: as amostras dela
+// foram descartadas e a saída não deve ser usada.
+int resampler_failed(const Resampler* resampler);
+void resampler_destroy(Resampler* resampler);
+
+// ceil(n * out_rate / in_rate): duração preservada, sem perder a última amostra.
+size_t resampler_output_length(uint32_t in_rate, uint32_t out_rate, size_t n);
+
+#endif //PROJETO_AUDIO_RESAMPLER_H
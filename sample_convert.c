@@ -0,0 +1,516 @@
+#include "sample_convert.h"
+#include "fft_simd.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SAMPLE_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// Inteiros lidos do arquivo viram x / 2^(bits-1) (potência de 2: a divisão é
+// exata e igual à multiplicação pelo inverso). Em 24 e 32 bits a escrita usa o
+// mesmo fator, arredonda para o mais próximo e satura em [-2^(bits-1), 2^(bits-1) - 1]:
+// um arquivo lido e regravado sem alterações volta idêntico. Em 16 bits fica o
+// fator do conversor original (o maior código positivo, com truncamento).
+#define INT16_TO_DOUBLE (1.0 / 32768.0)
+#define INT24_TO_DOUBLE (1.0 / 8388608.0)
+#define INT32_TO_DOUBLE (1.0 / 2147483648.0)
+#define INT16_SCALE 32767.0
+#define INT24_SCALE 8388608.0
+#define INT32_SCALE 2147483648.0
+
+int sample_format_from_wav(uint16_t format_tag, uint16_t bits_per_sample, SampleFormat* format) {
+    if (format_tag == WAV_FORMAT_PCM) {
+        switch (bits_per_sample) {
+            case 16: *format = SAMPLE_INT16; return 0;
+            case 24: *format = SAMPLE_INT24; return 0;
+            case 32: *format = SAMPLE_INT32; return 0;
+        }
+    } else if (format_tag == WAV_FORMAT_IEEE_FLOAT && bits_per_sample == 32) {
+        *format = SAMPLE_FLOAT32;
+        return 0;
+    }
+    return -1;
+}
+
+size_t sample_format_bytes(SampleFormat format) {
+    switch (format) {
+        case SAMPLE_INT16: return 2;
+        case SAMPLE_INT24: return 3;
+        default: return 4;
+    }
+}
+
+int sample_format_rounds(SampleFormat format) {
+    return format == SAMPLE_INT24 || format == SAMPLE_INT32;
+}
+
+double sample_format_scale(SampleFormat format) {
+    switch (format) {
+        case SAMPLE_INT16: return INT16_SCALE;
+        case SAMPLE_INT24: return INT24_SCALE;
+        case SAMPLE_INT32: return INT32_SCALE;
+        default: return 0.0;
+    }
+}
+
+// --- Escalar (referência) ---
+// Os dados vêm de um mapeamento do arquivo, sem garantia de alinhamento:
+// valores de 32 bits são lidos e escritos com memcpy.
+
+// 16 bits: escala, satura em [-scale - 1, scale] e trunca. NaN vira o mínimo,
+// como no max/min dos kernels vetoriais.
+static inline int32_t quantize(double d, double scale) {
+    d *= scale;
+    if (!(d >= -scale - 1.0)) d = -scale - 1.0;
+    if (d > scale) d = scale;
+    return (int32_t)d;
+}
+
+// 24 e 32 bits: escala, satura em [-scale, scale - 1] e arredonda para o mais
+// próximo (empate para o par, o modo padrão, como nas conversões vetoriais).
+static inline int32_t quantize_round(double d, double scale) {
+    d *= scale;
+    if (!(d >= -scale)) d = -scale;
+    if (d > scale - 1.0) d = scale - 1.0;
+    return (int32_t)lrint(d);
+}
+
+static void int16_to_double_scalar(const void* src, double* dst, size_t count) {
+    const int16_t* in = (const int16_t*)src;
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = in[i] * INT16_TO_DOUBLE;
+    }
+}
+
+static void int24_to_double_scalar(const void* src, double* dst, size_t count) {
+    const uint8_t* in = (const uint8_t*)src;
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* b = in + 3 * i;
+        // Monta nos 24 bits altos e desloca de volta, estendendo o sinal.
+        int32_t v = (int32_t)((uint32_t)b[0] << 8 | (uint32_t)b[1] << 16 | (uint32_t)b[2] << 24) >> 8;
+        dst[i] = v * INT24_TO_DOUBLE;
+    }
+}
+
+static void int32_to_double_scalar(const void* src, double* dst, size_t count) {
+    const uint8_t* in = (const uint8_t*)src;
+    for (size_t i = 0; i < count; i++) {
+        int32_t v;
+        memcpy(&v, in + 4 * i, sizeof(v));
+        dst[i] = v * INT32_TO_DOUBLE;
+    }
+}
+
+static void float32_to_double_scalar(const void* src, double* dst, size_t count) {
+    const uint8_t* in = (const uint8_t*)src;
+    for (size_t i = 0; i < count; i++) {
+        float v;
+        memcpy(&v, in + 4 * i, sizeof(v));
+        dst[i] = v;
+    }
+}
+
+static void double_to_int16_scalar(const double* src, void* dst, size_t count) {
+    int16_t* out = (int16_t*)dst;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = (int16_t)quantize(src[i], INT16_SCALE);
+    }
+}
+
+static void double_to_int24_scalar(const double* src, void* dst, size_t count) {
+    uint8_t* out = (uint8_t*)dst;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t v = (uint32_t)quantize_round(src[i], INT24_SCALE);
+        out[3 * i] = (uint8_t)v;
+        out[3 * i + 1] = (uint8_t)(v >> 8);
+        out[3 * i + 2] = (uint8_t)(v >> 16);
+    }
+}
+
+static void double_to_int32_scalar(const double* src, void* dst, size_t count) {
+    uint8_t* out = (uint8_t*)dst;
+    for (size_t i = 0; i < count; i++) {
+        int32_t v = quantize_round(src[i], INT32_SCALE);
+        memcpy(out + 4 * i, &v, sizeof(v));
+    }
+}
+
+static void double_to_float32_scalar(const double* src, void* dst, size_t count) {
+    uint8_t* out = (uint8_t*)dst;
+    for (size_t i = 0; i < count; i++) {
+        float v = (float)src[i];
+        memcpy(out + 4 * i, &v, sizeof(v));
+    }
+}
+
+#ifdef SAMPLE_SIMD_X86
+
+// Como nos kernels da FFT, a sobra que não completa um vetor fica com a
+// versão escalar. O 24 bits precisa de embaralhamento de bytes (SSSE3), então
+// o nível SSE2 usa a versão escalar e o AVX-512 reaproveita a do AVX2.
+
+// --- SSE2: 2 doubles ---
+
+__attribute__((target("sse2")))
+static void int16_to_double_sse2(const void* src, double* dst, size_t count) {
+    const int16_t* in = (const int16_t*)src;
+    const __m128d scale = _mm_set1_pd(INT16_TO_DOUBLE);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(in + i));
+        // Estende o sinal: cada int16 vai para a metade alta de um int32.
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+        _mm_storeu_pd(dst + i, _mm_mul_pd(_mm_cvtepi32_pd(lo), scale));
+        _mm_storeu_pd(dst + i + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(lo, 0xEE)), scale));
+        _mm_storeu_pd(dst + i + 4, _mm_mul_pd(_mm_cvtepi32_pd(hi), scale));
+        _mm_storeu_pd(dst + i + 6, _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(hi, 0xEE)), scale));
+    }
+    int16_to_double_scalar(in + i, dst + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static void int32_to_double_sse2(const void* src, double* dst, size_t count) {
+    const uint8_t* in = (const uint8_t*)src;
+    const __m128d scale = _mm_set1_pd(INT32_TO_DOUBLE);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(in + 4 * i));
+        _mm_storeu_pd(dst + i, _mm_mul_pd(_mm_cvtepi32_pd(x), scale));
+        _mm_storeu_pd(dst + i + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(x, 0xEE)), scale));
+    }
+    int32_to_double_scalar(in + 4 * i, dst + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static void float32_to_double_sse2(const void* src, double* dst, size_t count) {
+    const uint8_t* in = (const uint8_t*)src;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps((const float*)(in + 4 * i));
+        _mm_storeu_pd(dst + i, _mm_cvtps_pd(x));
+        _mm_storeu_pd(dst + i + 2, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+    }
+    float32_to_double_scalar(in + 4 * i, dst + i, count - i);
+}
+
+// Escala, satura e trunca 2 doubles para int32 (nas duas posições baixas).
+__attribute__((target("sse2")))
+static inline __m128i quantize_sse2(const double* src, __m128d scale, __m128d lo, __m128d hi) {
+    __m128d v = _mm_mul_pd(_mm_loadu_pd(src), scale);
+    v = _mm_min_pd(_mm_max_pd(v, lo), hi);
+    return _mm_cvttpd_epi32(v);
+}
+
+// Escala, satura e arredonda 2 doubles para int32 (nas duas posições baixas).
+__attribute__((target("sse2")))
+static inline __m128i quantize_round_sse2(const double* src, __m128d scale, __m128d lo, __m128d hi) {
+    __m128d v = _mm_mul_pd(_mm_loadu_pd(src), scale);
+    v = _mm_min_pd(_mm_max_pd(v, lo), hi);
+    return _mm_cvtpd_epi32(v);
+}
+
+__attribute__((target("sse2")))
+static void double_to_int16_sse2(const double* src, void* dst, size_t count) {
+    int16_t* out = (int16_t*)dst;
+    const __m128d scale = _mm_set1_pd(INT16_SCALE);
+    const __m128d lo = _mm_set1_pd(-INT16_SCALE - 1.0);
+    const __m128d hi = _mm_set1_pd(INT16_SCALE);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i a = _mm_unpacklo_epi64(quantize_sse2(src + i, scale, lo, hi), quantize_sse2(src + i + 2, scale, lo, hi));
+        __m128i b = _mm_unpacklo_epi64(quantize_sse2(src + i + 4, scale, lo, hi), quantize_sse2(src + i + 6, scale, lo, hi));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(a, b));
+    }
+    double_to_int16_scalar(src + i, out + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static void double_to_int32_sse2(const double* src, void* dst, size_t count) {
+    uint8_t* out = (uint8_t*)dst;
+    const __m128d scale = _mm_set1_pd(INT32_SCALE);
+    const __m128d lo = _mm_set1_pd(-INT32_SCALE);
+    const __m128d hi = _mm_set1_pd(INT32_SCALE - 1.0);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i a = _mm_unpacklo_epi64(quantize_round_sse2(src + i, scale, lo, hi), quantize_round_sse2(src + i + 2, scale, lo, hi));
+        _mm_storeu_si128((__m128i*)(out + 4 * i), a);
+    }
+    double_to_int32_scalar(src + i, out + 4 * i, count - i);
+}
+
+__attribute__((target("sse2")))
+static void double_to_float32_sse2(const double* src, void* dst, size_t count) {
+    uint8_t* out = (uint8_t*)dst;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 a = _mm_cvtpd_ps(_mm_loadu_pd(src + i));
+        __m128 b = _mm_cvtpd_ps(_mm_loadu_pd(src + i + 2));
+        _mm_storeu_ps((float*)(out + 4 * i), _mm_movelh_ps(a, b));
+    }
+    double_to_float32_scalar(src + i, out + 4 * i, count - i);
+}
+
+// --- AVX2: 4 doubles ---
+
+__attribute__((target("avx2")))
+static void int16_to_double_avx2(const void* src, double* dst, size_t count) {
+    const int16_t* in = (const int16_t*)src;
+    const __m256d scale = _mm256_set1_pd(INT16_TO_DOUBLE);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i x = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(in + i)));
+        _mm256_storeu_pd(dst + i, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(x)), scale));
+        _mm256_storeu_pd(dst + i + 4, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(x, 1)), scale));
+    }
+    int16_to_double_scalar(in + i, dst + i, count - i);
+}
+
+// Cada grupo de 3 bytes vai para os 3 bytes altos de um int32 (o byte baixo
+// zera); o deslocamento aritmético de 8 bits estende o sinal.
+__attribute__((target("avx2")))
+static void int24_to_double_avx2(const void* src, double* dst, size_t count) {
+    const uint8_t* in = (const uint8_t*)src;
+    const __m128i spread = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    const __m256d scale = _mm256_set1_pd(INT24_TO_DOUBLE);
+    size_t i = 0;
+    // Cada carga lê 16 bytes para usar 12: para no penúltimo grupo para não
+    // passar do fim do buffer.
+    for (; i + 6 <= count; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(in + 3 * i));
+        x = _mm_srai_epi32(_mm_shuffle_epi8(x, spread), 8);
+        _mm256_storeu_pd(dst + i, _mm256_mul_pd(_mm256_cvtepi32_pd(x), scale));
+    }
+    int24_to_double_scalar(in + 3 * i, dst + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void int32_to_double_avx2(const void* src, double* dst, size_t count) {
+    const uint8_t* in = (const uint8_t*)src;
+    const __m256d scale = _mm256_set1_pd(INT32_TO_DOUBLE);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(in + 4 * i));
+        _mm256_storeu_pd(dst + i, _mm256_mul_pd(_mm256_cvtepi32_pd(x), scale));
+    }
+    int32_to_double_scalar(in + 4 * i, dst + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void float32_to_double_avx2(const void* src, double* dst, size_t count) {
+    const uint8_t* in = (const uint8_t*)src;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(dst + i, _mm256_cvtps_pd(_mm_loadu_ps((const float*)(in + 4 * i))));
+    }
+    float32_to_double_scalar(in + 4 * i, dst + i, count - i);
+}
+
+// Escala, satura e trunca 4 doubles para int32.
+__attribute__((target("avx2")))
+static inline __m128i quantize_avx2(const double* src, __m256d scale, __m256d lo, __m256d hi) {
+    __m256d v = _mm256_mul_pd(_mm256_loadu_pd(src), scale);
+    v = _mm256_min_pd(_mm256_max_pd(v, lo), hi);
+    return _mm256_cvttpd_epi32(v);
+}
+
+// Escala, satura e arredonda 4 doubles para int32.
+__attribute__((target("avx2")))
+static inline __m128i quantize_round_avx2(const double* src, __m256d scale, __m256d lo, __m256d hi) {
+    __m256d v = _mm256_mul_pd(_mm256_loadu_pd(src), scale);
+    v = _mm256_min_pd(_mm256_max_pd(v, lo), hi);
+    return _mm256_cvtpd_epi32(v);
+}
+
+__attribute__((target("avx2")))
+static void double_to_int16_avx2(const double* src, void* dst, size_t count) {
+    int16_t* out = (int16_t*)dst;
+    const __m256d scale = _mm256_set1_pd(INT16_SCALE);
+    const __m256d lo = _mm256_set1_pd(-INT16_SCALE - 1.0);
+    const __m256d hi = _mm256_set1_pd(INT16_SCALE);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i a = quantize_avx2(src + i, scale, lo, hi);
+        __m128i b = quantize_avx2(src + i + 4, scale, lo, hi);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(a, b));
+    }
+    double_to_int16_scalar(src + i, out + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void double_to_int24_avx2(const double* src, void* dst, size_t count) {
+    uint8_t* out = (uint8_t*)dst;
+    const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    const __m256d scale = _mm256_set1_pd(INT24_SCALE);
+    const __m256d lo = _mm256_set1_pd(-INT24_SCALE);
+    const __m256d hi = _mm256_set1_pd(INT24_SCALE - 1.0);
+    size_t i = 0;
+    // A gravação de 16 bytes invade 4 do grupo seguinte, que ele sobrescreve;
+    // o último grupo fica para a versão escalar.
+    for (; i + 6 <= count; i += 4) {
+        __m128i x = _mm_shuffle_epi8(quantize_round_avx2(src + i, scale, lo, hi), pack);
+        _mm_storeu_si128((__m128i*)(out + 3 * i), x);
+    }
+    double_to_int24_scalar(src + i, out + 3 * i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void double_to_int32_avx2(const double* src, void* dst, size_t count) {
+    uint8_t* out = (uint8_t*)dst;
+    const __m256d scale = _mm256_set1_pd(INT32_SCALE);
+    const __m256d lo = _mm256_set1_pd(-INT32_SCALE);
+    const __m256d hi = _mm256_set1_pd(INT32_SCALE - 1.0);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128((__m128i*)(out + 4 * i), quantize_round_avx2(src + i, scale, lo, hi));
+    }
+    double_to_int32_scalar(src + i, out + 4 * i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void double_to_float32_avx2(const double* src, void* dst, size_t count) {
+    uint8_t* out = (uint8_t*)dst;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps((float*)(out + 4 * i), _mm256_cvtpd_ps(_mm256_loadu_pd(src + i)));
+    }
+    double_to_float32_scalar(src + i, out + 4 * i, count - i);
+}
+
+// --- AVX-512: 8 doubles ---
+
+__attribute__((target("avx512f")))
+static void int16_to_double_avx512(const void* src, double* dst, size_t count) {
+    const int16_t* in = (const int16_t*)src;
+    const __m512d scale = _mm512_set1_pd(INT16_TO_DOUBLE);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i x = _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i*)(in + i)));
+        _mm512_storeu_pd(dst + i, _mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_castsi512_si256(x)), scale));
+        _mm512_storeu_pd(dst + i + 8, _mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(x, 1)), scale));
+    }
+    int16_to_double_scalar(in + i, dst + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void int32_to_double_avx512(const void* src, double* dst, size_t count) {
+    const uint8_t* in = (const uint8_t*)src;
+    const __m512d scale = _mm512_set1_pd(INT32_TO_DOUBLE);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(in + 4 * i));
+        _mm512_storeu_pd(dst + i, _mm512_mul_pd(_mm512_cvtepi32_pd(x), scale));
+    }
+    int32_to_double_scalar(in + 4 * i, dst + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void float32_to_double_avx512(const void* src, double* dst, size_t count) {
+    const uint8_t* in = (const uint8_t*)src;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm512_storeu_pd(dst + i, _mm512_cvtps_pd(_mm256_loadu_ps((const float*)(in + 4 * i))));
+    }
+    float32_to_double_scalar(in + 4 * i, dst + i, count - i);
+}
+
+// Escala, satura e trunca 8 doubles para int32.
+__attribute__((target("avx512f")))
+static inline __m256i quantize_avx512(const double* src, __m512d scale, __m512d lo, __m512d hi) {
+    __m512d v = _mm512_mul_pd(_mm512_loadu_pd(src), scale);
+    v = _mm512_min_pd(_mm512_max_pd(v, lo), hi);
+    return _mm512_cvttpd_epi32(v);
+}
+
+// Escala, satura e arredonda 8 doubles para int32.
+__attribute__((target("avx512f")))
+static inline __m256i quantize_round_avx512(const double* src, __m512d scale, __m512d lo, __m512d hi) {
+    __m512d v = _mm512_mul_pd(_mm512_loadu_pd(src), scale);
+    v = _mm512_min_pd(_mm512_max_pd(v, lo), hi);
+    return _mm512_cvtpd_epi32(v);
+}
+
+__attribute__((target("avx512f")))
+static void double_to_int16_avx512(const double* src, void* dst, size_t count) {
+    int16_t* out = (int16_t*)dst;
+    const __m512d scale = _mm512_set1_pd(INT16_SCALE);
+    const __m512d lo = _mm512_set1_pd(-INT16_SCALE - 1.0);
+    const __m512d hi = _mm512_set1_pd(INT16_SCALE);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i x = _mm512_castsi256_si512(quantize_avx512(src + i, scale, lo, hi));
+        x = _mm512_inserti64x4(x, quantize_avx512(src + i + 8, scale, lo, hi), 1);
+        _mm256_storeu_si256((__m256i*)(out + i), _mm512_cvtsepi32_epi16(x));
+    }
+    double_to_int16_scalar(src + i, out + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void double_to_int32_avx512(const double* src, void* dst, size_t count) {
+    uint8_t* out = (uint8_t*)dst;
+    const __m512d scale = _mm512_set1_pd(INT32_SCALE);
+    const __m512d lo = _mm512_set1_pd(-INT32_SCALE);
+    const __m512d hi = _mm512_set1_pd(INT32_SCALE - 1.0);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_si256((__m256i*)(out + 4 * i), quantize_round_avx512(src + i, scale, lo, hi));
+    }
+    double_to_int32_scalar(src + i, out + 4 * i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void double_to_float32_avx512(const double* src, void* dst, size_t count) {
+    uint8_t* out = (uint8_t*)dst;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps((float*)(out + 4 * i), _mm512_cvtpd_ps(_mm512_loadu_pd(src + i)));
+    }
+    double_to_float32_scalar(src + i, out + 4 * i, count - i);
+}
+
+#endif // SAMPLE_SIMD_X86
+
+// Ordem dos vetores: SAMPLE_INT16, SAMPLE_INT24, SAMPLE_INT32, SAMPLE_FLOAT32.
+static const SampleKernels scalar_kernels = {
+    "scalar",
+    { int16_to_double_scalar, int24_to_double_scalar, int32_to_double_scalar, float32_to_double_scalar },
+    { double_to_int16_scalar, double_to_int24_scalar, double_to_int32_scalar, double_to_float32_scalar }
+};
+#ifdef SAMPLE_SIMD_X86
+static const SampleKernels sse2_kernels = {
+    "sse2",
+    { int16_to_double_sse2, int24_to_double_scalar, int32_to_double_sse2, float32_to_double_sse2 },
+    { double_to_int16_sse2, double_to_int24_scalar, double_to_int32_sse2, double_to_float32_sse2 }
+};
+static const SampleKernels avx2_kernels = {
+    "avx2",
+    { int16_to_double_avx2, int24_to_double_avx2, int32_to_double_avx2, float32_to_double_avx2 },
+    { double_to_int16_avx2, double_to_int24_avx2, double_to_int32_avx2, double_to_float32_avx2 }
+};
+static const SampleKernels avx512_kernels = {
+    "avx512",
+    { int16_to_double_avx512, int24_to_double_avx2, int32_to_double_avx512, float32_to_double_avx512 },
+    { double_to_int16_avx512, double_to_int24_avx2, double_to_int32_avx512, double_to_float32_avx512 }
+};
+#endif
+
+static const SampleKernels* select_kernels(void) {
+#ifdef SAMPLE_SIMD_X86
+    switch (simd_level()) {
+        case 3: return &avx512_kernels;
+        case 2: return &avx2_kernels;
+        case 1: return &sse2_kernels;
+    }
+#endif
+    return &scalar_kernels;
+}
+
+const SampleKernels* sample_convert_kernels(void) {
+    static const SampleKernels* selected = NULL;
+    if (!selected) {
+        selected = select_kernels();
+    }
+    return selected;
+}
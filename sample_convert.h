@@ -0,0 +1,45 @@
+#ifndef PROJETO_AUDIO_SAMPLE_CONVERT_H
+#define PROJETO_AUDIO_SAMPLE_CONVERT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "wav_handler.h"
+
+// Conversão entre as amostras gravadas no arquivo e doubles normalizados em
+// [-1.0, 1.0]. Uso interno de wav_handler.c, que cuida do (des)intercalamento
+// dos canais: aqui cada chamada converte 'count' valores consecutivos.
+
+typedef enum {
+    SAMPLE_INT16,      // PCM 16 bits
+    SAMPLE_INT24,      // PCM 24 bits empacotado (3 bytes, little-endian)
+    SAMPLE_INT32,      // PCM 32 bits
+    SAMPLE_FLOAT32,    // IEEE float 32 bits
+    SAMPLE_FORMAT_COUNT
+} SampleFormat;
+
+// Formato interno correspondente a (WAV_FORMAT_*, bits por amostra). -1 se não suportado.
+int sample_format_from_wav(uint16_t format_tag, uint16_t bits_per_sample, SampleFormat* format);
+size_t sample_format_bytes(SampleFormat format);
+// Fator da escrita: 2^(bits-1) em 24 e 32 bits; 32767 em 16 bits (legado); 0 para float.
+double sample_format_scale(SampleFormat format);
+// 1 se a escrita arredonda para o mais próximo (24 e 32 bits); 0 se trunca.
+int sample_format_rounds(SampleFormat format);
+
+// Inteiros: x / 2^(bits-1). Float: conversão direta.
+typedef void (*SampleToDoubleFn)(const void* src, double* dst, size_t count);
+// Inteiros: x * scale, saturado na faixa do formato e arredondado (24 e 32
+// bits) ou truncado (16 bits). Float: sem saturação, pois o formato comporta
+// valores fora de [-1, 1].
+typedef void (*DoubleToSampleFn)(const double* src, void* dst, size_t count);
+
+typedef struct {
+    const char* name;
+    SampleToDoubleFn to_double[SAMPLE_FORMAT_COUNT];
+    DoubleToSampleFn from_double[SAMPLE_FORMAT_COUNT];
+} SampleKernels;
+
+// Como fft_simd_kernels: o melhor conjunto para a CPU (ou o limitado por
+// PROJETO_AUDIO_SIMD). Todas as variantes dão resultados idênticos bit a bit.
+const SampleKernels* sample_convert_kernels(void);
+
+#endif //PROJETO_AUDIO_SAMPLE_CONVERT_H
@@ -0,0 +1,28 @@
+#ifndef PROJETO_AUDIO_SIGNAL_GEN_H
+#define PROJETO_AUDIO_SIGNAL_GEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "wav_handler.h"
+
+// Sinais sintéticos determinísticos, para benchmarks e testes manuais: a
+// mesma semente gera sempre as mesmas amostras, em qualquer máquina.
+
+typedef enum {
+    SIGNAL_SINE,         // Seno de 997 Hz (não divide as taxas usuais)
+    SIGNAL_CHIRP,        // Varredura logarítmica de 20 Hz até 0.45 * taxa
+    SIGNAL_WHITE_NOISE,  // Uniforme, espectro plano
+    SIGNAL_PINK_NOISE    // -3 dB por oitava (ruído branco filtrado)
+} SignalType;
+
+// "sine", "chirp", "white" ou "pink". Retorna -1 se o nome não for reconhecido.
+int signal_parse_type(const char* name, SignalType* type);
+const char* signal_type_name(SignalType type);
+
+// Novo WavData (PCM 16 bits, liberado com free_wav_data) com 'num_samples'
+// amostras por canal e pico de no máximo 0.5. Nos ruídos, cada canal usa uma
+// sequência própria derivada de 'seed'. NULL em erro.
+WavData* signal_generate(SignalType type, uint32_t sample_rate, uint16_t num_channels,
+                         size_t num_samples, uint64_t seed);
+
+#endif //PROJETO_AUDIO_SIGNAL_GEN_H
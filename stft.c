@@ -0,0 +1,177 @@
+#include "stft.h"
+#include "fft.h"
+#include "thread_pool.h"
+#include "arena.h"
+#include "trace.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Menor lote de quadros entregue a uma thread: cada lote cria um plano de FFT
+// próprio e reaproveita o mesmo buffer para todos os seus quadros.
+#define STFT_MIN_FRAMES_PER_CHUNK 16
+
+// Potência mínima antes do logaritmo (-200 dB), para não gerar -inf.
+#define STFT_POWER_FLOOR 1e-20
+
+void stft_default_config(StftConfig* config) {
+    config->frame_size = 2048;
+    config->hop_size = 512;
+    config->window = WINDOW_HANN;
+}
+
+int stft_parse_window(const char* name, WindowType* window) {
+    if (strcmp(name, "hann") == 0) {
+        *window = WINDOW_HANN;
+    } else if (strcmp(name, "hamming") == 0) {
+        *window = WINDOW_HAMMING;
+    } else if (strcmp(name, "blackman") == 0) {
+        *window = WINDOW_BLACKMAN;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+// Janela periódica (denominador N), a forma usada em análise espectral.
+static void fill_window(double* window, size_t n, WindowType type) {
+    for (size_t i = 0; i < n; i++) {
+        double phase = 2.0 * M_PI * (double)i / (double)n;
+        switch (type) {
+            case WINDOW_HAMMING:
+                window[i] = 0.54 - 0.46 * cos(phase);
+                break;
+            case WINDOW_BLACKMAN:
+                window[i] = 0.42 - 0.5 * cos(phase) + 0.08 * cos(2.0 * phase);
+                break;
+            default:
+                window[i] = 0.5 - 0.5 * cos(phase);
+                break;
+        }
+    }
+}
+
+// Contexto dos lotes de quadros.
+typedef struct {
+    const WavData* wav_data;
+    const double* window;
+    double power_scale;   // Converte |X|^2 somado nos canais em potência média normalizada
+    Spectrogram* spectrogram;
+    int failed;
+} StftPass;
+
+static void stft_frames(size_t begin, size_t end, void* ctx) {
+    StftPass* pass = (StftPass*)ctx;
+    Spectrogram* sg = pass->spectrogram;
+    const WavData* wav = pass->wav_data;
+    size_t frame_size = sg->frame_size;
+    size_t num_bins = sg->num_bins;
+
+    FftPlan* plan = fft_plan_create_real(frame_size);
+    if (!plan) {
+        pass->failed = 1;
+        return;
+    }
+
+    // O buffer do espectro também recebe o quadro janelado (FFT real no lugar).
+    ArenaMark mark = arena_mark();
+    Complex* spectrum = (Complex*)arena_alloc(num_bins * sizeof(Complex));
+    double* power = (double*)arena_alloc(num_bins * sizeof(double));
+    if (!spectrum || !power) {
+        pass->failed = 1;
+        arena_release(mark);
+        fft_plan_destroy(plan);
+        return;
+    }
+    real_t* frame = (real_t*)spectrum;
+
+    for (size_t f = begin; f < end; f++) {
+        size_t start = f * sg->hop_size;
+        size_t available = (start < wav->num_samples) ? wav->num_samples - start : 0;
+        if (available > frame_size) available = frame_size;
+
+        memset(power, 0, num_bins * sizeof(double));
+        for (uint16_t c = 0; c < wav->num_channels; c++) {
+            const real_t* samples = wav_channel(wav, c) + start;
+            for (size_t i = 0; i < available; i++) {
+                frame[i] = samples[i] * pass->window[i];
+            }
+            for (size_t i = available; i < frame_size; i++) {
+                frame[i] = 0.0;
+            }
+            rfft_execute(plan, frame, spectrum);
+            for (size_t k = 0; k < num_bins; k++) {
+                power[k] += spectrum[k].real * spectrum[k].real + spectrum[k].imag * spectrum[k].imag;
+            }
+        }
+
+        float* row = sg->magnitudes_db + f * num_bins;
+        for (size_t k = 0; k < num_bins; k++) {
+            double p = power[k] * pass->power_scale;
+            // Os bins 0 e N/2 não têm par espelhado: metade da energia dos demais.
+            if (k == 0 || 2 * k == frame_size) p *= 0.25;
+            row[k] = (float)(10.0 * log10(p > STFT_POWER_FLOOR ? p : STFT_POWER_FLOOR));
+        }
+    }
+
+    arena_release(mark);
+    fft_plan_destroy(plan);
+}
+
+Spectrogram* stft_spectrogram(const WavData* wav_data, const StftConfig* config) {
+    if (config->frame_size < 2 || config->hop_size == 0) {
+        fprintf(stderr, "Configuração de STFT inválida: quadro >= 2 e avanço >= 1.\n");
+        return NULL;
+    }
+
+    size_t frame_size = config->frame_size;
+    size_t hop_size = config->hop_size;
+    size_t num_frames = 1;
+    if (wav_data->num_samples > frame_size) {
+        num_frames += (wav_data->num_samples - frame_size + hop_size - 1) / hop_size;
+    }
+
+    Spectrogram* sg = (Spectrogram*)calloc(1, sizeof(Spectrogram));
+    sg->num_frames = num_frames;
+    sg->num_bins = frame_size / 2 + 1;
+    sg->frame_size = frame_size;
+    sg->hop_size = hop_size;
+    sg->sample_rate = wav_data->sample_rate;
+    sg->magnitudes_db = (float*)malloc(num_frames * sg->num_bins * sizeof(float));
+    double* window = (double*)malloc(frame_size * sizeof(double));
+    if (!sg->magnitudes_db || !window) {
+        fprintf(stderr, "Memória insuficiente para o espectrograma.\n");
+        free(window);
+        free_spectrogram(sg);
+        return NULL;
+    }
+    fill_window(window, frame_size, config->window);
+
+    // Amplitude de um seno: |X[k]| = A * soma(janela) / 2. Com o fator 2 dos
+    // bins espelhados, (2 |X| / soma)^2 dá A^2, isto é, 0 dB para A = 1.
+    double window_sum = 0.0;
+    for (size_t i = 0; i < frame_size; i++) {
+        window_sum += window[i];
+    }
+    double amplitude_scale = 2.0 / window_sum;
+
+    StftPass pass = { wav_data, window, amplitude_scale * amplitude_scale / wav_data->num_channels, sg, 0 };
+    TRACE_BEGIN(span, "stft");
+    parallel_for(num_frames, STFT_MIN_FRAMES_PER_CHUNK, stft_frames, &pass);
+    TRACE_END(span, (uint64_t)wav_data->num_samples * wav_data->num_channels * sizeof(real_t));
+
+    free(window);
+    if (pass.failed) {
+        free_spectrogram(sg);
+        return NULL;
+    }
+    return sg;
+}
+
+void free_spectrogram(Spectrogram* spectrogram) {
+    if (spectrogram) {
+        free(spectrogram->magnitudes_db);
+        free(spectrogram);
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef PROJETO_AUDIO_STFT_H
+#define PROJETO_AUDIO_STFT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "wav_handler.h"
+
+// Transformada de Fourier de curto prazo (STFT): o sinal é dividido em quadros
+// de 'frame_size' amostras, espaçados de 'hop_size', cada um multiplicado pela
+// janela e transformado com uma FFT real pequena. Os quadros são independentes
+// e processados em paralelo, em lotes, pelas threads do pool.
+
+typedef enum {
+    WINDOW_HANN,
+    WINDOW_HAMMING,
+    WINDOW_BLACKMAN
+} WindowType;
+
+typedef struct {
+    size_t frame_size;   // Amostras por quadro (tamanho da FFT)
+    size_t hop_size;     // Avanço entre quadros consecutivos
+    WindowType window;
+} StftConfig;
+
+// Padrão: quadros de 2048 amostras, avanço de 512, janela de Hann.
+void stft_default_config(StftConfig* config);
+
+// "hann", "hamming" ou "blackman". Retorna -1 se o nome não for reconhecido.
+int stft_parse_window(const char* name, WindowType* window);
+
+// Matriz tempo-frequência: num_frames linhas de num_bins valores, em dB
+// relativos ao fundo de escala (um seno de amplitude 1.0 fica em ~0 dB).
+typedef struct {
+    size_t num_frames;
+    size_t num_bins;     // frame_size / 2 + 1
+    size_t frame_size;
+    size_t hop_size;
+    uint32_t sample_rate;
+    float* magnitudes_db; // magnitudes_db[frame * num_bins + bin]
+} Spectrogram;
+
+// Calcula o espectrograma de todos os canais: cada célula é a potência média
+// entre os canais. O último quadro é completado com zeros. NULL em erro.
+Spectrogram* stft_spectrogram(const WavData* wav_data, const StftConfig* config);
+void free_spectrogram(Spectrogram* spectrogram);
+
+#endif //PROJETO_AUDIO_STFT_H
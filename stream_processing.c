@@ -0,0 +1,422 @@
+#include "stream_processing.h"
+#include "wav_handler.h"
+#include "pipeline.h"
+#include "dsp_operations.h"
+#include "filters.h"
+#include "thread_pool.h"
+#include "resampler.h"
+#include "moving_stats.h"
+#include "convolution.h"
+#include "trace.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Quantidade de amostras (por canal) lidas do disco por iteração.
+#define STREAM_READ_BLOCK 65536
+
+// Envelope da medição de nível: subida rápida, descida lenta (como um medidor de pico).
+#define METER_ATTACK_S 0.010
+#define METER_RELEASE_S 0.300
+// Piso dos valores em dBFS (silêncio digital).
+#define METER_FLOOR_DB -200.0
+
+// Interface comum aos filtros em blocos de dsp_operations: um estado por canal.
+typedef struct {
+    void** states;
+    size_t (*process)(void* state, const real_t* in, size_t n, real_t* out);
+    size_t (*flush)(void* state, real_t* out);
+    size_t block_size;
+    uint32_t sample_rate;     // Taxa da saída; 0 = a da entrada
+    int (*failed)(void* state);   // Erro no meio do sinal; NULL se o estágio não tem
+} StreamStage;
+
+static size_t sma_process(void* state, const real_t* in, size_t n, real_t* out) {
+    return sma_stream_process((SmaStream*)state, in, n, out);
+}
+
+static size_t sma_flush(void* state, real_t* out) {
+    return sma_stream_flush((SmaStream*)state, out);
+}
+
+static size_t fft_process(void* state, const real_t* in, size_t n, real_t* out) {
+    return fft_filter_stream_process((FftFilterStream*)state, in, n, out);
+}
+
+static size_t fft_flush(void* state, real_t* out) {
+    return fft_filter_stream_flush((FftFilterStream*)state, out);
+}
+
+static size_t fir_process(void* state, const real_t* in, size_t n, real_t* out) {
+    return fir_filter_process((FirFilter*)state, in, n, out);
+}
+
+static size_t fir_flush(void* state, real_t* out) {
+    return fir_filter_flush((FirFilter*)state, out);
+}
+
+static size_t iir_process(void* state, const real_t* in, size_t n, real_t* out) {
+    return iir_filter_process((IirFilter*)state, in, n, out);
+}
+
+static size_t iir_flush(void* state, real_t* out) {
+    return iir_filter_flush((IirFilter*)state, out);
+}
+
+static size_t resample_process(void* state, const real_t* in, size_t n, real_t* out) {
+    return resampler_process((Resampler*)state, in, n, out);
+}
+
+static size_t resample_flush(void* state, real_t* out) {
+    return resampler_flush((Resampler*)state, out);
+}
+
+static int resample_failed(void* state) {
+    return resampler_failed((Resampler*)state);
+}
+
+static size_t convolve_process(void* state, const real_t* in, size_t n, real_t* out) {
+    return convolver_process((Convolver*)state, in, n, out);
+}
+
+static size_t convolve_flush(void* state, real_t* out) {
+    return convolver_flush((Convolver*)state, out);
+}
+
+// Um bloco planar passando pelo estágio; cada canal pode rodar numa thread.
+typedef struct {
+    const StreamStage* stage;
+    const real_t* in;         // Canal c em in + c * STREAM_READ_BLOCK
+    real_t* out;              // Canal c em out + c * out_stride
+    size_t out_stride;
+    size_t n;                 // 0 = flush
+    size_t produced;          // Igual em todos os canais; gravado só pelo canal 0
+} StreamBlockPass;
+
+static void stream_block_channels(size_t begin, size_t end, void* ctx) {
+    StreamBlockPass* pass = (StreamBlockPass*)ctx;
+    for (size_t c = begin; c < end; c++) {
+        real_t* out = pass->out + c * pass->out_stride;
+        size_t produced;
+        if (pass->n > 0) {
+            produced = pass->stage->process(pass->stage->states[c], pass->in + c * STREAM_READ_BLOCK, pass->n, out);
+        } else {
+            produced = pass->stage->flush(pass->stage->states[c], out);
+        }
+        // Os canais rodam em threads diferentes: um só escritor evita a corrida.
+        if (c == 0) pass->produced = produced;
+    }
+}
+
+// Laço principal: leitor -> estágio -> escritor. A leitura e a gravação rodam
+// em threads próprias (pipeline.h), sobrepostas ao processamento, que fica nesta
+// thread e no pool. O bloco vazio do fim vira o flush do estágio.
+static int run_stream(WavReader* reader, const char* out_path, const StreamStage* stage) {
+    const WavData* info = wav_reader_info(reader);
+    uint32_t out_rate = stage->sample_rate ? stage->sample_rate : info->sample_rate;
+    WavWriter* writer = wav_writer_open(out_path, out_rate, info->num_channels,
+                                        info->format, info->bits_per_sample);
+    if (!writer) return -1;
+
+    size_t out_stride = STREAM_READ_BLOCK + stage->block_size;
+    PipelineReader* input = pipeline_reader_open(reader, STREAM_READ_BLOCK);
+    PipelineWriter* output = input ? pipeline_writer_open(writer, info->num_channels, out_stride) : NULL;
+    StreamBlockPass pass = { stage, NULL, NULL, out_stride, 0, 0 };
+    size_t frame_bytes = info->num_channels * sizeof(real_t);
+    int status = output ? 0 : -1;
+
+    while (status == 0) {
+        pass.n = pipeline_reader_next(input, &pass.in);
+        pass.out = pipeline_writer_buffer(output);
+        if (!pass.out) {
+            status = -1;
+            break;
+        }
+
+        TRACE_BEGIN(process_span, "stream_process");
+        parallel_for(info->num_channels, 1, stream_block_channels, &pass);
+        TRACE_END(process_span, pass.n * frame_bytes);
+
+        for (uint16_t c = 0; stage->failed && c < info->num_channels; c++) {
+            if (stage->failed(stage->states[c])) status = -1;
+        }
+        if (status != 0) break;
+        if (pipeline_writer_submit(output, pass.produced) != 0) status = -1;
+        if (pass.n == 0) break;
+    }
+
+    if (output && pipeline_writer_finish(output) != 0) status = -1;
+    pipeline_reader_close(input);
+    wav_writer_close(writer);
+    return status;
+}
+
+int stream_fft_filter_file(const char* in_path, const char* out_path, double cutoff_freq, int is_high_pass) {
+    WavReader* reader = wav_reader_open(in_path);
+    if (!reader) return -1;
+
+    const WavData* info = wav_reader_info(reader);
+    void** filters = (void**)calloc(info->num_channels, sizeof(void*));
+    int status = filters ? 0 : -1;
+    for (uint16_t c = 0; c < info->num_channels && status == 0; c++) {
+        filters[c] = fft_filter_stream_create(info->sample_rate, cutoff_freq, is_high_pass);
+        if (!filters[c]) status = -1;
+    }
+    if (status == 0) {
+        StreamStage stage = { filters, fft_process, fft_flush, fft_filter_stream_block_size(filters[0]), 0, NULL };
+        status = run_stream(reader, out_path, &stage);
+    }
+
+    for (uint16_t c = 0; filters && c < info->num_channels; c++) {
+        fft_filter_stream_destroy((FftFilterStream*)filters[c]);
+    }
+    free(filters);
+    wav_reader_close(reader);
+    return status;
+}
+
+int stream_sma_filter_file(const char* in_path, const char* out_path, int window_size) {
+    WavReader* reader = wav_reader_open(in_path);
+    if (!reader) return -1;
+
+    const WavData* info = wav_reader_info(reader);
+    void** filters = (void**)calloc(info->num_channels, sizeof(void*));
+    int status = filters ? 0 : -1;
+    for (uint16_t c = 0; c < info->num_channels && status == 0; c++) {
+        filters[c] = sma_stream_create(window_size);
+        if (!filters[c]) status = -1;
+    }
+    if (status == 0) {
+        StreamStage stage = { filters, sma_process, sma_flush, sma_stream_block_size(filters[0]), 0, NULL };
+        status = run_stream(reader, out_path, &stage);
+    }
+
+    for (uint16_t c = 0; filters && c < info->num_channels; c++) {
+        sma_stream_destroy((SmaStream*)filters[c]);
+    }
+    free(filters);
+    wav_reader_close(reader);
+    return status;
+}
+
+int stream_fir_filter_file(const char* in_path, const char* out_path, const FilterSpec* spec,
+                           size_t num_taps, WindowType window) {
+    WavReader* reader = wav_reader_open(in_path);
+    if (!reader) return -1;
+
+    const WavData* info = wav_reader_info(reader);
+    double* taps = fir_design(spec, info->sample_rate, num_taps, window);
+    if (!taps) {
+        wav_reader_close(reader);
+        return -1;
+    }
+
+    void** filters = (void**)calloc(info->num_channels, sizeof(void*));
+    int status = 0;
+    for (uint16_t c = 0; c < info->num_channels; c++) {
+        filters[c] = fir_filter_create(taps, num_taps);
+        if (!filters[c]) status = -1;
+    }
+    if (status == 0) {
+        StreamStage stage = { filters, fir_process, fir_flush, fir_filter_block_size(filters[0]), 0, NULL };
+        status = run_stream(reader, out_path, &stage);
+    }
+
+    for (uint16_t c = 0; c < info->num_channels; c++) {
+        fir_filter_destroy((FirFilter*)filters[c]);
+    }
+    free(filters);
+    free(taps);
+    wav_reader_close(reader);
+    return status;
+}
+
+int stream_iir_filter_file(const char* in_path, const char* out_path, const FilterSpec* spec, int order) {
+    WavReader* reader = wav_reader_open(in_path);
+    if (!reader) return -1;
+
+    const WavData* info = wav_reader_info(reader);
+    void** filters = (void**)calloc(info->num_channels, sizeof(void*));
+    int status = 0;
+    for (uint16_t c = 0; c < info->num_channels && status == 0; c++) {
+        filters[c] = iir_butterworth_create(spec, info->sample_rate, order);
+        if (!filters[c]) status = -1;
+    }
+    if (status == 0) {
+        StreamStage stage = { filters, iir_process, iir_flush, iir_filter_block_size(filters[0]), 0, NULL };
+        status = run_stream(reader, out_path, &stage);
+    }
+
+    for (uint16_t c = 0; c < info->num_channels; c++) {
+        iir_filter_destroy((IirFilter*)filters[c]);
+    }
+    free(filters);
+    wav_reader_close(reader);
+    return status;
+}
+
+int stream_resample_file(const char* in_path, const char* out_path, uint32_t sample_rate) {
+    WavReader* reader = wav_reader_open(in_path);
+    if (!reader) return -1;
+
+    const WavData* info = wav_reader_info(reader);
+    void** resamplers = (void**)calloc(info->num_channels, sizeof(void*));
+    int status = 0;
+    for (uint16_t c = 0; c < info->num_channels && status == 0; c++) {
+        resamplers[c] = resampler_create(info->sample_rate, sample_rate);
+        if (!resamplers[c]) status = -1;
+    }
+    if (status == 0) {
+        // Ao contrário dos filtros, a saída de um bloco pode ser maior que a entrada.
+        size_t max_output = resampler_max_output((Resampler*)resamplers[0], STREAM_READ_BLOCK);
+        size_t extra = (max_output > STREAM_READ_BLOCK) ? max_output - STREAM_READ_BLOCK : 0;
+        StreamStage stage = { resamplers, resample_process, resample_flush, extra, sample_rate, resample_failed };
+        status = run_stream(reader, out_path, &stage);
+    }
+
+    for (uint16_t c = 0; c < info->num_channels; c++) {
+        resampler_destroy((Resampler*)resamplers[c]);
+    }
+    free(resamplers);
+    wav_reader_close(reader);
+    return status;
+}
+
+int stream_convolve_file(const char* in_path, const char* impulse_path, const char* out_path) {
+    // A resposta ao impulso é o núcleo: fica inteira em memória.
+    WavData* impulse = read_wav_file(impulse_path);
+    if (!impulse) return -1;
+    WavReader* reader = wav_reader_open(in_path);
+    if (!reader) {
+        free_wav_data(impulse);
+        return -1;
+    }
+
+    const WavData* info = wav_reader_info(reader);
+    if (impulse->sample_rate != info->sample_rate) {
+        WavData* converted = resample_audio(impulse, info->sample_rate);
+        free_wav_data(impulse);
+        impulse = converted;
+    }
+    void** convolvers = (void**)calloc(info->num_channels, sizeof(void*));
+    int status = impulse ? 0 : -1;
+    for (uint16_t c = 0; c < info->num_channels && status == 0; c++) {
+        const real_t* h = wav_channel(impulse, (uint16_t)(c % impulse->num_channels));
+        convolvers[c] = convolver_create(h, impulse->num_samples, 0);
+        if (!convolvers[c]) status = -1;
+    }
+    if (status == 0) {
+        StreamStage stage = { convolvers, convolve_process, convolve_flush, convolver_block_size((Convolver*)convolvers[0]), 0, NULL };
+        status = run_stream(reader, out_path, &stage);
+    }
+
+    for (uint16_t c = 0; c < info->num_channels; c++) {
+        convolver_destroy((Convolver*)convolvers[c]);
+    }
+    free(convolvers);
+    free_wav_data(impulse);
+    wav_reader_close(reader);
+    return status;
+}
+
+// --- Medição de nível ---
+
+// Um bloco lido passando pelas estatísticas de cada canal (uma thread por canal).
+typedef struct {
+    MovingStats** stats;
+    const real_t* in;         // Canal c em in + c * STREAM_READ_BLOCK
+    real_t* results;          // Canal c: rms, min, max, envelope, cada um com STREAM_READ_BLOCK
+    size_t n;
+} MeterPass;
+
+static void meter_channels(size_t begin, size_t end, void* ctx) {
+    MeterPass* pass = (MeterPass*)ctx;
+    for (size_t c = begin; c < end; c++) {
+        real_t* base = pass->results + c * 4 * STREAM_READ_BLOCK;
+        MovingStatsOutput out = { NULL, base, base + STREAM_READ_BLOCK, base + 2 * STREAM_READ_BLOCK,
+                                  base + 3 * STREAM_READ_BLOCK };
+        moving_stats_process(pass->stats[c], pass->in + c * STREAM_READ_BLOCK, pass->n, &out);
+    }
+}
+
+static double to_dbfs(double value) {
+    return (value > 0.0) ? fmax(20.0 * log10(value), METER_FLOOR_DB) : METER_FLOOR_DB;
+}
+
+int stream_level_meter_file(const char* in_path, const char* out_path, double window_ms) {
+    WavReader* reader = wav_reader_open(in_path);
+    if (!reader) return -1;
+
+    const WavData* info = wav_reader_info(reader);
+    uint16_t num_channels = info->num_channels;
+    size_t window = (size_t)llround(window_ms / 1000.0 * info->sample_rate);
+    if (window < 1) {
+        fprintf(stderr, "Janela de medição inválida: %.3f ms.\n", window_ms);
+        wav_reader_close(reader);
+        return -1;
+    }
+    FILE* fp = fopen(out_path, "w");
+    if (!fp) {
+        perror("Erro ao criar o arquivo de níveis");
+        wav_reader_close(reader);
+        return -1;
+    }
+
+    MovingStatsConfig config = { MOVING_RMS | MOVING_MIN | MOVING_MAX | MOVING_ENVELOPE, window,
+                                 METER_ATTACK_S, METER_RELEASE_S, info->sample_rate };
+    MovingStats** stats = (MovingStats**)calloc(num_channels, sizeof(MovingStats*));
+    int status = 0;
+    for (uint16_t c = 0; c < num_channels && status == 0; c++) {
+        stats[c] = moving_stats_create(&config);
+        if (!stats[c]) status = -1;
+    }
+    PipelineReader* input = pipeline_reader_open(reader, STREAM_READ_BLOCK);
+    real_t* results = (real_t*)malloc((size_t)num_channels * 4 * STREAM_READ_BLOCK * sizeof(real_t));
+    double* max_rms = (double*)calloc(num_channels, sizeof(double));
+    double* max_peak = (double*)calloc(num_channels, sizeof(double));
+    if (!input || !results) status = -1;
+
+    fprintf(fp, "tempo_s");
+    for (uint16_t c = 0; c < num_channels; c++) {
+        fprintf(fp, ",canal%u_rms_dbfs,canal%u_pico_dbfs,canal%u_envelope_dbfs", c + 1, c + 1, c + 1);
+    }
+    fprintf(fp, "\n");
+
+    // Uma linha ao fim de cada janela completa (janelas sem sobreposição).
+    uint64_t position = 0;
+    MeterPass pass = { stats, NULL, results, 0 };
+    while (status == 0 && (pass.n = pipeline_reader_next(input, &pass.in)) > 0) {
+        parallel_for(num_channels, 1, meter_channels, &pass);
+        for (size_t i = 0; i < pass.n; i++) {
+            if ((position + i + 1) % window != 0) continue;
+            fprintf(fp, "%.6f", (double)(position + i + 1) / info->sample_rate);
+            for (uint16_t c = 0; c < num_channels; c++) {
+                const real_t* base = results + (size_t)c * 4 * STREAM_READ_BLOCK;
+                double rms = base[i];
+                double peak = fmax(fabs((double)base[STREAM_READ_BLOCK + i]), fabs((double)base[2 * STREAM_READ_BLOCK + i]));
+                if (rms > max_rms[c]) max_rms[c] = rms;
+                if (peak > max_peak[c]) max_peak[c] = peak;
+                fprintf(fp, ",%.2f,%.2f,%.2f", to_dbfs(rms), to_dbfs(peak), to_dbfs(base[3 * STREAM_READ_BLOCK + i]));
+            }
+            fprintf(fp, "\n");
+        }
+        position += pass.n;
+    }
+
+    if (status == 0) {
+        for (uint16_t c = 0; c < num_channels; c++) {
+            printf("  canal %u: RMS máximo %.2f dBFS, pico %.2f dBFS\n", c + 1, to_dbfs(max_rms[c]), to_dbfs(max_peak[c]));
+        }
+    }
+    for (uint16_t c = 0; c < num_channels; c++) {
+        moving_stats_destroy(stats[c]);
+    }
+    free(stats);
+    pipeline_reader_close(input);
+    free(results);
+    free(max_rms);
+    free(max_peak);
+    fclose(fp);
+    wav_reader_close(reader);
+    return status;
+}
@@ -0,0 +1,28 @@
+#ifndef PROJETO_AUDIO_STREAM_PROCESSING_H
+#define PROJETO_AUDIO_STREAM_PROCESSING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "filters.h"
+
+// Processamento arquivo-a-arquivo em blocos: lê, filtra e grava sem nunca
+// carregar o sinal inteiro, de modo que a memória usada independe da duração.
+// Retornam 0 em sucesso e -1 em erro.
+
+int stream_fft_filter_file(const char* in_path, const char* out_path, double cutoff_freq, int is_high_pass);
+int stream_sma_filter_file(const char* in_path, const char* out_path, int window_size);
+int stream_fir_filter_file(const char* in_path, const char* out_path, const FilterSpec* spec,
+                           size_t num_taps, WindowType window);
+int stream_iir_filter_file(const char* in_path, const char* out_path, const FilterSpec* spec, int order);
+// Converte para 'sample_rate' Hz (resampler.h).
+int stream_resample_file(const char* in_path, const char* out_path, uint32_t sample_rate);
+// Convolução com a resposta ao impulso de 'impulse_path' (carregada inteira;
+// ver convolve_audio em convolution.h): o sinal é que passa em blocos.
+int stream_convolve_file(const char* in_path, const char* impulse_path, const char* out_path);
+
+// Medição de nível (moving_stats.h): a cada 'window_ms' grava em 'out_path'
+// (CSV) o RMS e o pico da janela e o envelope de cada canal, em dBFS, e ao final
+// mostra o RMS máximo e o pico de cada canal. Memória constante, qualquer duração.
+int stream_level_meter_file(const char* in_path, const char* out_path, double window_ms);
+
+#endif //PROJETO_AUDIO_STREAM_PROCESSING_H
@@ -0,0 +1,159 @@
+#include "thread_pool.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct {
+    ParallelForFn fn;
+    void* ctx;
+    size_t count;
+    size_t chunk;          // Índices por pedaço
+    size_t num_chunks;
+    size_t next_chunk;     // Próximo pedaço livre (incremento atômico)
+    size_t done_chunks;    // Protegido por 'pool_lock'
+} ParallelJob;
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t work_done = PTHREAD_COND_INITIALIZER;
+
+static pthread_t* workers = NULL;
+static int num_workers = 0;         // Threads extras além da que chama
+static ParallelJob* current_job = NULL;
+static unsigned long job_generation = 0;
+static int active_workers = 0;      // Workers que ainda referenciam 'current_job'
+static int shutting_down = 0;
+
+// Marca threads que já estão dentro de um laço paralelo.
+static __thread int inside_parallel = 0;
+
+// Executa pedaços do trabalho até acabarem; retorna quantos executou.
+static size_t run_chunks(ParallelJob* job) {
+    size_t executed = 0;
+    for (;;) {
+        size_t c = __atomic_fetch_add(&job->next_chunk, 1, __ATOMIC_RELAXED);
+        if (c >= job->num_chunks) break;
+        size_t begin = c * job->chunk;
+        size_t end = begin + job->chunk;
+        if (end > job->count) end = job->count;
+        job->fn(begin, end, job->ctx);
+        executed++;
+    }
+    return executed;
+}
+
+static void* worker_main(void* arg) {
+    (void)arg;
+    inside_parallel = 1;
+    unsigned long seen_generation = 0;
+
+    pthread_mutex_lock(&pool_lock);
+    for (;;) {
+        while (!shutting_down && (current_job == NULL || job_generation == seen_generation)) {
+            pthread_cond_wait(&work_ready, &pool_lock);
+        }
+        if (shutting_down) break;
+
+        ParallelJob* job = current_job;
+        seen_generation = job_generation;
+        active_workers++;
+        pthread_mutex_unlock(&pool_lock);
+
+        size_t executed = run_chunks(job);
+
+        pthread_mutex_lock(&pool_lock);
+        job->done_chunks += executed;
+        active_workers--;
+        pthread_cond_signal(&work_done);
+    }
+    pthread_mutex_unlock(&pool_lock);
+    return NULL;
+}
+
+void thread_pool_init(int num_threads) {
+    thread_pool_shutdown();
+
+    if (num_threads <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = (cores > 0) ? (int)cores : 1;
+    }
+    if (num_threads <= 1) return;
+
+    workers = (pthread_t*)malloc((num_threads - 1) * sizeof(pthread_t));
+    shutting_down = 0;
+    for (int i = 0; i < num_threads - 1; i++) {
+        if (pthread_create(&workers[num_workers], NULL, worker_main, NULL) != 0) break;
+        num_workers++;
+    }
+}
+
+int thread_pool_size(void) {
+    return num_workers + 1;
+}
+
+void thread_pool_shutdown(void) {
+    if (!workers) return;
+
+    pthread_mutex_lock(&pool_lock);
+    shutting_down = 1;
+    pthread_cond_broadcast(&work_ready);
+    pthread_mutex_unlock(&pool_lock);
+
+    for (int i = 0; i < num_workers; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+    workers = NULL;
+    num_workers = 0;
+}
+
+void parallel_for(size_t count, size_t min_chunk, ParallelForFn fn, void* ctx) {
+    if (count == 0) return;
+    if (min_chunk == 0) min_chunk = 1;
+
+    size_t max_chunks = count / min_chunk;
+    size_t threads = (size_t)num_workers + 1;
+    if (num_workers == 0 || inside_parallel || max_chunks < 2) {
+        fn(0, count, ctx);
+        return;
+    }
+
+    // Só um laço paralelo por vez; quem chegar com o pool ocupado roda em série.
+    pthread_mutex_lock(&pool_lock);
+    if (current_job != NULL) {
+        pthread_mutex_unlock(&pool_lock);
+        fn(0, count, ctx);
+        return;
+    }
+
+    // Alguns pedaços a mais que threads equilibram a carga sem muito overhead.
+    size_t num_chunks = threads * 4;
+    if (num_chunks > max_chunks) num_chunks = max_chunks;
+    ParallelJob job = { fn, ctx, count, (count + num_chunks - 1) / num_chunks, 0, 0, 0 };
+    job.num_chunks = (count + job.chunk - 1) / job.chunk;
+
+    current_job = &job;
+    job_generation++;
+    pthread_cond_broadcast(&work_ready);
+    pthread_mutex_unlock(&pool_lock);
+
+    inside_parallel = 1;
+    size_t executed = run_chunks(&job);
+    inside_parallel = 0;
+
+    pthread_mutex_lock(&pool_lock);
+    job.done_chunks += executed;
+    while (job.done_chunks < job.num_chunks || active_workers > 0) {
+        pthread_cond_wait(&work_done, &pool_lock);
+    }
+    current_job = NULL;
+    pthread_mutex_unlock(&pool_lock);
+}
+
+void parallel_tasks(size_t count, ParallelForFn fn, void* ctx) {
+    if (count >= (size_t)thread_pool_size()) {
+        parallel_for(count, 1, fn, ctx);
+    } else {
+        fn(0, count, ctx);
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef PROJETO_AUDIO_THREAD_POOL_H
+#define PROJETO_AUDIO_THREAD_POOL_H
+
+#include <stddef.h>
+
+// Pool global de threads para os laços paralelos do projeto (FFT, filtros,
+// conversão de amostras). Por padrão há apenas 1 thread e tudo roda em série.
+
+// Define o número total de threads (incluindo a que chama). 0 = uma por núcleo.
+void thread_pool_init(int num_threads);
+int thread_pool_size(void);
+void thread_pool_shutdown(void);
+
+// Corpo de um laço paralelo: processa os índices [begin, end).
+typedef void (*ParallelForFn)(size_t begin, size_t end, void* ctx);
+
+// Divide [0, count) em pedaços contíguos de pelo menos 'min_chunk' índices e
+// os executa nas threads do pool, bloqueando até todos terminarem. Chamadas
+// aninhadas (de dentro de um laço paralelo) ou simultâneas rodam em série.
+void parallel_for(size_t count, size_t min_chunk, ParallelForFn fn, void* ctx);
+
+// Para poucas tarefas grandes (ex.: um canal de áudio cada) que já paralelizam
+// internamente: roda as tarefas em paralelo só se houver ao menos uma por thread;
+// caso contrário, roda uma de cada vez e cada uma usa o pool inteiro.
+void parallel_tasks(size_t count, ParallelForFn fn, void* ctx);
+
+#endif //PROJETO_AUDIO_THREAD_POOL_H
@@ -0,0 +1,177 @@
+#include "trace.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef PROJETO_AUDIO_TRACING
+
+// Um trecho concluído.
+typedef struct {
+    const char* name;
+    double start_us;
+    double duration_us;
+    uint64_t bytes;
+    uint64_t allocs;
+    uint64_t alloc_bytes;
+    int tid;
+} TraceEvent;
+
+int trace_active = 0;
+
+static double trace_origin_us = 0.0;
+static uint64_t alloc_count = 0;
+static uint64_t alloc_total = 0;
+
+// Os eventos chegam de qualquer thread do pool.
+static pthread_mutex_t event_lock = PTHREAD_MUTEX_INITIALIZER;
+static TraceEvent* events = NULL;
+static size_t num_events = 0;
+static size_t event_capacity = 0;
+
+// Índice pequeno e estável por thread, usado como "tid" no JSON.
+static __thread int thread_index = -1;
+static int next_thread_index = 0;
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+}
+
+int trace_enable(void) {
+    trace_origin_us = now_us();
+    trace_active = 1;
+    return 0;
+}
+
+TraceSpan trace_begin(const char* name) {
+    TraceSpan span = { name, -1.0, 0, 0 };
+    if (trace_active) {
+        span.allocs = __atomic_load_n(&alloc_count, __ATOMIC_RELAXED);
+        span.alloc_bytes = __atomic_load_n(&alloc_total, __ATOMIC_RELAXED);
+        span.start_us = now_us();
+    }
+    return span;
+}
+
+void trace_end(TraceSpan* span, uint64_t bytes) {
+    if (span->start_us < 0.0) return;
+    double end_us = now_us();
+    if (thread_index < 0) {
+        thread_index = __atomic_fetch_add(&next_thread_index, 1, __ATOMIC_RELAXED);
+    }
+
+    // As alocações são contadas no processo todo: com threads, um trecho
+    // também vê as feitas em paralelo por outras.
+    TraceEvent event = {
+        span->name, span->start_us - trace_origin_us, end_us - span->start_us, bytes,
+        __atomic_load_n(&alloc_count, __ATOMIC_RELAXED) - span->allocs,
+        __atomic_load_n(&alloc_total, __ATOMIC_RELAXED) - span->alloc_bytes,
+        thread_index
+    };
+
+    pthread_mutex_lock(&event_lock);
+    if (num_events == event_capacity) {
+        size_t capacity = event_capacity ? 2 * event_capacity : 1024;
+        TraceEvent* grown = (TraceEvent*)realloc(events, capacity * sizeof(TraceEvent));
+        if (!grown) {
+            pthread_mutex_unlock(&event_lock);
+            return;
+        }
+        events = grown;
+        event_capacity = capacity;
+    }
+    events[num_events++] = event;
+    pthread_mutex_unlock(&event_lock);
+}
+
+void trace_count_alloc(size_t bytes) {
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&alloc_total, (uint64_t)bytes, __ATOMIC_RELAXED);
+}
+
+// Totais de uma etapa (todos os eventos de mesmo nome).
+typedef struct {
+    const char* name;
+    size_t calls;
+    double total_us;
+    uint64_t bytes;
+    uint64_t allocs;
+    uint64_t alloc_bytes;
+} TraceStage;
+
+void trace_print_summary(FILE* fp) {
+    pthread_mutex_lock(&event_lock);
+    TraceStage* stages = (TraceStage*)calloc(num_events ? num_events : 1, sizeof(TraceStage));
+    size_t num_stages = 0;
+    for (size_t i = 0; i < num_events; i++) {
+        size_t s = 0;
+        while (s < num_stages && strcmp(stages[s].name, events[i].name) != 0) s++;
+        if (s == num_stages) stages[num_stages++].name = events[i].name;
+        stages[s].calls++;
+        stages[s].total_us += events[i].duration_us;
+        stages[s].bytes += events[i].bytes;
+        stages[s].allocs += events[i].allocs;
+        stages[s].alloc_bytes += events[i].alloc_bytes;
+    }
+    pthread_mutex_unlock(&event_lock);
+
+    // Na ordem em que as etapas apareceram pela primeira vez.
+    fprintf(fp, "\n%-18s %8s %12s %10s %12s %8s %12s\n",
+            "etapa", "chamadas", "total (ms)", "média (ms)", "MB/s", "allocs", "alloc (KB)");
+    for (size_t s = 0; s < num_stages; s++) {
+        const TraceStage* st = &stages[s];
+        fprintf(fp, "%-18s %8zu %12.3f %10.3f ", st->name, st->calls, st->total_us * 1e-3,
+                st->total_us * 1e-3 / st->calls);
+        if (st->bytes > 0 && st->total_us > 0.0) {
+            fprintf(fp, "%12.1f", (double)st->bytes / st->total_us);
+        } else {
+            fprintf(fp, "%12s", "-");
+        }
+        fprintf(fp, " %8llu %12.1f\n", (unsigned long long)st->allocs, st->alloc_bytes / 1024.0);
+    }
+    free(stages);
+}
+
+int trace_write_chrome(const char* path) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) {
+        perror("Erro ao criar o arquivo de trace");
+        return -1;
+    }
+
+    pthread_mutex_lock(&event_lock);
+    fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    for (size_t i = 0; i < num_events; i++) {
+        const TraceEvent* e = &events[i];
+        fprintf(fp, "  {\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, "
+                    "\"args\": {\"bytes\": %llu, \"allocs\": %llu, \"alloc_bytes\": %llu}}%s\n",
+                e->name, e->tid, e->start_us, e->duration_us, (unsigned long long)e->bytes,
+                (unsigned long long)e->allocs, (unsigned long long)e->alloc_bytes,
+                i + 1 < num_events ? "," : "");
+    }
+    fprintf(fp, "]}\n");
+    pthread_mutex_unlock(&event_lock);
+
+    fclose(fp);
+    return 0;
+}
+
+#else
+
+int trace_enable(void) {
+    fprintf(stderr, "Instrumentação desativada nesta compilação (ative PROJETO_AUDIO_TRACING no CMake).\n");
+    return -1;
+}
+
+void trace_print_summary(FILE* fp) {
+    (void)fp;
+}
+
+int trace_write_chrome(const char* path) {
+    (void)path;
+    return -1;
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef PROJETO_AUDIO_TRACE_H
+#define PROJETO_AUDIO_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Instrumentação das etapas principais (leitura, FFT, filtros, escrita,
+// gráficos): tempo de parede, bytes processados e alocações de memória de
+// cada trecho marcado, com um resumo por etapa (--profile) ou um arquivo de
+// eventos no formato do Chrome (--trace, aberto em chrome://tracing ou Perfetto).
+//
+// Compilado sem PROJETO_AUDIO_TRACING (opção de mesmo nome no CMake), as macros
+// abaixo não geram código algum. Com ela, um trecho custa um teste de flag
+// enquanto a coleta não for ligada por trace_enable.
+//
+//     TRACE_BEGIN(span, "fft_forward");
+//     ...
+//     TRACE_END(span, bytes);
+
+#ifdef PROJETO_AUDIO_TRACING
+
+typedef struct {
+    const char* name;         // Literal: guardado sem cópia
+    double start_us;          // < 0 se a coleta estava desligada no início
+    uint64_t allocs;          // Contadores de alocação no início do trecho
+    uint64_t alloc_bytes;
+} TraceSpan;
+
+extern int trace_active;
+
+TraceSpan trace_begin(const char* name);
+void trace_end(TraceSpan* span, uint64_t bytes);
+// Registra uma alocação de 'bytes' feita no sistema (malloc, blocos da arena).
+void trace_count_alloc(size_t bytes);
+
+// Os testes ficam nas macros: com a coleta desligada, nenhuma chamada é feita.
+#define TRACE_BEGIN(var, name) \
+    TraceSpan var = trace_active ? trace_begin(name) : (TraceSpan){ (name), -1.0, 0, 0 }
+#define TRACE_END(var, bytes) \
+    do { if ((var).start_us >= 0.0) trace_end(&(var), (uint64_t)(bytes)); } while (0)
+#define TRACE_ALLOC(bytes) do { if (trace_active) trace_count_alloc(bytes); } while (0)
+
+#else
+
+// sizeof não avalia a expressão, mas evita avisos de variável sem uso.
+#define TRACE_BEGIN(var, name) do { } while (0)
+#define TRACE_END(var, bytes) do { (void)sizeof(bytes); } while (0)
+#define TRACE_ALLOC(bytes) do { (void)sizeof(bytes); } while (0)
+
+#endif
+
+// Disponíveis nos dois modos. Sem a instrumentação, trace_enable avisa e
+// retorna -1, e não há eventos para reportar.
+int trace_enable(void);
+// Resumo por etapa: chamadas, tempo total, vazão e alocações.
+void trace_print_summary(FILE* fp);
+// Grava os eventos em JSON do Chrome ("X", um por trecho). Retorna 0 ou -1.
+int trace_write_chrome(const char* path);
+
+#endif //PROJETO_AUDIO_TRACE_H
@@ -1,6 +1,15 @@
 #include "wav_handler.h"
+#include "thread_pool.h"
+#include "arena.h"
+#include "sample_convert.h"
+#include "trace.h"
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 // Estruturas para ler o cabeçalho do arquivo.
 // O atributo 'packed' garante que o compilador não adicione preenchimento,
@@ -25,136 +34,606 @@ typedef struct __attribute__((packed)) {
     uint16_t bits_per_sample;
 } FmtChunk;
 
-// Converte amostra de short 16-bit para double normalizado.
-static double short_to_double(int16_t s) {
-    return (double)s / 32768.0;
-}
+// Menor faixa de amostras convertida por thread.
+#define CONVERSION_MIN_CHUNK 65536
+// Valores (quadros x canais) por bloco de (des)intercalamento: cabe no cache L1/L2.
+#define CONVERSION_TILE_VALUES 4096
+// Quadros por bloco em write_wav_file: vários CONVERSION_MIN_CHUNK, para que a
+// conversão de cada bloco ainda se divida entre as threads.
+#define WRITE_TILE_FRAMES (16 * CONVERSION_MIN_CHUNK)
+
+// Formato de saída configurado por wav_set_output_options.
+static WavOutputOptions output_options = { 0, 0, 0 };
+
+// Contexto dos laços de conversão, divididos entre as threads do pool.
+// 'raw' é intercalado (quadro a quadro), no formato do arquivo; 'samples' é
+// planar, com o canal c começando em samples + c * stride.
+typedef struct {
+    uint8_t* raw;
+    real_t* samples;
+    size_t stride;
+    uint16_t num_channels;
+    SampleFormat format;
+    int dither;               // Só na escrita, e só para formatos inteiros
+    uint64_t first_frame;     // Posição de raw[0] no arquivo (semente do dither)
+    int failed;               // Faltou memória para o bloco de (des)intercalamento
+} ConversionPass;
 
-// Converte double normalizado para short 16-bit, com clipping.
-static int16_t double_to_short(double d) {
-    d *= 32767.0;
-    if (d > 32767.0) d = 32767.0;
-    if (d < -32768.0) d = -32768.0;
-    return (int16_t)d;
+// Ruído TPDF em LSBs, em (-1, 1): diferença de duas uniformes tiradas de um
+// hash (splitmix64) do índice global da amostra. Por depender só do índice, o
+// resultado não muda com o número de threads nem com o tamanho dos blocos.
+static double tpdf_noise(uint64_t index) {
+    uint64_t z = (index + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    double u1 = (double)(z >> 32) * (1.0 / 4294967296.0);
+    double u2 = (double)(z & 0xFFFFFFFFULL) * (1.0 / 4294967296.0);
+    return u1 - u2;
 }
 
-WavData* read_wav_file(const char* filename) {
-    FILE* fp = fopen(filename, "rb");
-    if (!fp) {
-        perror("Erro ao abrir arquivo de entrada");
-        return NULL;
+// Arquivos mono são convertidos direto entre os buffers; com mais canais, a
+// conversão vetorial roda sobre um bloco intercalado de doubles e só o
+// (des)intercalamento é feito amostra a amostra, dentro do cache. Com real_t
+// float, todos passam pelo bloco, que também faz o estreitamento para float.
+static void convert_from_raw(size_t begin, size_t end, void* ctx) {
+    ConversionPass* pass = (ConversionPass*)ctx;
+    SampleToDoubleFn to_double = sample_convert_kernels()->to_double[pass->format];
+    size_t bytes = sample_format_bytes(pass->format);
+    size_t num_channels = pass->num_channels;
+
+#ifndef PROJETO_AUDIO_SINGLE_PRECISION
+    if (num_channels == 1) {
+        to_double(pass->raw + begin * bytes, pass->samples + begin, end - begin);
+        return;
     }
+#endif
 
-    RiffHeader riff_header;
-    fread(&riff_header, sizeof(RiffHeader), 1, fp);
-    if (strncmp(riff_header.riff, "RIFF", 4) != 0 || strncmp(riff_header.wave, "WAVE", 4) != 0) {
-        fprintf(stderr, "Arquivo de entrada não é um WAV válido.\n");
-        fclose(fp);
-        return NULL;
+    size_t tile = CONVERSION_TILE_VALUES / num_channels;
+    if (tile == 0) tile = 1;
+    ArenaMark mark = arena_mark();
+    double* values = (double*)arena_alloc(tile * num_channels * sizeof(double));
+    if (!values) {
+        pass->failed = 1;
+        arena_release(mark);
+        return;
+    }
+    for (size_t frame = begin; frame < end; frame += tile) {
+        size_t n = (end - frame < tile) ? end - frame : tile;
+        to_double(pass->raw + frame * num_channels * bytes, values, n * num_channels);
+        for (size_t c = 0; c < num_channels; c++) {
+            real_t* channel = pass->samples + c * pass->stride + frame;
+            for (size_t i = 0; i < n; i++) {
+                channel[i] = values[i * num_channels + c];
+            }
+        }
     }
+    arena_release(mark);
+}
 
-    WavData* wav_data = (WavData*)calloc(1, sizeof(WavData));
-    ChunkHeader chunk_header;
-    FmtChunk fmt_chunk;
+static void convert_to_raw(size_t begin, size_t end, void* ctx) {
+    ConversionPass* pass = (ConversionPass*)ctx;
+    DoubleToSampleFn from_double = sample_convert_kernels()->from_double[pass->format];
+    size_t bytes = sample_format_bytes(pass->format);
+    size_t num_channels = pass->num_channels;
 
-    // Procura pelo chunk "fmt "
-    while (fread(&chunk_header, sizeof(ChunkHeader), 1, fp) == 1) {
-        if (strncmp(chunk_header.id, "fmt ", 4) == 0) {
-            fread(&fmt_chunk, sizeof(FmtChunk), 1, fp);
-            wav_data->sample_rate = fmt_chunk.sample_rate;
-            wav_data->num_channels = fmt_chunk.num_channels;
-            wav_data->bits_per_sample = fmt_chunk.bits_per_sample;
-            if (chunk_header.size > sizeof(FmtChunk)) {
-                fseek(fp, chunk_header.size - sizeof(FmtChunk), SEEK_CUR);
+#ifndef PROJETO_AUDIO_SINGLE_PRECISION
+    if (num_channels == 1 && !pass->dither) {
+        from_double(pass->samples + begin, pass->raw + begin * bytes, end - begin);
+        return;
+    }
+#endif
+
+    // Com dither, nos formatos que truncam, meio LSB na direção do sinal faz o
+    // truncamento dos kernels arredondar para o mais próximo.
+    double lsb = pass->dither ? 1.0 / sample_format_scale(pass->format) : 0.0;
+    double half_lsb = sample_format_rounds(pass->format) ? 0.0 : 0.5 * lsb;
+    size_t tile = CONVERSION_TILE_VALUES / num_channels;
+    if (tile == 0) tile = 1;
+    ArenaMark mark = arena_mark();
+    double* values = (double*)arena_alloc(tile * num_channels * sizeof(double));
+    if (!values) {
+        pass->failed = 1;
+        arena_release(mark);
+        return;
+    }
+    for (size_t frame = begin; frame < end; frame += tile) {
+        size_t n = (end - frame < tile) ? end - frame : tile;
+        for (size_t c = 0; c < num_channels; c++) {
+            const real_t* channel = pass->samples + c * pass->stride + frame;
+            if (pass->dither) {
+                uint64_t index = (pass->first_frame + frame) * num_channels + c;
+                for (size_t i = 0; i < n; i++) {
+                    double v = channel[i] + tpdf_noise(index + i * num_channels) * lsb;
+                    values[i * num_channels + c] = v + copysign(half_lsb, v);
+                }
+            } else {
+                for (size_t i = 0; i < n; i++) {
+                    values[i * num_channels + c] = channel[i];
+                }
             }
-        } else if (strncmp(chunk_header.id, "data", 4) == 0) {
-            wav_data->data_size = chunk_header.size;
-            break; // Encontrou o chunk de dados, para de procurar.
-        } else {
-            // Pula chunks desconhecidos
-            fseek(fp, chunk_header.size, SEEK_CUR);
+        }
+        from_double(values, pass->raw + frame * num_channels * bytes, n * num_channels);
+    }
+    arena_release(mark);
+}
+
+int wav_set_output_options(const WavOutputOptions* options) {
+    SampleFormat format;
+    if ((options->format || options->bits_per_sample) &&
+        sample_format_from_wav(options->format ? options->format : WAV_FORMAT_PCM,
+                               options->bits_per_sample ? options->bits_per_sample : 16, &format) != 0) {
+        fprintf(stderr, "Formato de saída não suportado.\n");
+        return -1;
+    }
+    output_options = *options;
+    return 0;
+}
+
+// Formato efetivo de saída para um sinal com os metadados dados.
+static void resolve_output_format(uint16_t* format_tag, uint16_t* bits_per_sample) {
+    if (output_options.format) *format_tag = output_options.format;
+    if (output_options.bits_per_sample) *bits_per_sample = output_options.bits_per_sample;
+    SampleFormat format;
+    if (sample_format_from_wav(*format_tag, *bits_per_sample, &format) != 0) {
+        // Combinação inválida (ex.: float pedido para um sinal de 16 bits): usa o padrão do formato.
+        *bits_per_sample = (*format_tag == WAV_FORMAT_IEEE_FLOAT) ? 32 : 16;
+    }
+}
+
+// Preenche um ConversionPass de escrita para o formato já resolvido.
+static ConversionPass output_pass(uint8_t* raw, const real_t* samples, size_t stride, uint16_t num_channels,
+                                  uint16_t format_tag, uint16_t bits_per_sample, uint64_t first_frame) {
+    ConversionPass pass = { raw, (real_t*)samples, stride, num_channels, SAMPLE_INT16, 0, first_frame, 0 };
+    sample_format_from_wav(format_tag, bits_per_sample, &pass.format);
+    pass.dither = output_options.dither && sample_format_scale(pass.format) > 0.0;
+    return pass;
+}
+
+// Lê o chunk "fmt " (com 'size' bytes em 'fmt'), resolvendo WAVE_FORMAT_EXTENSIBLE
+// pelo código do subformato, nos dois primeiros bytes do GUID.
+static void read_fmt_chunk(const uint8_t* fmt, size_t size, WavData* wav_data) {
+    FmtChunk fmt_chunk;
+    memcpy(&fmt_chunk, fmt, sizeof(FmtChunk));
+    wav_data->sample_rate = fmt_chunk.sample_rate;
+    wav_data->num_channels = fmt_chunk.num_channels;
+    wav_data->bits_per_sample = fmt_chunk.bits_per_sample;
+    wav_data->format = fmt_chunk.format_type;
+    if (fmt_chunk.format_type == WAV_FORMAT_EXTENSIBLE) {
+        // cbSize (2), bits válidos (2), máscara de canais (4), GUID (16).
+        wav_data->format = 0;
+        if (size >= sizeof(FmtChunk) + 10) {
+            memcpy(&wav_data->format, fmt + sizeof(FmtChunk) + 8, sizeof(uint16_t));
         }
     }
+}
 
+// Confere os metadados já preenchidos e calcula o número de amostras por canal.
+static int validate_wav_header(WavData* wav_data) {
     if (wav_data->data_size == 0) {
         fprintf(stderr, "Chunk 'data' não encontrado ou vazio.\n");
-        fclose(fp);
-        free(wav_data);
-        return NULL;
+        return -1;
     }
 
-    if (wav_data->bits_per_sample != 16) {
-        fprintf(stderr, "Este programa suporta apenas arquivos WAV PCM de 16 bits.\n");
-        fclose(fp);
-        free(wav_data);
-        return NULL;
+    SampleFormat format;
+    if (sample_format_from_wav(wav_data->format, wav_data->bits_per_sample, &format) != 0 ||
+        wav_data->num_channels == 0) {
+        fprintf(stderr, "Formato não suportado (código %u, %u bits): use PCM de 16, 24 ou 32 bits ou float de 32 bits.\n",
+                wav_data->format, wav_data->bits_per_sample);
+        return -1;
     }
 
     uint32_t num_total_samples = wav_data->data_size / (wav_data->bits_per_sample / 8);
     wav_data->num_samples = num_total_samples / wav_data->num_channels;
-    int16_t* raw_data = (int16_t*)malloc(wav_data->data_size);
-    fread(raw_data, wav_data->data_size, 1, fp);
+    return 0;
+}
 
-    // Aloca e preenche o buffer de doubles normalizados
-    // Este projeto simplifica para MONO, pegando apenas o primeiro canal se for estéreo.
-    wav_data->data_double = (double*)malloc(wav_data->num_samples * sizeof(double));
-    for (uint32_t i = 0; i < wav_data->num_samples; i++) {
-        wav_data->data_double[i] = short_to_double(raw_data[i * wav_data->num_channels]);
+// Lê o cabeçalho RIFF e percorre os chunks até o início do chunk "data".
+// Ao retornar 0, 'fp' está posicionado no primeiro byte das amostras.
+static int parse_wav_header(FILE* fp, WavData* wav_data) {
+    RiffHeader riff_header;
+    if (fread(&riff_header, sizeof(RiffHeader), 1, fp) != 1 ||
+        strncmp(riff_header.riff, "RIFF", 4) != 0 || strncmp(riff_header.wave, "WAVE", 4) != 0) {
+        fprintf(stderr, "Arquivo de entrada não é um WAV válido.\n");
+        return -1;
     }
-    // Se for estéreo, o segundo canal (raw_data[i * num_channels + 1]) é ignorado.
 
-    free(raw_data);
-    fclose(fp);
-    return wav_data;
+    ChunkHeader chunk_header;
+    uint8_t fmt[64];
+
+    // Procura pelo chunk "fmt "
+    while (fread(&chunk_header, sizeof(ChunkHeader), 1, fp) == 1) {
+        // Chunks RIFF são alinhados em 2 bytes.
+        long padded_size = (long)chunk_header.size + (chunk_header.size & 1);
+        if (strncmp(chunk_header.id, "fmt ", 4) == 0 && chunk_header.size >= sizeof(FmtChunk)) {
+            size_t fmt_size = (chunk_header.size < sizeof(fmt)) ? chunk_header.size : sizeof(fmt);
+            if (fread(fmt, fmt_size, 1, fp) != 1) break;
+            read_fmt_chunk(fmt, fmt_size, wav_data);
+            fseek(fp, padded_size - (long)fmt_size, SEEK_CUR);
+        } else if (strncmp(chunk_header.id, "data", 4) == 0) {
+            wav_data->data_size = chunk_header.size;
+            break; // Encontrou o chunk de dados, para de procurar.
+        } else {
+            // Pula chunks desconhecidos
+            fseek(fp, padded_size, SEEK_CUR);
+        }
+    }
+
+    return validate_wav_header(wav_data);
 }
 
-void write_wav_file(const char* filename, const WavData* data) {
-    FILE* fp = fopen(filename, "wb");
-    if (!fp) {
-        perror("Erro ao criar arquivo de saída");
-        return;
+// Como parse_wav_header, mas para um arquivo mapeado em memória: os chunks são
+// percorridos diretamente nos bytes do arquivo, sem cópia. Ao retornar 0,
+// '*data_offset' é a posição das amostras a partir do início do arquivo.
+static int parse_wav_chunks(const uint8_t* bytes, size_t size, WavData* wav_data, size_t* data_offset) {
+    const RiffHeader* riff_header = (const RiffHeader*)bytes;
+    if (size < sizeof(RiffHeader) ||
+        strncmp(riff_header->riff, "RIFF", 4) != 0 || strncmp(riff_header->wave, "WAVE", 4) != 0) {
+        fprintf(stderr, "Arquivo de entrada não é um WAV válido.\n");
+        return -1;
     }
 
-    // Prepara os dados brutos a partir dos doubles
-    uint32_t num_total_samples = data->num_samples * data->num_channels;
-    uint32_t data_size = num_total_samples * (data->bits_per_sample / 8);
-    int16_t* raw_data = (int16_t*)malloc(data_size);
-    for (uint32_t i = 0; i < data->num_samples; i++) {
-        int16_t sample = double_to_short(data->data_double[i]);
-        for (uint16_t j = 0; j < data->num_channels; j++) {
-            raw_data[i * data->num_channels + j] = sample; // Escreve o mesmo dado em todos os canais
+    size_t pos = sizeof(RiffHeader);
+    while (pos + sizeof(ChunkHeader) <= size) {
+        const ChunkHeader* chunk_header = (const ChunkHeader*)(bytes + pos);
+        pos += sizeof(ChunkHeader);
+        if (strncmp(chunk_header->id, "fmt ", 4) == 0 && chunk_header->size >= sizeof(FmtChunk) &&
+            pos + chunk_header->size <= size) {
+            read_fmt_chunk(bytes + pos, chunk_header->size, wav_data);
+        } else if (strncmp(chunk_header->id, "data", 4) == 0) {
+            // Arquivos truncados: considera apenas os bytes que existem de fato.
+            size_t available = size - pos;
+            wav_data->data_size = (chunk_header->size < available) ? chunk_header->size : (uint32_t)available;
+            *data_offset = pos;
+            break;
         }
+        // Chunks RIFF são alinhados em 2 bytes.
+        pos += chunk_header->size + (chunk_header->size & 1);
     }
 
-    // Escreve o cabeçalho
+    return validate_wav_header(wav_data);
+}
+
+// Escreve o cabeçalho canônico de 44 bytes (RIFF + fmt + data).
+static void write_wav_header(FILE* fp, uint32_t sample_rate, uint16_t num_channels,
+                             uint16_t format, uint16_t bits_per_sample, uint32_t data_size) {
     RiffHeader riff_header = { {'R', 'I', 'F', 'F'}, 36 + data_size, {'W', 'A', 'V', 'E'} };
     fwrite(&riff_header, sizeof(RiffHeader), 1, fp);
 
     ChunkHeader fmt_header = { {'f', 'm', 't', ' '}, 16 };
     FmtChunk fmt_chunk = {
-        1, // PCM
-        data->num_channels,
-        data->sample_rate,
-        data->sample_rate * data->num_channels * (data->bits_per_sample / 8),
-        data->num_channels * (data->bits_per_sample / 8),
-        data->bits_per_sample
+        format,
+        num_channels,
+        sample_rate,
+        sample_rate * num_channels * (bits_per_sample / 8),
+        num_channels * (bits_per_sample / 8),
+        bits_per_sample
     };
     fwrite(&fmt_header, sizeof(ChunkHeader), 1, fp);
     fwrite(&fmt_chunk, sizeof(FmtChunk), 1, fp);
 
     ChunkHeader data_header = { {'d', 'a', 't', 'a'}, data_size };
     fwrite(&data_header, sizeof(ChunkHeader), 1, fp);
+}
+
+WavData* read_wav_file(const char* filename) {
+    TRACE_BEGIN(span, "wav_read");
+    WavMap* map = wav_map_open(filename);
+    if (!map) return NULL;
+
+    // Conversão direta das páginas mapeadas para as amostras, sem buffer intermediário.
+    wav_map_advise_sequential(map);
+    WavData* wav_data = wav_map_load(map, 0, wav_map_info(map)->num_samples);
+    wav_map_close(map);
+    TRACE_END(span, wav_data ? wav_data->data_size : 0);
+    return wav_data;
+}
+
+int write_wav_file(const char* filename, const WavData* data) {
+    TRACE_BEGIN(span, "wav_write");
+    FILE* fp = fopen(filename, "wb");
+    if (!fp) {
+        perror("Erro ao criar arquivo de saída");
+        return -1;
+    }
+
+    uint16_t format = data->format;
+    uint16_t bits_per_sample = data->bits_per_sample;
+    resolve_output_format(&format, &bits_per_sample);
+
+    // Converte e grava em blocos de WRITE_TILE_FRAMES quadros, num buffer da arena:
+    // a arena guarda o maior bloco pedido enquanto a thread viver, então o buffer
+    // tem tamanho fixo em vez de acompanhar o tamanho do arquivo.
+    size_t frame_bytes = data->num_channels * (bits_per_sample / 8);
+    uint32_t data_size = (uint32_t)(data->num_samples * frame_bytes);
+    size_t tile = (data->num_samples < WRITE_TILE_FRAMES) ? data->num_samples : WRITE_TILE_FRAMES;
+    ArenaMark mark = arena_mark();
+    uint8_t* raw_data = (uint8_t*)arena_alloc(tile * frame_bytes);
+    if (!raw_data) {
+        fprintf(stderr, "Memória insuficiente para o buffer de escrita.\n");
+        arena_release(mark);
+        fclose(fp);
+        return -1;
+    }
+
+    // Escreve o cabeçalho
+    write_wav_header(fp, data->sample_rate, data->num_channels, format, bits_per_sample, data_size);
 
     // Escreve os dados
-    fwrite(raw_data, data_size, 1, fp);
+    int status = 0;
+    for (size_t frame = 0; frame < data->num_samples && status == 0; frame += tile) {
+        size_t n = (data->num_samples - frame < tile) ? data->num_samples - frame : tile;
+        ConversionPass pass = output_pass(raw_data, data->samples + frame, data->num_samples, data->num_channels,
+                                          format, bits_per_sample, frame);
+        parallel_for(n, CONVERSION_MIN_CHUNK, convert_to_raw, &pass);
+        if (pass.failed) {
+            fprintf(stderr, "Memória insuficiente para a conversão das amostras.\n");
+            status = -1;
+        } else if (fwrite(raw_data, frame_bytes, n, fp) != n) {
+            perror("Erro ao escrever arquivo de saída");
+            status = -1;
+        }
+    }
 
-    free(raw_data);
-    fclose(fp);
+    arena_release(mark);
+    // Erros do cabeçalho (e os adiados pelo buffer do stdio) aparecem aqui.
+    int write_failed = ferror(fp);
+    if (fclose(fp) != 0) write_failed = 1;
+    if (write_failed && status == 0) perror("Erro ao escrever arquivo de saída");
+    if (write_failed) status = -1;
+    TRACE_END(span, data_size);
+    return status;
 }
 
 void free_wav_data(WavData* data) {
     if (data) {
-        free(data->data_double);
+        free(data->samples);
         free(data);
     }
-}
\ No newline at end of file
+}
+
+// --- Leitura mapeada em memória ---
+
+struct WavMap {
+    void* base;                 // Arquivo inteiro mapeado (somente leitura)
+    size_t length;
+    WavData info;               // Apenas metadados; 'samples' fica NULL
+    SampleFormat format;
+    const uint8_t* pcm;         // Amostras intercaladas dentro de 'base'
+};
+
+WavMap* wav_map_open(const char* filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("Erro ao abrir arquivo de entrada");
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        fprintf(stderr, "Arquivo de entrada vazio ou inacessível.\n");
+        close(fd);
+        return NULL;
+    }
+
+    void* base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // O mapeamento continua válido depois que o descritor é fechado.
+    close(fd);
+    if (base == MAP_FAILED) {
+        perror("Erro ao mapear arquivo de entrada");
+        return NULL;
+    }
+
+    WavMap* map = (WavMap*)calloc(1, sizeof(WavMap));
+    size_t data_offset = 0;
+    if (parse_wav_chunks((const uint8_t*)base, (size_t)st.st_size, &map->info, &data_offset) != 0) {
+        munmap(base, (size_t)st.st_size);
+        free(map);
+        return NULL;
+    }
+    map->base = base;
+    map->length = (size_t)st.st_size;
+    map->pcm = (const uint8_t*)base + data_offset;
+    sample_format_from_wav(map->info.format, map->info.bits_per_sample, &map->format);
+    return map;
+}
+
+const WavData* wav_map_info(const WavMap* map) {
+    return &map->info;
+}
+
+const void* wav_map_pcm(const WavMap* map) {
+    return map->pcm;
+}
+
+void wav_map_advise_sequential(const WavMap* map) {
+    madvise(map->base, map->length, MADV_SEQUENTIAL);
+}
+
+WavData* wav_map_load(const WavMap* map, size_t first_sample, size_t num_samples) {
+    if (first_sample > map->info.num_samples) first_sample = map->info.num_samples;
+    if (num_samples > map->info.num_samples - first_sample) {
+        num_samples = map->info.num_samples - first_sample;
+    }
+
+    WavData* wav_data = (WavData*)malloc(sizeof(WavData));
+    if (!wav_data) {
+        fprintf(stderr, "Memória insuficiente para as amostras.\n");
+        return NULL;
+    }
+    *wav_data = map->info;
+    wav_data->num_samples = (uint32_t)num_samples;
+    size_t frame_bytes = map->info.num_channels * sample_format_bytes(map->format);
+    wav_data->data_size = (uint32_t)(num_samples * frame_bytes);
+
+    // Aloca e preenche o buffer planar de amostras normalizadas (um canal após o outro).
+    // Só as páginas do trecho pedido são lidas do disco.
+    size_t num_values = num_samples * map->info.num_channels;
+    wav_data->samples = (real_t*)malloc((num_values ? num_values : 1) * sizeof(real_t));
+    if (!wav_data->samples) {
+        fprintf(stderr, "Memória insuficiente para as amostras.\n");
+        free(wav_data);
+        return NULL;
+    }
+    TRACE_ALLOC(num_values * sizeof(real_t));
+    ConversionPass pass = {
+        (uint8_t*)map->pcm + first_sample * frame_bytes,
+        wav_data->samples, num_samples, map->info.num_channels, map->format, 0, first_sample, 0
+    };
+    parallel_for(num_samples, CONVERSION_MIN_CHUNK, convert_from_raw, &pass);
+    if (pass.failed) {
+        fprintf(stderr, "Memória insuficiente para a conversão das amostras.\n");
+        free_wav_data(wav_data);
+        return NULL;
+    }
+    return wav_data;
+}
+
+void wav_map_close(WavMap* map) {
+    if (map) {
+        munmap(map->base, map->length);
+        free(map);
+    }
+}
+
+// --- Leitura e escrita em blocos (streaming) ---
+
+struct WavReader {
+    FILE* fp;
+    WavData info;               // Apenas metadados; 'samples' fica NULL
+    SampleFormat format;
+    uint32_t samples_read;      // Amostras por canal já entregues
+    uint8_t* raw_block;         // Buffer intercalado reaproveitado entre chamadas
+    size_t raw_capacity;        // Capacidade de 'raw_block' em amostras por canal
+};
+
+struct WavWriter {
+    FILE* fp;
+    uint32_t sample_rate;
+    uint16_t num_channels;
+    uint16_t format;
+    uint16_t bits_per_sample;
+    uint32_t samples_written;   // Amostras por canal já gravadas
+    uint8_t* raw_block;
+    size_t raw_capacity;
+};
+
+// Garante que o buffer intercalado comporte 'num_samples' quadros de 'frame_bytes' bytes.
+static int ensure_raw_capacity(uint8_t** block, size_t* capacity, size_t num_samples, size_t frame_bytes) {
+    if (*capacity >= num_samples) return 0;
+    uint8_t* grown = (uint8_t*)realloc(*block, num_samples * frame_bytes);
+    if (!grown) return -1;
+    *block = grown;
+    *capacity = num_samples;
+    return 0;
+}
+
+WavReader* wav_reader_open(const char* filename) {
+    FILE* fp = fopen(filename, "rb");
+    if (!fp) {
+        perror("Erro ao abrir arquivo de entrada");
+        return NULL;
+    }
+
+    WavReader* reader = (WavReader*)calloc(1, sizeof(WavReader));
+    if (parse_wav_header(fp, &reader->info) != 0) {
+        fclose(fp);
+        free(reader);
+        return NULL;
+    }
+    reader->fp = fp;
+    sample_format_from_wav(reader->info.format, reader->info.bits_per_sample, &reader->format);
+    return reader;
+}
+
+const WavData* wav_reader_info(const WavReader* reader) {
+    return &reader->info;
+}
+
+size_t wav_reader_read(WavReader* reader, real_t* out, size_t max_samples) {
+    uint32_t remaining = reader->info.num_samples - reader->samples_read;
+    size_t count = (max_samples < remaining) ? max_samples : remaining;
+    if (count == 0) return 0;
+
+    uint16_t num_channels = reader->info.num_channels;
+    size_t frame_bytes = num_channels * sample_format_bytes(reader->format);
+    if (ensure_raw_capacity(&reader->raw_block, &reader->raw_capacity, count, frame_bytes) != 0) {
+        fprintf(stderr, "Memória insuficiente para o bloco de leitura.\n");
+        return 0;
+    }
+    count = fread(reader->raw_block, frame_bytes, count, reader->fp);
+
+    ConversionPass pass = { reader->raw_block, out, max_samples, num_channels, reader->format, 0, reader->samples_read, 0 };
+    convert_from_raw(0, count, &pass);
+    if (pass.failed) {
+        fprintf(stderr, "Memória insuficiente para a conversão das amostras.\n");
+        return 0;
+    }
+    reader->samples_read += (uint32_t)count;
+    return count;
+}
+
+void wav_reader_close(WavReader* reader) {
+    if (reader) {
+        fclose(reader->fp);
+        free(reader->raw_block);
+        free(reader);
+    }
+}
+
+WavWriter* wav_writer_open(const char* filename, uint32_t sample_rate, uint16_t num_channels,
+                           uint16_t format, uint16_t bits_per_sample) {
+    FILE* fp = fopen(filename, "wb");
+    if (!fp) {
+        perror("Erro ao criar arquivo de saída");
+        return NULL;
+    }
+
+    WavWriter* writer = (WavWriter*)calloc(1, sizeof(WavWriter));
+    writer->fp = fp;
+    writer->sample_rate = sample_rate;
+    writer->num_channels = num_channels;
+    resolve_output_format(&format, &bits_per_sample);
+    writer->format = format;
+    writer->bits_per_sample = bits_per_sample;
+
+    // Cabeçalho provisório: os tamanhos são corrigidos em wav_writer_close.
+    write_wav_header(fp, sample_rate, num_channels, format, bits_per_sample, 0);
+    return writer;
+}
+
+int wav_writer_write(WavWriter* writer, const real_t* in, size_t stride, size_t num_samples) {
+    uint16_t num_channels = writer->num_channels;
+    size_t frame_bytes = num_channels * (writer->bits_per_sample / 8);
+    if (ensure_raw_capacity(&writer->raw_block, &writer->raw_capacity, num_samples, frame_bytes) != 0) {
+        fprintf(stderr, "Memória insuficiente para o bloco de escrita.\n");
+        return -1;
+    }
+
+    ConversionPass pass = output_pass(writer->raw_block, in, stride, num_channels,
+                                      writer->format, writer->bits_per_sample, writer->samples_written);
+    convert_to_raw(0, num_samples, &pass);
+    if (pass.failed) {
+        fprintf(stderr, "Memória insuficiente para a conversão das amostras.\n");
+        return -1;
+    }
+
+    if (fwrite(writer->raw_block, frame_bytes, num_samples, writer->fp) != num_samples) {
+        perror("Erro ao escrever bloco de áudio");
+        return -1;
+    }
+    writer->samples_written += (uint32_t)num_samples;
+    return 0;
+}
+
+void wav_writer_close(WavWriter* writer) {
+    if (!writer) return;
+
+    uint32_t data_size = writer->samples_written * writer->num_channels * (writer->bits_per_sample / 8);
+    fseek(writer->fp, 0, SEEK_SET);
+    write_wav_header(writer->fp, writer->sample_rate, writer->num_channels, writer->format, writer->bits_per_sample, data_size);
+
+    fclose(writer->fp);
+    free(writer->raw_block);
+    free(writer);
+}
@@ -2,27 +2,101 @@
 #define WAV_HANDLER_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include <stdio.h>
+#include "precision.h"
+
+// Códigos de formato do chunk "fmt ". WAVE_FORMAT_EXTENSIBLE é resolvido para
+// o subformato (PCM ou float) ao ler o cabeçalho.
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_IEEE_FLOAT 3
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
 
 // Estrutura para conter todos os dados e metadados de um arquivo WAV.
-// Suporta apenas PCM de 16 bits, mono ou estéreo.
+// Suporta PCM de 16, 24 e 32 bits e float de 32 bits, com qualquer número de canais.
 typedef struct {
     // --- Metadados do Cabeçalho ---
     uint32_t sample_rate;     // Taxa de amostragem (ex: 44100)
     uint16_t num_channels;    // Número de canais (1 para mono, 2 para estéreo)
     uint16_t bits_per_sample; // Bits por amostra (ex: 16)
+    uint16_t format;          // WAV_FORMAT_PCM ou WAV_FORMAT_IEEE_FLOAT
     uint32_t data_size;       // Tamanho total do chunk de dados em bytes
 
     // --- Dados de Áudio ---
     uint32_t num_samples;     // Número de amostras POR CANAL
-    double* data_double;      // Ponteiro para os dados de áudio normalizados para [-1.0, 1.0]
+    real_t* samples;          // Dados normalizados para [-1.0, 1.0], em layout planar:
+                              // num_samples amostras do canal 0, depois do canal 1, ...
 } WavData;
 
+// Ponteiro para as amostras do canal 'channel' dentro de 'samples'.
+static inline real_t* wav_channel(const WavData* data, uint16_t channel) {
+    return data->samples + (size_t)channel * data->num_samples;
+}
+
 WavData* read_wav_file(const char* filename);
 
 // A declaração aqui deve ser IGUAL à definição no .c, incluindo o 'const'.
-void write_wav_file(const char* filename, const WavData* data);
+// Retorna 0, ou -1 se o arquivo não pôde ser criado ou gravado por inteiro.
+int write_wav_file(const char* filename, const WavData* data);
 
 void free_wav_data(WavData* data);
 
+// Formato das amostras gravadas por write_wav_file e WavWriter. Por padrão a
+// saída repete o formato do sinal; 'format'/'bits_per_sample' diferentes de 0
+// forçam outro (ex.: float 32 -> PCM 16). Com 'dither', a quantização para
+// inteiros soma ruído TPDF de ±1 LSB e arredonda, em vez de truncar.
+typedef struct {
+    uint16_t format;
+    uint16_t bits_per_sample;
+    int dither;
+} WavOutputOptions;
+
+// Vale para todas as escritas seguintes (uma configuração por processo, como o pool).
+// Retorna -1 se o formato pedido não for suportado.
+int wav_set_output_options(const WavOutputOptions* options);
+
+// --- Leitura mapeada em memória ---
+// O arquivo é mapeado com mmap e os chunks RIFF são lidos no próprio mapeamento.
+// As amostras PCM ficam disponíveis como uma visão somente leitura, e a conversão
+// para real_t acontece sob demanda, apenas no trecho pedido: abrir um arquivo de
+// vários GB não lê nada além do cabeçalho.
+typedef struct WavMap WavMap;
+
+WavMap* wav_map_open(const char* filename);
+// Metadados do arquivo mapeado ('samples' é sempre NULL).
+const WavData* wav_map_info(const WavMap* map);
+// Amostras intercaladas, no formato do arquivo (ver wav_map_info), válidas até wav_map_close.
+const void* wav_map_pcm(const WavMap* map);
+// Indica ao kernel que o arquivo será lido por inteiro, em ordem (read-ahead).
+void wav_map_advise_sequential(const WavMap* map);
+// Converte as amostras [first_sample, first_sample + num_samples) de todos os
+// canais para um novo WavData (liberado com free_wav_data). O intervalo é
+// limitado ao fim do arquivo.
+WavData* wav_map_load(const WavMap* map, size_t first_sample, size_t num_samples);
+void wav_map_close(WavMap* map);
+
+// --- Leitura e escrita em blocos (streaming) ---
+// Permitem processar arquivos de qualquer duração com memória constante:
+// apenas um bloco de amostras fica em memória por vez.
+typedef struct WavReader WavReader;
+typedef struct WavWriter WavWriter;
+
+WavReader* wav_reader_open(const char* filename);
+// Metadados do arquivo aberto ('samples' é sempre NULL).
+const WavData* wav_reader_info(const WavReader* reader);
+// Lê até 'max_samples' amostras por canal para 'out', em layout planar: o canal c
+// fica em out + c * max_samples. Retorna quantas foram lidas por canal; 0 no fim.
+size_t wav_reader_read(WavReader* reader, real_t* out, size_t max_samples);
+void wav_reader_close(WavReader* reader);
+
+// 'format' e 'bits_per_sample' descrevem o sinal, como em WavData; as opções
+// de saída (wav_set_output_options) podem trocá-los.
+WavWriter* wav_writer_open(const char* filename, uint32_t sample_rate, uint16_t num_channels,
+                           uint16_t format, uint16_t bits_per_sample);
+// Converte e grava 'num_samples' amostras por canal, lidas em layout planar
+// (canal c em in + c * stride). Retorna 0 em sucesso.
+int wav_writer_write(WavWriter* writer, const real_t* in, size_t stride, size_t num_samples);
+// Corrige os tamanhos no cabeçalho e fecha o arquivo.
+void wav_writer_close(WavWriter* writer);
+
 #endif //WAV_HANDLER_H
\ No newline at end of file